@@ -0,0 +1,648 @@
+// Benchmarks of the numerical core without R
+//
+// Builds the models directly from Armadillo objects and times the same
+// routines as run_benchmarks.R, without the conversions and copies of the
+// R interface. Build and run from the root of the package source tree:
+//
+//   benchmarks/build_bench.sh
+//   _core_build/bench_core [output.csv] [quick]
+//
+// Results are written as a CSV file with one row per benchmark case,
+// containing the median and minimum elapsed times over the replications
+// (in seconds), and the number of heap allocations and allocated bytes per
+// replication. For the SDE model, column m is the discretization level L.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "bssm.h"
+#include "ugg_ssm.h"
+#include "mgg_ssm.h"
+#include "ung_ssm.h"
+#include "nlg_ssm.h"
+#include "sde_ssm.h"
+#include "milstein_functions.h"
+#include "mcmc.h"
+#include "ung_amcmc.h"
+
+// Counters of heap allocations. With glibc the malloc family is replaced, 
+// which catches both operator new (implemented with malloc) and the 
+// posix_memalign calls of Armadillo. Elsewhere only operator new is counted.
+std::atomic<unsigned long> n_allocs(0);
+std::atomic<unsigned long> n_bytes(0);
+
+inline void count_alloc(const std::size_t size) {
+  n_allocs.fetch_add(1, std::memory_order_relaxed);
+  n_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+#ifdef __GLIBC__
+
+extern "C" {
+
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t n, std::size_t size);
+void* __libc_realloc(void* ptr, std::size_t size);
+void* __libc_memalign(std::size_t alignment, std::size_t size);
+void __libc_free(void* ptr);
+
+void* malloc(std::size_t size) __THROW {
+  count_alloc(size);
+  return __libc_malloc(size);
+}
+
+void* calloc(std::size_t n, std::size_t size) __THROW {
+  count_alloc(n * size);
+  return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, std::size_t size) __THROW {
+  count_alloc(size);
+  return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) __THROW {
+  __libc_free(ptr);
+}
+
+void* memalign(std::size_t alignment, std::size_t size) __THROW {
+  count_alloc(size);
+  return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(std::size_t alignment, std::size_t size) __THROW {
+  count_alloc(size);
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, std::size_t alignment, std::size_t size) __THROW {
+  count_alloc(size);
+  *ptr = __libc_memalign(alignment, size);
+  return (*ptr || size == 0) ? 0 : ENOMEM;
+}
+
+}
+
+#else
+
+void* operator new(std::size_t size) {
+  count_alloc(size);
+  void* ptr = std::malloc(size ? size : 1);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  std::free(ptr);
+}
+
+#endif
+
+namespace {
+
+struct result {
+  std::string benchmark;
+  std::string model;
+  unsigned int n, m, p, nsim, reps;
+  double median_time, min_time;
+  // per replication
+  unsigned long allocs, bytes;
+};
+
+std::vector<result> results;
+
+template <class F>
+void bench(const std::string& name, const std::string& model, F fun,
+  const unsigned int n, const unsigned int m, const unsigned int p,
+  const unsigned int nsim, const unsigned int reps) {
+
+  fun(); // warm-up
+  std::vector<double> times(reps);
+  unsigned long allocs_start = n_allocs.load();
+  unsigned long bytes_start = n_bytes.load();
+  for (unsigned int i = 0; i < reps; i++) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    fun();
+    times[i] = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  }
+  // the allocations of the timing itself are negligible
+  unsigned long allocs = (n_allocs.load() - allocs_start) / reps;
+  unsigned long bytes = (n_bytes.load() - bytes_start) / reps;
+  std::sort(times.begin(), times.end());
+  result res = {name, model, n, m, p, nsim, reps, times[reps / 2], times[0],
+    allocs, bytes};
+  results.push_back(res);
+  std::fprintf(stderr, 
+    "%-20s %-10s n=%-5u m=%-3u p=%-3u nsim=%-5u %10.5f s %10lu allocs\n",
+    name.c_str(), model.c_str(), n, m, p, nsim, res.median_time, allocs);
+}
+
+// random walk states with m states and univariate observations
+ugg_ssm bench_gssm(const unsigned int n, const unsigned int m) {
+  arma::arma_rng::set_seed(1);
+  arma::mat alpha = arma::cumsum(0.1 * arma::randn(n, m));
+  arma::vec y = arma::sum(alpha, 1) / m + arma::randn(n);
+  arma::mat Z(m, 1);
+  Z.fill(1.0 / m);
+  arma::cube T(m, m, 1);
+  T.slice(0).eye();
+  arma::cube R(m, m, 1);
+  R.slice(0) = 0.1 * arma::eye(m, m);
+  // parameters are the standard deviations of the observation and
+  // state noise, with half-normal priors
+  arma::uvec H_ind(1, arma::fill::zeros);
+  arma::uvec R_ind = arma::regspace<arma::uvec>(0, m + 1, m * m - 1);
+  arma::vec theta(m + 1);
+  theta(0) = 1.0;
+  theta.tail(m).fill(0.1);
+  arma::mat prior_parameters(2, m + 1);
+  prior_parameters.row(0).fill(5.0);
+  return ugg_ssm(y, Z, arma::vec(1, arma::fill::ones), T, R,
+    arma::vec(m, arma::fill::zeros), 10.0 * arma::eye(m, m),
+    arma::mat(n, 0), arma::vec(0), arma::vec(1, arma::fill::zeros),
+    arma::mat(m, 1, arma::fill::zeros), 1, theta,
+    arma::uvec(m + 1, arma::fill::ones), prior_parameters,
+    arma::uvec(), H_ind, arma::uvec(), R_ind);
+}
+
+// multivariate observations of dimension p loading on m random walks
+mgg_ssm bench_mv_gssm(const unsigned int n, const unsigned int m,
+  const unsigned int p) {
+  arma::arma_rng::set_seed(1);
+  arma::mat alpha = arma::cumsum(0.1 * arma::randn(n, m));
+  arma::cube Z(p, m, 1);
+  Z.slice(0) = arma::randu(p, m);
+  arma::mat y = Z.slice(0) * alpha.t() + arma::randn(p, n);
+  arma::cube H(p, p, 1);
+  H.slice(0).eye();
+  arma::cube T(m, m, 1);
+  T.slice(0).eye();
+  arma::cube R(m, m, 1);
+  R.slice(0) = 0.1 * arma::eye(m, m);
+  return mgg_ssm(y, Z, H, T, R, arma::vec(m, arma::fill::zeros),
+    10.0 * arma::eye(m, m), arma::cube(n, 0, p), arma::mat(0, p),
+    arma::mat(p, 1, arma::fill::zeros), arma::mat(m, 1, arma::fill::zeros));
+}
+
+// basic structural model with level, slope and, if m > 2, a dummy seasonal 
+// component with period m - 1, built with the general constructor as the 
+// model-specific constructors are only available through R
+ugg_ssm bench_bsm(const unsigned int n, const unsigned int m) {
+  arma::arma_rng::set_seed(1);
+  unsigned int k = m > 2 ? 3 : 2;
+  arma::mat Z(m, 1, arma::fill::zeros);
+  Z(0, 0) = 1.0;
+  if (m > 2) Z(2, 0) = 1.0;
+  arma::cube T(m, m, 1, arma::fill::zeros);
+  T(0, 0, 0) = T(0, 1, 0) = T(1, 1, 0) = 1.0;
+  if (m > 2) {
+    T.slice(0).submat(2, 2, 2, m - 1).fill(-1.0);
+    for (unsigned int i = 3; i < m; i++) {
+      T(i, i - 1, 0) = 1.0;
+    }
+  }
+  arma::cube R(m, k, 1, arma::fill::zeros);
+  R(0, 0, 0) = 0.1;
+  R(1, 1, 0) = 0.01;
+  if (m > 2) R(2, 2, 0) = 0.1;
+  arma::vec seasonal = arma::sin(2.0 * M_PI * 
+    arma::regspace<arma::vec>(0, n - 1) / std::max(m - 1, 2u));
+  arma::vec y = arma::cumsum(0.1 * arma::randn(n)) + 
+    (m > 2 ? 1.0 : 0.0) * seasonal + arma::randn(n);
+  return ugg_ssm(y, Z, arma::vec(1, arma::fill::ones), T, R,
+    arma::vec(m, arma::fill::zeros), 10.0 * arma::eye(m, m),
+    arma::mat(n, 0), arma::vec(0), arma::vec(1, arma::fill::zeros),
+    arma::mat(m, 1, arma::fill::zeros), 1);
+}
+
+// stationary AR(1) signal observed with noise
+ugg_ssm bench_ar1(const unsigned int n) {
+  arma::arma_rng::set_seed(1);
+  arma::vec x(n);
+  x(0) = arma::randn() / std::sqrt(1.0 - 0.81);
+  for (unsigned int t = 1; t < n; t++) {
+    x(t) = 0.9 * x(t - 1) + arma::randn();
+  }
+  arma::vec y = x + arma::randn(n);
+  return ugg_ssm(y, arma::mat(1, 1, arma::fill::ones), 
+    arma::vec(1, arma::fill::ones), arma::cube(1, 1, 1).fill(0.9), 
+    arma::cube(1, 1, 1, arma::fill::ones), arma::vec(1, arma::fill::zeros), 
+    arma::mat(1, 1).fill(1.0 / (1.0 - 0.81)), arma::mat(n, 0), arma::vec(0), 
+    arma::vec(1, arma::fill::zeros), arma::mat(1, 1, arma::fill::zeros), 1);
+}
+
+// stochastic volatility model with sigma = 1 (distribution 0 of ung_ssm)
+ung_ssm bench_svm(const unsigned int n) {
+  arma::arma_rng::set_seed(1);
+  arma::vec x(n);
+  x(0) = 0.2 * arma::randn() / std::sqrt(1.0 - 0.95 * 0.95);
+  for (unsigned int t = 1; t < n; t++) {
+    x(t) = 0.95 * x(t - 1) + 0.2 * arma::randn();
+  }
+  arma::vec y = arma::exp(x / 2.0) % arma::randn(n);
+  return ung_ssm(y, arma::mat(1, 1, arma::fill::ones), 
+    arma::cube(1, 1, 1).fill(0.95), arma::cube(1, 1, 1).fill(0.2), 
+    arma::vec(1, arma::fill::zeros), 
+    arma::mat(1, 1).fill(0.04 / (1.0 - 0.95 * 0.95)), 1.0,
+    arma::vec(n, arma::fill::ones), 0, arma::mat(n, 0), arma::vec(0),
+    arma::vec(1, arma::fill::zeros), arma::mat(1, 1, arma::fill::zeros), 1);
+}
+
+// Poisson observations of a random walk
+ung_ssm bench_poisson(const unsigned int n) {
+  arma::arma_rng::set_seed(1);
+  arma::vec x = 1.0 + arma::cumsum(0.05 * arma::randn(n));
+  arma::vec y(n);
+  for (unsigned int t = 0; t < n; t++) {
+    // inversion of the Poisson distribution function
+    double u = arma::randu(), lambda = std::exp(x(t)), p = std::exp(-lambda),
+      cdf = p;
+    y(t) = 0;
+    while (u > cdf) {
+      y(t)++;
+      p *= lambda / y(t);
+      cdf += p;
+    }
+  }
+  arma::cube T(1, 1, 1, arma::fill::ones);
+  arma::cube R(1, 1, 1);
+  R.fill(0.05);
+  arma::mat prior_parameters(2, 1);
+  prior_parameters(0, 0) = 1.0;
+  return ung_ssm(y, arma::mat(1, 1, arma::fill::ones), T, R,
+    arma::vec(1, arma::fill::zeros), arma::mat(1, 1).fill(10.0), 1.0,
+    arma::vec(n, arma::fill::ones), 1, arma::mat(n, 0), arma::vec(0),
+    arma::vec(1, arma::fill::zeros), arma::mat(1, 1, arma::fill::zeros), 1,
+    false, arma::vec(1).fill(0.05), arma::uvec(1, arma::fill::ones),
+    prior_parameters, arma::uvec(), arma::uvec(), arma::uvec(1, arma::fill::zeros));
+}
+
+// logistic growth model of the growth_model vignette
+// known_params = (dT, K, a1_r, a1_p, P1_r, P1_p)
+
+arma::vec growth_Z(const unsigned int t, const arma::vec& alpha,
+  const arma::vec& theta, const arma::vec& known_params,
+  const arma::mat& known_tv_params) {
+  return alpha.row(1);
+}
+
+arma::mat growth_H(const unsigned int t, const arma::vec& alpha,
+  const arma::vec& theta, const arma::vec& known_params,
+  const arma::mat& known_tv_params) {
+  return arma::mat(1, 1).fill(theta(0));
+}
+
+arma::vec growth_T(const unsigned int t, const arma::vec& alpha,
+  const arma::vec& theta, const arma::vec& known_params,
+  const arma::mat& known_tv_params) {
+  double dT = known_params(0);
+  double k = known_params(1);
+  arma::vec alpha_new(2);
+  alpha_new(0) = alpha(0);
+  double r = std::exp(alpha(0)) / (1.0 + std::exp(alpha(0)));
+  alpha_new(1) = k * alpha(1) * std::exp(r * dT) /
+    (k + alpha(1) * (std::exp(r * dT) - 1));
+  return alpha_new;
+}
+
+arma::mat growth_R(const unsigned int t, const arma::vec& alpha,
+  const arma::vec& theta, const arma::vec& known_params,
+  const arma::mat& known_tv_params) {
+  arma::mat R(2, 2, arma::fill::zeros);
+  R(0, 0) = theta(1);
+  R(1, 1) = theta(2);
+  return R;
+}
+
+arma::mat growth_Z_gn(const unsigned int t, const arma::vec& alpha,
+  const arma::vec& theta, const arma::vec& known_params,
+  const arma::mat& known_tv_params) {
+  arma::mat Z_gn(1, 2, arma::fill::zeros);
+  Z_gn(0, 1) = 1.0;
+  return Z_gn;
+}
+
+arma::mat growth_T_gn(const unsigned int t, const arma::vec& alpha,
+  const arma::vec& theta, const arma::vec& known_params,
+  const arma::mat& known_tv_params) {
+  double dT = known_params(0);
+  double k = known_params(1);
+  double r = std::exp(alpha(0)) / (1.0 + std::exp(alpha(0)));
+  double tmp = std::exp(r * dT) / std::pow(k + alpha(1) * (std::exp(r * dT) - 1), 2);
+  arma::mat Tg(2, 2);
+  Tg(0, 0) = 1.0;
+  Tg(0, 1) = 0;
+  Tg(1, 0) = k * alpha(1) * dT * (k - alpha(1)) * tmp * r / (1 + std::exp(alpha(0)));
+  Tg(1, 1) = k * k * tmp;
+  return Tg;
+}
+
+arma::vec growth_a1(const arma::vec& theta, const arma::vec& known_params) {
+  arma::vec a1(2);
+  a1(0) = known_params(2);
+  a1(1) = known_params(3);
+  return a1;
+}
+
+arma::mat growth_P1(const arma::vec& theta, const arma::vec& known_params) {
+  arma::mat P1(2, 2, arma::fill::zeros);
+  P1(0, 0) = known_params(4);
+  P1(1, 1) = known_params(5);
+  return P1;
+}
+
+double growth_prior(const arma::vec& theta) {
+  if (arma::any(theta < 0)) {
+    return -std::numeric_limits<double>::infinity();
+  }
+  return -0.5 * arma::accu(arma::square(theta / 10.0));
+}
+
+// Ornstein-Uhlenbeck process dx = rho (nu - x) dt + sigma dW observed with 
+// Gaussian noise, theta = (rho, nu, sigma, sd_y)
+
+double ou_drift(const double x, const arma::vec& theta) {
+  return theta(0) * (theta(1) - x);
+}
+
+double ou_diffusion(const double x, const arma::vec& theta) {
+  return theta(2);
+}
+
+double ou_ddiffusion(const double x, const arma::vec& theta) {
+  return 0.0;
+}
+
+double ou_prior(const arma::vec& theta) {
+  return 0.0;
+}
+
+arma::vec ou_obs_density(const double y, const arma::vec& alpha, 
+  const arma::vec& theta) {
+  return -0.5 * arma::square((y - alpha) / theta(3)) - std::log(theta(3));
+}
+
+sde_ssm bench_sde(const unsigned int n) {
+  arma::arma_rng::set_seed(1);
+  arma::vec x(n);
+  x(0) = 1.0;
+  for (unsigned int t = 1; t < n; t++) {
+    x(t) = 1.0 + (x(t - 1) - 1.0) * std::exp(-0.5) + 
+      0.5 * std::sqrt(1.0 - std::exp(-1.0)) * arma::randn();
+  }
+  arma::vec y = x + 0.2 * arma::randn(n);
+  return sde_ssm(y, arma::vec({0.5, 1.0, 0.5, 0.2}), 1.0, false, 1, 
+    ou_drift, ou_diffusion, ou_ddiffusion, ou_prior, ou_obs_density);
+}
+
+nlg_ssm bench_growth(const unsigned int n) {
+  arma::arma_rng::set_seed(1);
+  double dT = 0.1;
+  arma::mat y(1, n);
+  for (unsigned int t = 0; t < n; t++) {
+    double tt = dT * (t + 1);
+    y(0, t) = 100.0 * 10.0 * std::exp(0.2 * tt) /
+      (100.0 + 10.0 * (std::exp(0.2 * tt) - 1)) + 5.0 * arma::randn();
+  }
+  arma::vec known_params = {dT, 100, 0.3, 5, 4, 10};
+  return nlg_ssm(y, growth_Z, growth_H, growth_T, growth_R, growth_Z_gn,
+    growth_T_gn, growth_a1, growth_P1, arma::vec({3, 0.5, 0.5}), growth_prior,
+    known_params, arma::mat(1, 1, arma::fill::ones), 2, 2,
+    arma::uvec(6, arma::fill::zeros), 1);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+
+  std::string output = argc > 1 ? argv[1] : "bssm_core_benchmarks.csv";
+  bool quick = argc > 2 && std::string(argv[2]) == "quick";
+
+  unsigned int n_reps = quick ? 3 : 10;
+  std::vector<unsigned int> ns = quick ? std::vector<unsigned int>({100, 500}) :
+    std::vector<unsigned int>({100, 1000, 5000});
+  std::vector<unsigned int> ms = quick ? std::vector<unsigned int>({2, 10}) :
+    std::vector<unsigned int>({2, 10, 50});
+  std::vector<unsigned int> ps = quick ? std::vector<unsigned int>({1, 5}) :
+    std::vector<unsigned int>({1, 5, 20});
+  std::vector<unsigned int> nsims = quick ? std::vector<unsigned int>({10, 100}) :
+    std::vector<unsigned int>({10, 100, 1000});
+  std::vector<unsigned int> Ls = quick ? std::vector<unsigned int>({2, 4}) :
+    std::vector<unsigned int>({2, 4, 6});
+  unsigned int n_iter = quick ? 1000 : 10000;
+
+  // Linear-Gaussian models
+
+  for (unsigned int n : ns) {
+    for (unsigned int m : ms) {
+      ugg_ssm model = bench_gssm(n, m);
+      bench("log_likelihood", "gssm", [&]() { model.log_likelihood(); },
+        n, m, 1, 0, n_reps);
+      bench("fast_smoother", "gssm", [&]() { model.fast_smoother(); },
+        n, m, 1, 0, n_reps);
+      for (unsigned int nsim : nsims) {
+        bench("simulate_states", "gssm",
+          [&]() { model.simulate_states(nsim); }, n, m, 1, nsim, n_reps);
+        bench("bsf_filter", "gssm", [&]() {
+          arma::cube alpha(m, n + 1, nsim);
+          arma::mat weights(nsim, n + 1);
+          arma::umat indices(nsim, n);
+          model.bsf_filter(nsim, alpha, weights, indices);
+        }, n, m, 1, nsim, n_reps);
+      }
+      for (unsigned int p : ps) {
+        mgg_ssm mv_model = bench_mv_gssm(n, m, p);
+        bench("log_likelihood", "mv_gssm", [&]() { mv_model.log_likelihood(); },
+          n, m, p, 0, n_reps);
+        bench("fast_smoother", "mv_gssm", [&]() { mv_model.fast_smoother(); },
+          n, m, p, 0, n_reps);
+      }
+      ugg_ssm bsm_model = bench_bsm(n, m);
+      bench("log_likelihood", "bsm", [&]() { bsm_model.log_likelihood(); },
+        n, m, 1, 0, n_reps);
+      bench("fast_smoother", "bsm", [&]() { bsm_model.fast_smoother(); },
+        n, m, 1, 0, n_reps);
+      for (unsigned int nsim : nsims) {
+        bench("simulate_states", "bsm",
+          [&]() { bsm_model.simulate_states(nsim); }, n, m, 1, nsim, n_reps);
+      }
+    }
+    ugg_ssm ar1_model = bench_ar1(n);
+    bench("log_likelihood", "ar1", [&]() { ar1_model.log_likelihood(); },
+      n, 1, 1, 0, n_reps);
+    bench("fast_smoother", "ar1", [&]() { ar1_model.fast_smoother(); },
+      n, 1, 1, 0, n_reps);
+    for (unsigned int nsim : nsims) {
+      bench("simulate_states", "ar1",
+        [&]() { ar1_model.simulate_states(nsim); }, n, 1, 1, nsim, n_reps);
+      bench("bsf_filter", "ar1", [&]() {
+        arma::cube alpha(1, n + 1, nsim);
+        arma::mat weights(nsim, n + 1);
+        arma::umat indices(nsim, n);
+        ar1_model.bsf_filter(nsim, alpha, weights, indices);
+      }, n, 1, 1, nsim, n_reps);
+    }
+  }
+
+  // Non-Gaussian models
+
+  for (unsigned int n : ns) {
+    ung_ssm model = bench_poisson(n);
+    arma::vec initial_mode = arma::log(model.y + 0.1);
+    bench("approximate", "poisson", [&]() {
+      arma::vec mode = initial_mode;
+      model.approximate(mode, 100, 1e-8);
+    }, n, 1, 1, 0, n_reps);
+    for (unsigned int nsim : nsims) {
+      bench("psi_filter", "poisson", [&]() {
+        arma::vec mode = initial_mode;
+        ugg_ssm approx_model = model.approximate(mode, 100, 1e-8);
+        double loglik = approx_model.log_likelihood();
+        arma::vec scales = model.scaling_factors(approx_model, mode);
+        arma::cube alpha(1, n + 1, nsim);
+        arma::mat weights(nsim, n + 1);
+        arma::umat indices(nsim, n);
+        model.psi_filter(approx_model, loglik, scales, nsim, alpha, weights,
+          indices);
+      }, n, 1, 1, nsim, n_reps);
+      bench("bsf_filter", "poisson", [&]() {
+        arma::cube alpha(1, n + 1, nsim);
+        arma::mat weights(nsim, n + 1);
+        arma::umat indices(nsim, n);
+        model.bsf_filter(nsim, alpha, weights, indices);
+      }, n, 1, 1, nsim, n_reps);
+    }
+  }
+
+  for (unsigned int n : ns) {
+    ung_ssm model = bench_svm(n);
+    arma::vec initial_mode = arma::log(arma::square(model.y) + 1e-4);
+    bench("approximate", "svm", [&]() {
+      arma::vec mode = initial_mode;
+      model.approximate(mode, 100, 1e-8);
+    }, n, 1, 1, 0, n_reps);
+    for (unsigned int nsim : nsims) {
+      bench("psi_filter", "svm", [&]() {
+        arma::vec mode = initial_mode;
+        ugg_ssm approx_model = model.approximate(mode, 100, 1e-8);
+        double loglik = approx_model.log_likelihood();
+        arma::vec scales = model.scaling_factors(approx_model, mode);
+        arma::cube alpha(1, n + 1, nsim);
+        arma::mat weights(nsim, n + 1);
+        arma::umat indices(nsim, n);
+        model.psi_filter(approx_model, loglik, scales, nsim, alpha, weights,
+          indices);
+      }, n, 1, 1, nsim, n_reps);
+      bench("bsf_filter", "svm", [&]() {
+        arma::cube alpha(1, n + 1, nsim);
+        arma::mat weights(nsim, n + 1);
+        arma::umat indices(nsim, n);
+        model.bsf_filter(nsim, alpha, weights, indices);
+      }, n, 1, 1, nsim, n_reps);
+    }
+  }
+
+  // SDE models, the time of the bootstrap filter is mostly spent in the 
+  // Milstein discretization of the state transitions
+
+  for (unsigned int n : ns) {
+    sde_ssm model = bench_sde(n);
+    for (unsigned int L : Ls) {
+      bench("milstein", "sde", [&]() {
+        for (unsigned int t = 0; t < n; t++) {
+          milstein(model.x0, L, 1.0, model.theta, ou_drift, ou_diffusion,
+            ou_ddiffusion, false, model.coarse_engine);
+        }
+      }, n, L, 1, 0, n_reps);
+      for (unsigned int nsim : nsims) {
+        bench("bsf_filter", "sde", [&]() {
+          arma::cube alpha(1, n + 1, nsim);
+          arma::mat weights(nsim, n + 1);
+          arma::umat indices(nsim, n);
+          model.bsf_filter(nsim, L, alpha, weights, indices);
+        }, n, L, 1, nsim, n_reps);
+      }
+    }
+  }
+
+  // Non-linear models
+
+  for (unsigned int n : ns) {
+    nlg_ssm model = bench_growth(n);
+    bench("ekf", "growth", [&]() { model.ekf_loglik(0); }, n, 2, 1, 0, n_reps);
+    bench("ekf_smoother", "growth", [&]() {
+      arma::mat att(2, n);
+      arma::cube Ptt(2, 2, n);
+      model.ekf_smoother(att, Ptt, 0);
+    }, n, 2, 1, 0, n_reps);
+    for (unsigned int nsim : nsims) {
+      bench("bsf_filter", "growth", [&]() {
+        arma::cube alpha(2, n + 1, nsim);
+        arma::mat weights(nsim, n + 1);
+        arma::umat indices(nsim, n);
+        model.bsf_filter(nsim, alpha, weights, indices);
+      }, n, 2, 1, nsim, n_reps);
+      bench("ekpf_filter", "growth", [&]() {
+        arma::cube alpha(2, n + 1, nsim);
+        arma::mat weights(nsim, n + 1);
+        arma::umat indices(nsim, n);
+        model.ekf_filter(nsim, alpha, weights, indices);
+      }, n, 2, 1, nsim, n_reps);
+    }
+  }
+
+  // MCMC drivers, single replication due to the running time
+
+  unsigned int n = ns.front();
+  unsigned int nsim = nsims.front();
+  {
+    ugg_ssm model = bench_gssm(n, 2);
+    bench("mcmc_gaussian", "gssm", [&]() {
+      mcmc mcmc_run(n_iter, n_iter / 2, 1, n, 2, 0.234, 2.0 / 3.0,
+        0.1 * arma::eye(3, 3), 0);
+      mcmc_run.mcmc_gaussian(model, true);
+    }, n, 2, 1, 0, 1);
+  }
+  {
+    ung_ssm model = bench_poisson(n);
+    arma::vec initial_mode = arma::log(model.y + 0.1);
+    bench("mcmc_is2_psi", "poisson", [&]() {
+      ung_amcmc mcmc_run(n_iter, n_iter / 2, 1, n, 1, 0.234, 2.0 / 3.0,
+        arma::mat(1, 1).fill(0.01), 3);
+      mcmc_run.approx_mcmc(model, true, true, initial_mode, 100, 1e-8);
+      mcmc_run.is_correction_psi(model, nsim, 2, 1);
+    }, n, 1, 1, nsim, 1);
+  }
+
+  std::FILE* file = std::fopen(output.c_str(), "w");
+  if (!file) {
+    std::fprintf(stderr, "Cannot open %s\n", output.c_str());
+    return 1;
+  }
+  std::fprintf(file, 
+    "benchmark,model,n,m,p,nsim,reps,median_time,min_time,allocs,bytes\n");
+  for (const result& res : results) {
+    std::fprintf(file, "%s,%s,%u,%u,%u,%u,%u,%.8g,%.8g,%lu,%lu\n", 
+      res.benchmark.c_str(), res.model.c_str(), res.n, res.m, res.p, res.nsim, 
+      res.reps, res.median_time, res.min_time, res.allocs, res.bytes);
+  }
+  std::fclose(file);
+  std::fprintf(stderr, "Results written to %s\n", output.c_str());
+  return 0;
+}
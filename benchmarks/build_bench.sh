@@ -0,0 +1,37 @@
+#!/bin/sh
+# Build the benchmarks of the numerical core without R (bench_core.cpp),
+# linked against the library built by tools/check_core.sh, which also 
+# describes the include paths of the dependencies.
+#
+# Usage: benchmarks/build_bench.sh (from the package root), then
+#   $BUILD_DIR/bench_core [output.csv] [quick]
+
+set -e
+
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:-"-O2 -std=c++11 -fopenmp"}
+BUILD_DIR=${BUILD_DIR:-_core_build}
+LIBS=${LIBS:-"-llapack -lblas"}
+
+tools/check_core.sh
+
+r_include() {
+  if command -v Rscript > /dev/null 2>&1; then
+    Rscript -e "cat(system.file('include', package = '$1'))"
+  fi
+}
+
+SITMO_INCLUDE=${SITMO_INCLUDE:-$(r_include sitmo)}
+RAMCMC_INCLUDE=${RAMCMC_INCLUDE:-$(r_include ramcmc)}
+BH_INCLUDE=${BH_INCLUDE:-$(r_include BH)}
+
+INCLUDES="-Isrc -I$BUILD_DIR/shim"
+for dir in "$ARMA_INCLUDE" "$BH_INCLUDE" "$SITMO_INCLUDE" "$RAMCMC_INCLUDE"; do
+  if [ -n "$dir" ]; then
+    INCLUDES="$INCLUDES -I$dir"
+  fi
+done
+
+$CXX $CXXFLAGS -DBSSM_STANDALONE $INCLUDES benchmarks/bench_core.cpp \
+  "$BUILD_DIR/libbssm_core.a" $LIBS -o "$BUILD_DIR/bench_core"
+echo "built $BUILD_DIR/bench_core"
@@ -455,3 +455,64 @@ Rcpp::List bsf_smoother_nlg(const arma::mat& y, SEXP Z, SEXP H,
     Rcpp::Named("weights") = weights,
     Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = alpha);
 }
+
+// [[Rcpp::export]]
+Rcpp::List bsf_online(const Rcpp::List& model_, arma::mat alpha,
+  const unsigned int nsim_states, const unsigned int seed, 
+  const int model_type) {
+  
+  double loglik;
+  
+  switch (model_type) {
+  case 1: {
+    ung_ssm model(clone(model_), seed);
+    loglik = model.bsf_update(nsim_states, alpha);
+  } break;
+  case 2: {
+    ung_bsm model(clone(model_), seed);
+    loglik = model.bsf_update(nsim_states, alpha);
+  } break;
+  case 3: {
+    ung_svm model(clone(model_), seed);
+    loglik = model.bsf_update(nsim_states, alpha);
+  } break;
+  case 4: {
+    ung_ar1 model(clone(model_), seed);
+    loglik = model.bsf_update(nsim_states, alpha);
+  } break;
+  default: 
+    loglik = -std::numeric_limits<double>::infinity();
+  }
+  
+  return Rcpp::List::create(
+    Rcpp::Named("alpha") = alpha, Rcpp::Named("logLik") = loglik);
+}
+
+// [[Rcpp::export]]
+Rcpp::List bsf_online_nlg(const arma::mat& y, SEXP Z, SEXP H, 
+  SEXP T, SEXP R, SEXP Zg, SEXP Tg, SEXP a1, SEXP P1, 
+  const arma::vec& theta, SEXP log_prior_pdf, const arma::vec& known_params, 
+  const arma::mat& known_tv_params, const unsigned int n_states, 
+  const unsigned int n_etas,  const arma::uvec& time_varying,
+  arma::mat alpha, const unsigned int nsim_states, const unsigned int seed, 
+  const unsigned int t_offset) {
+  
+  Rcpp::XPtr<nvec_fnPtr> xpfun_Z(Z);
+  Rcpp::XPtr<nmat_fnPtr> xpfun_H(H);
+  Rcpp::XPtr<nvec_fnPtr> xpfun_T(T);
+  Rcpp::XPtr<nmat_fnPtr> xpfun_R(R);
+  Rcpp::XPtr<nmat_fnPtr> xpfun_Zg(Zg);
+  Rcpp::XPtr<nmat_fnPtr> xpfun_Tg(Tg);
+  Rcpp::XPtr<a1_fnPtr> xpfun_a1(a1);
+  Rcpp::XPtr<P1_fnPtr> xpfun_P1(P1);
+  Rcpp::XPtr<prior_fnPtr> xpfun_prior(log_prior_pdf);
+  
+  nlg_ssm model(y, *xpfun_Z, *xpfun_H, *xpfun_T, *xpfun_R, *xpfun_Zg, *xpfun_Tg, 
+    *xpfun_a1, *xpfun_P1,  theta, *xpfun_prior, known_params, known_tv_params, n_states, n_etas,
+    time_varying, seed);
+  
+  double loglik = model.bsf_update(nsim_states, alpha, t_offset);
+  
+  return Rcpp::List::create(
+    Rcpp::Named("alpha") = alpha, Rcpp::Named("logLik") = loglik);
+}
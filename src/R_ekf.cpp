@@ -103,3 +103,10 @@ Rcpp::List ekf_fast_smoother_nlg(const arma::mat& y, SEXP Z, SEXP H,
   return Rcpp::List::create(Rcpp::Named("alphahat") = alphahat,
     Rcpp::Named("logLik") = loglik);
 }
+
+// external pointer to a missing Jacobian Z_gn or T_gn of nlg_ssm, 
+// which is then computed by finite differences
+// [[Rcpp::export]]
+SEXP null_jacobian_ptr() {
+  return Rcpp::XPtr<nmat_fnPtr>(new nmat_fnPtr(nullptr));
+}
@@ -10,7 +10,7 @@ Rcpp::List ekpf(const arma::mat& y, SEXP Z, SEXP H,
   const arma::mat& known_tv_params, const unsigned int n_states, 
   const unsigned int n_etas,  const arma::uvec& time_varying,
   const unsigned int nsim_states, 
-  const unsigned int seed) {
+  const unsigned int seed, const unsigned int n_threads) {
   
   
   Rcpp::XPtr<nvec_fnPtr> xpfun_Z(Z);
@@ -30,22 +30,22 @@ Rcpp::List ekpf(const arma::mat& y, SEXP Z, SEXP H,
   unsigned int m = model.m;
   unsigned n = model.n;
   
-  arma::cube alpha(m, n, nsim_states + 1);
-  arma::mat weights(nsim_states + 1, n);
+  arma::cube alpha(m, n + 1, nsim_states);
+  arma::mat weights(nsim_states, n + 1);
   arma::umat indices(nsim_states, n);
-  double loglik = model.ekf_filter(nsim_states, alpha, weights, indices);
-  
+  double loglik = model.ekf_filter(nsim_states, alpha, weights, indices, n_threads);
   
-  arma::mat at(m, n + 1);
-  arma::mat att(m, n + 1);
-  arma::cube Pt(m, m, n + 1);
-  arma::cube Ptt(m, m, n + 1);
+  arma::mat at(m, n);
+  arma::mat att(m, n);
+  arma::cube Pt(m, m, n);
+  arma::cube Ptt(m, m, n);
   filter_summary(alpha, at, att, Pt, Ptt, weights);
   
+  arma::inplace_trans(at);
   arma::inplace_trans(att);
   return Rcpp::List::create(
-    Rcpp::Named("att") = att, 
-    Rcpp::Named("Ptt") = Ptt, 
+    Rcpp::Named("at") = at, Rcpp::Named("att") = att, 
+    Rcpp::Named("Pt") = Pt, Rcpp::Named("Ptt") = Ptt, 
     Rcpp::Named("weights") = weights,
     Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = alpha);
 }
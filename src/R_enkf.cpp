@@ -0,0 +1,49 @@
+#include "nlg_ssm.h"
+
+// [[Rcpp::export]]
+Rcpp::List enkf_nlg(const arma::mat& y, SEXP Z, SEXP H, 
+  SEXP T, SEXP R, SEXP Zg, SEXP Tg, SEXP a1, SEXP P1, 
+  const arma::vec& theta, SEXP log_prior_pdf, const arma::vec& known_params, 
+  const arma::mat& known_tv_params, const unsigned int n_states, 
+  const unsigned int n_etas,  const arma::uvec& time_varying, 
+  const unsigned int n_ens, const bool square_root, const bool smooth, 
+  const unsigned int lag, const unsigned int seed, const unsigned int n_threads) {
+  
+  Rcpp::XPtr<nvec_fnPtr> xpfun_Z(Z);
+  Rcpp::XPtr<nmat_fnPtr> xpfun_H(H);
+  Rcpp::XPtr<nvec_fnPtr> xpfun_T(T);
+  Rcpp::XPtr<nmat_fnPtr> xpfun_R(R);
+  Rcpp::XPtr<nmat_fnPtr> xpfun_Zg(Zg);
+  Rcpp::XPtr<nmat_fnPtr> xpfun_Tg(Tg);
+  Rcpp::XPtr<a1_fnPtr> xpfun_a1(a1);
+  Rcpp::XPtr<P1_fnPtr> xpfun_P1(P1);
+  Rcpp::XPtr<prior_fnPtr> xpfun_prior(log_prior_pdf);
+  
+  nlg_ssm model(y, *xpfun_Z, *xpfun_H, *xpfun_T, *xpfun_R, *xpfun_Zg, *xpfun_Tg, 
+    *xpfun_a1, *xpfun_P1,  theta, *xpfun_prior, known_params, known_tv_params, n_states, n_etas,
+    time_varying, seed);
+  
+  arma::cube alpha(model.m, n_ens, model.n);
+  double logLik = model.enkf(n_ens, square_root, model.engine, alpha, smooth, 
+    n_threads, lag);
+  
+  arma::mat at(model.n, model.m);
+  arma::cube Pt(model.m, model.m, model.n);
+  for (unsigned int t = 0; t < model.n; t++) {
+    at.row(t) = arma::mean(alpha.slice(t), 1).t();
+    Pt.slice(t) = arma::cov(alpha.slice(t).t());
+  }
+  
+  if (smooth) {
+    return Rcpp::List::create(
+      Rcpp::Named("alphahat") = at,
+      Rcpp::Named("Vt") = Pt,
+      Rcpp::Named("alpha") = alpha,
+      Rcpp::Named("logLik") = logLik);
+  }
+  return Rcpp::List::create(
+    Rcpp::Named("att") = at,
+    Rcpp::Named("Ptt") = Pt,
+    Rcpp::Named("alpha") = alpha,
+    Rcpp::Named("logLik") = logLik);
+}
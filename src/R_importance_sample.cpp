@@ -8,13 +8,14 @@
 Rcpp::List importance_sample_ung(const Rcpp::List& model_, 
   unsigned int nsim_states, bool use_antithetic,
   arma::vec mode_estimate, const unsigned int max_iter, 
-  const double conv_tol, const unsigned int seed, const int model_type) {
+  const double conv_tol, const unsigned int seed, const unsigned int n_threads, 
+  const int model_type) {
   
   switch (model_type) {
   case 1: {
     ung_ssm model(clone(model_), seed);
     ugg_ssm approx_model = model.approximate(mode_estimate, max_iter, conv_tol);
-    arma::cube alpha = approx_model.simulate_states(nsim_states, use_antithetic);
+    arma::cube alpha = approx_model.simulate_states(nsim_states, use_antithetic, n_threads);
     arma::vec scales = model.scaling_factors(approx_model, mode_estimate);
     arma::vec weights = model.importance_weights(approx_model, alpha);
     weights = arma::exp(weights - arma::accu(scales));
@@ -25,7 +26,7 @@ Rcpp::List importance_sample_ung(const Rcpp::List& model_,
   case 2: {
     ung_bsm model(clone(model_), seed);
     ugg_ssm approx_model = model.approximate(mode_estimate, max_iter, conv_tol);
-    arma::cube alpha = approx_model.simulate_states(nsim_states, use_antithetic);
+    arma::cube alpha = approx_model.simulate_states(nsim_states, use_antithetic, n_threads);
     arma::vec scales = model.scaling_factors(approx_model, mode_estimate);
     arma::vec weights = model.importance_weights(approx_model, alpha);
     weights = arma::exp(weights - arma::accu(scales));
@@ -35,7 +36,7 @@ Rcpp::List importance_sample_ung(const Rcpp::List& model_,
   case 3: {
     ung_svm model(clone(model_), seed);
     ugg_ssm approx_model = model.approximate(mode_estimate, max_iter, conv_tol);
-    arma::cube alpha = approx_model.simulate_states(nsim_states, use_antithetic);
+    arma::cube alpha = approx_model.simulate_states(nsim_states, use_antithetic, n_threads);
      arma::vec scales = model.scaling_factors(approx_model, mode_estimate);
      arma::vec weights = model.importance_weights(approx_model, alpha);
      weights = arma::exp(weights - arma::accu(scales));
@@ -45,7 +46,7 @@ Rcpp::List importance_sample_ung(const Rcpp::List& model_,
   case 4: {
     ung_ar1 model(clone(model_), seed);
     ugg_ssm approx_model = model.approximate(mode_estimate, max_iter, conv_tol);
-    arma::cube alpha = approx_model.simulate_states(nsim_states, use_antithetic);
+    arma::cube alpha = approx_model.simulate_states(nsim_states, use_antithetic, n_threads);
     arma::vec scales = model.scaling_factors(approx_model, mode_estimate);
     arma::vec weights = model.importance_weights(approx_model, alpha);
     weights = arma::exp(weights - arma::accu(scales));
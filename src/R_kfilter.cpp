@@ -101,4 +101,36 @@ Rcpp::List general_gaussian_kfilter(const arma::mat& y, SEXP Z, SEXP H,
     Rcpp::Named("Pt") = Pt,
     Rcpp::Named("Ptt") = Ptt,
     Rcpp::Named("logLik") = loglik);
-}
\ No newline at end of file
+}
+// [[Rcpp::export]]
+Rcpp::List gaussian_online_filter(const Rcpp::List& model_, arma::vec at, 
+  arma::mat Pt, const int model_type) {
+  
+  double loglik;
+  
+  switch (model_type) {
+  case -1: {
+    mgg_ssm model(clone(model_), 1);
+    loglik = model.log_likelihood(at, Pt);
+  } break;
+  case 1: {
+    ugg_ssm model(clone(model_), 1);
+    loglik = model.log_likelihood(at, Pt);
+  } break;
+  case 2: {
+    ugg_bsm model(clone(model_), 1);
+    loglik = model.log_likelihood(at, Pt);
+  } break;
+  case 3: {
+    ugg_ar1 model(clone(model_), 1);
+    loglik = model.log_likelihood(at, Pt);
+  } break;
+  default: 
+    loglik = -std::numeric_limits<double>::infinity();
+  }
+  
+  return Rcpp::List::create(
+    Rcpp::Named("at") = at,
+    Rcpp::Named("Pt") = Pt,
+    Rcpp::Named("logLik") = loglik);
+}
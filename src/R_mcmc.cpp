@@ -15,7 +15,9 @@ Rcpp::List gaussian_mcmc(const Rcpp::List& model_,
   const unsigned int type, const unsigned int n_iter, const unsigned int n_burnin,
   const unsigned int n_thin, const double gamma, const double target_acceptance,
   const arma::mat S, const unsigned int seed, const bool end_ram,
-  const unsigned int n_threads, const int model_type, const arma::uvec& Z_ind,
+  const unsigned int n_threads, const bool profile, const unsigned int n_walkers,
+  const unsigned int n_temps, const double max_temp,
+  const int model_type, const arma::uvec& Z_ind,
   const arma::uvec& H_ind, const arma::uvec& T_ind, const arma::uvec& R_ind) {
   
   arma::vec a1 = Rcpp::as<arma::vec>(model_["a1"]);
@@ -33,100 +35,122 @@ Rcpp::List gaussian_mcmc(const Rcpp::List& model_,
   mcmc mcmc_run(n_iter, n_burnin, n_thin, n, m,
     target_acceptance, gamma, S, type == 1);
   
+  mcmc_run.profiler.enabled = profile;
+  
   switch (model_type) {
   case 1: {
     ugg_ssm model(clone(model_), seed, Z_ind, H_ind, T_ind, R_ind);
-    mcmc_run.mcmc_gaussian(model, end_ram);
+    // n_walkers > 0 uses ensemble MCMC instead of RAM, 
+    // n_temps > 1 parallel tempering
+    if (n_walkers > 0) {
+      mcmc_run.ensemble_gaussian(model, n_walkers, n_threads);
+    } else if (n_temps > 1) {
+      mcmc_run.pt_gaussian(model, end_ram, n_temps, max_temp, n_threads);
+    } else {
+      mcmc_run.mcmc_gaussian(model, end_ram);
+    }
     switch (type) { 
     case 1: {
       mcmc_run.state_posterior(model, n_threads); //sample states
-      return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+      return mcmc_run.profiler.append(Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
         Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
         Rcpp::Named("counts") = mcmc_run.count_storage,
         Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
     } break;
     case 2: {
       //summary
       arma::mat alphahat(m, n + 1);
       arma::cube Vt(m, m, n + 1);
       mcmc_run.state_summary(model, alphahat, Vt);
-      return Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
+      return mcmc_run.profiler.append(Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
         Rcpp::Named("alphahat") = alphahat.t(), Rcpp::Named("Vt") = Vt,
         Rcpp::Named("counts") = mcmc_run.count_storage,
         Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
     } break;
     case 3: {
       //marginal of theta
-      return Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
+      return mcmc_run.profiler.append(Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
         Rcpp::Named("counts") = mcmc_run.count_storage,
         Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
     } break;
     } 
   }break;
   case 2: {
     ugg_bsm model(clone(model_), seed);
-    mcmc_run.mcmc_gaussian(model, end_ram);
+    if (n_walkers > 0) {
+      mcmc_run.ensemble_gaussian(model, n_walkers, n_threads);
+    } else if (n_temps > 1) {
+      mcmc_run.pt_gaussian(model, end_ram, n_temps, max_temp, n_threads);
+    } else {
+      mcmc_run.mcmc_gaussian(model, end_ram);
+    }
     switch (type) { 
     case 1: {
       mcmc_run.state_posterior(model, n_threads); //sample states
-      return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+      return mcmc_run.profiler.append(Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
         Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
         Rcpp::Named("counts") = mcmc_run.count_storage,
         Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
     } break;
     case 2: {
       //summary
       arma::mat alphahat(m, n + 1);
       arma::cube Vt(m, m, n + 1);
       mcmc_run.state_summary(model, alphahat, Vt);
-      return Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
+      return mcmc_run.profiler.append(Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
         Rcpp::Named("alphahat") = alphahat.t(), Rcpp::Named("Vt") = Vt,
         Rcpp::Named("counts") = mcmc_run.count_storage,
         Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
     } break;
     case 3: {
       //marginal of theta
-      return Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
+      return mcmc_run.profiler.append(Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
         Rcpp::Named("counts") = mcmc_run.count_storage,
         Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
     } break;
     } 
   } break;
   case 3: {
     ugg_ar1 model(clone(model_), seed);
-    mcmc_run.mcmc_gaussian(model, end_ram);
+    if (n_walkers > 0) {
+      mcmc_run.ensemble_gaussian(model, n_walkers, n_threads);
+    } else if (n_temps > 1) {
+      mcmc_run.pt_gaussian(model, end_ram, n_temps, max_temp, n_threads);
+    } else {
+      mcmc_run.mcmc_gaussian(model, end_ram);
+    }
     switch (type) { 
     case 1: {
       mcmc_run.state_posterior(model, n_threads); //sample states
-      return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+      return mcmc_run.profiler.append(Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
         Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
         Rcpp::Named("counts") = mcmc_run.count_storage,
         Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
     } break;
     case 2: {
       //summary
       arma::mat alphahat(m, n + 1);
       arma::cube Vt(m, m, n + 1);
       mcmc_run.state_summary(model, alphahat, Vt);
-      return Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
+      return mcmc_run.profiler.append(Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
         Rcpp::Named("alphahat") = alphahat.t(), Rcpp::Named("Vt") = Vt,
         Rcpp::Named("counts") = mcmc_run.count_storage,
         Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
     } break;
     case 3: {
       //marginal of theta
-      return Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
+      return mcmc_run.profiler.append(Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
         Rcpp::Named("counts") = mcmc_run.count_storage,
         Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
     } break;
     } 
   } break;
@@ -140,7 +164,7 @@ Rcpp::List nongaussian_pm_mcmc(const Rcpp::List& model_,
   const unsigned int n_burnin, const unsigned int n_thin,
   const double gamma, const double target_acceptance, const arma::mat S,
   const unsigned int seed, const bool end_ram, const unsigned int n_threads,
-  const bool local_approx, const arma::vec initial_mode,
+  const bool profile, const bool local_approx, const arma::vec initial_mode,
   const unsigned int max_iter, const double conv_tol,
   const unsigned int simulation_method, const int model_type,
   const arma::uvec& Z_ind, const arma::uvec& T_ind, const arma::uvec& R_ind) {
@@ -160,6 +184,8 @@ Rcpp::List nongaussian_pm_mcmc(const Rcpp::List& model_,
   mcmc mcmc_run(n_iter, n_burnin, n_thin, n, m,
     target_acceptance, gamma, S, type);
   
+  mcmc_run.profiler.enabled = profile;
+  
   switch (model_type) {
   case 1: {
     ung_ssm model(clone(model_), seed, Z_ind, T_ind, R_ind);
@@ -228,26 +254,26 @@ Rcpp::List nongaussian_pm_mcmc(const Rcpp::List& model_,
   }
   switch (type) { 
   case 1: {
-    return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+    return mcmc_run.profiler.append(Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   case 2: {
-    return Rcpp::List::create(
+    return mcmc_run.profiler.append(Rcpp::List::create(
       Rcpp::Named("alphahat") = mcmc_run.alphahat.t(), Rcpp::Named("Vt") = mcmc_run.Vt,
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   case 3: {
-    return Rcpp::List::create(
+    return mcmc_run.profiler.append(Rcpp::List::create(
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   }
   
@@ -261,7 +287,8 @@ Rcpp::List nongaussian_da_mcmc(const Rcpp::List& model_,
   const unsigned int nsim_states, const unsigned int n_iter,
   const unsigned int n_burnin, const unsigned int n_thin, const double gamma,
   const double target_acceptance, const arma::mat S, const unsigned int seed,
-  const bool end_ram, const unsigned int n_threads, const bool local_approx,
+  const bool end_ram, const unsigned int n_threads, const bool profile,
+  const bool local_approx,
   const arma::vec initial_mode, const unsigned int max_iter, const double conv_tol,
   const unsigned int simulation_method, const int model_type,
   const arma::uvec& Z_ind, const arma::uvec& T_ind, const arma::uvec& R_ind) {
@@ -281,6 +308,8 @@ Rcpp::List nongaussian_da_mcmc(const Rcpp::List& model_,
   mcmc mcmc_run(n_iter, n_burnin, n_thin, n, m,
     target_acceptance, gamma, S, type);
   
+  mcmc_run.profiler.enabled = profile;
+  
   switch (model_type) {
   case 1: {
     ung_ssm model(clone(model_), seed, Z_ind, T_ind, R_ind);
@@ -355,26 +384,26 @@ Rcpp::List nongaussian_da_mcmc(const Rcpp::List& model_,
   
   switch (type) { 
   case 1: {
-    return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+    return mcmc_run.profiler.append(Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   case 2: {
-    return Rcpp::List::create(
+    return mcmc_run.profiler.append(Rcpp::List::create(
       Rcpp::Named("alphahat") = mcmc_run.alphahat.t(), Rcpp::Named("Vt") = mcmc_run.Vt,
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   case 3: {
-    return Rcpp::List::create(
+    return mcmc_run.profiler.append(Rcpp::List::create(
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   }
   
@@ -389,9 +418,11 @@ Rcpp::List nongaussian_is_mcmc(const Rcpp::List& model_,
   const unsigned int nsim_states, const unsigned int n_iter,
   const unsigned int n_burnin, const unsigned int n_thin, const  double gamma,
   const double target_acceptance, const arma::mat S, const unsigned int seed,
-  const bool end_ram, const unsigned int n_threads, const bool local_approx,
+  const bool end_ram, const unsigned int n_threads, const bool profile,
+  const bool local_approx,
   const arma::vec initial_mode, const unsigned int max_iter, const double conv_tol,
-  const unsigned int simulation_method, const unsigned int is_type, const int model_type,
+  const unsigned int simulation_method, const unsigned int is_type, 
+  const unsigned int n_temps, const double max_temp, const int model_type,
   const arma::uvec& Z_ind, const arma::uvec& T_ind, const arma::uvec& R_ind) {
   
   arma::vec a1 = Rcpp::as<arma::vec>(model_["a1"]);
@@ -408,6 +439,8 @@ Rcpp::List nongaussian_is_mcmc(const Rcpp::List& model_,
   
   ung_amcmc mcmc_run(n_iter, n_burnin, n_thin, n, m,
     target_acceptance, gamma, S, type, simulation_method != 2);
+  
+  mcmc_run.profiler.enabled = profile;
   if (nsim_states <= 1) {
     mcmc_run.alpha_storage.zeros();
     mcmc_run.weight_storage.ones();
@@ -415,8 +448,13 @@ Rcpp::List nongaussian_is_mcmc(const Rcpp::List& model_,
   switch (model_type) {
   case 1: {
     ung_ssm model(clone(model_), seed, Z_ind, T_ind, R_ind);
-    mcmc_run.approx_mcmc(model, end_ram, local_approx, initial_mode,
-      max_iter, conv_tol);
+    if (n_temps > 1) {
+      mcmc_run.approx_pt_mcmc(model, end_ram, local_approx, initial_mode,
+        max_iter, conv_tol, n_temps, max_temp, n_threads);
+    } else {
+      mcmc_run.approx_mcmc(model, end_ram, local_approx, initial_mode,
+        max_iter, conv_tol);
+    }
     if(nsim_states > 1) {
       if(is_type == 3) {
         mcmc_run.expand();
@@ -438,8 +476,13 @@ Rcpp::List nongaussian_is_mcmc(const Rcpp::List& model_,
   } break;
   case 2: {
     ung_bsm model(clone(model_), seed);
-    mcmc_run.approx_mcmc(model, end_ram, local_approx, initial_mode,
-      max_iter, conv_tol);
+    if (n_temps > 1) {
+      mcmc_run.approx_pt_mcmc(model, end_ram, local_approx, initial_mode,
+        max_iter, conv_tol, n_temps, max_temp, n_threads);
+    } else {
+      mcmc_run.approx_mcmc(model, end_ram, local_approx, initial_mode,
+        max_iter, conv_tol);
+    }
     if(nsim_states > 1) {
       if(is_type == 3) {
         mcmc_run.expand();
@@ -461,8 +504,13 @@ Rcpp::List nongaussian_is_mcmc(const Rcpp::List& model_,
   } break;
   case 3: {
     ung_svm model(clone(model_), seed);
-    mcmc_run.approx_mcmc(model, end_ram, local_approx, initial_mode,
-      max_iter, conv_tol);
+    if (n_temps > 1) {
+      mcmc_run.approx_pt_mcmc(model, end_ram, local_approx, initial_mode,
+        max_iter, conv_tol, n_temps, max_temp, n_threads);
+    } else {
+      mcmc_run.approx_mcmc(model, end_ram, local_approx, initial_mode,
+        max_iter, conv_tol);
+    }
     if(nsim_states > 1) {
       if(is_type == 3) {
         mcmc_run.expand();
@@ -484,8 +532,13 @@ Rcpp::List nongaussian_is_mcmc(const Rcpp::List& model_,
   } break;  
   case 4: {
     ung_ar1 model(clone(model_), seed);
-    mcmc_run.approx_mcmc(model, end_ram, local_approx, initial_mode,
-      max_iter, conv_tol);
+    if (n_temps > 1) {
+      mcmc_run.approx_pt_mcmc(model, end_ram, local_approx, initial_mode,
+        max_iter, conv_tol, n_temps, max_temp, n_threads);
+    } else {
+      mcmc_run.approx_mcmc(model, end_ram, local_approx, initial_mode,
+        max_iter, conv_tol);
+    }
     if(nsim_states > 1) {
       if(is_type == 3) {
         mcmc_run.expand();
@@ -509,29 +562,29 @@ Rcpp::List nongaussian_is_mcmc(const Rcpp::List& model_,
   
   switch (type) { 
   case 1: {
-    return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+    return mcmc_run.profiler.append(Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("weights") = mcmc_run.weight_storage,
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   case 2: {
-    return Rcpp::List::create(
+    return mcmc_run.profiler.append(Rcpp::List::create(
       Rcpp::Named("alphahat") = mcmc_run.alphahat.t(), Rcpp::Named("Vt") = mcmc_run.Vt,
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("weights") = mcmc_run.weight_storage,
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   case 3: {
-    return Rcpp::List::create(
+    return mcmc_run.profiler.append(Rcpp::List::create(
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("weights") = mcmc_run.weight_storage,
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   }
   
@@ -547,7 +600,7 @@ Rcpp::List nonlinear_pm_mcmc(const arma::mat& y, SEXP Z, SEXP H,
   const unsigned int seed, const unsigned int nsim_states, const unsigned int n_iter,
   const unsigned int n_burnin, const unsigned int n_thin,
   const double gamma, const double target_acceptance, const arma::mat S,
-  const bool end_ram, const unsigned int n_threads,
+  const bool end_ram, const unsigned int n_threads, const bool profile,
   const unsigned int max_iter, const double conv_tol,
   const unsigned int simulation_method, const unsigned int iekf_iter,
   const unsigned int type) {
@@ -570,9 +623,12 @@ Rcpp::List nonlinear_pm_mcmc(const arma::mat& y, SEXP Z, SEXP H,
   mcmc mcmc_run(n_iter, n_burnin, n_thin, model.n,
     model.m, target_acceptance, gamma, S, type);
   
+  mcmc_run.profiler.enabled = profile;
+  
   switch (simulation_method) {
   case 1:
-    mcmc_run.pm_mcmc_psi_nlg(model, end_ram, nsim_states, max_iter, conv_tol, iekf_iter);
+    mcmc_run.pm_mcmc_psi_nlg(model, end_ram, nsim_states, max_iter, conv_tol, iekf_iter, 
+      n_threads);
     break;
   case 2:
     mcmc_run.pm_mcmc_bsf_nlg(model, end_ram, nsim_states);
@@ -581,26 +637,26 @@ Rcpp::List nonlinear_pm_mcmc(const arma::mat& y, SEXP Z, SEXP H,
   
   switch (type) { 
   case 1: {
-    return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+    return mcmc_run.profiler.append(Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   case 2: {
-    return Rcpp::List::create(
+    return mcmc_run.profiler.append(Rcpp::List::create(
       Rcpp::Named("alphahat") = mcmc_run.alphahat.t(), Rcpp::Named("Vt") = mcmc_run.Vt,
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   case 3: {
-    return Rcpp::List::create(
+    return mcmc_run.profiler.append(Rcpp::List::create(
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   }
   
@@ -615,7 +671,7 @@ Rcpp::List nonlinear_da_mcmc(const arma::mat& y, SEXP Z, SEXP H,
   const unsigned int seed, const unsigned int nsim_states, const unsigned int n_iter,
   const unsigned int n_burnin, const unsigned int n_thin,
   const double gamma, const double target_acceptance, const arma::mat S,
-  const bool end_ram, const unsigned int n_threads,
+  const bool end_ram, const unsigned int n_threads, const bool profile,
   const unsigned int max_iter, const double conv_tol,
   const unsigned int simulation_method, const unsigned int iekf_iter,
   const unsigned int type) {
@@ -638,38 +694,42 @@ Rcpp::List nonlinear_da_mcmc(const arma::mat& y, SEXP Z, SEXP H,
   mcmc mcmc_run(n_iter, n_burnin, n_thin, model.n,
     model.m, target_acceptance, gamma, S, type);
   
+  mcmc_run.profiler.enabled = profile;
+  
   
   switch (simulation_method) {
   case 1:
-    mcmc_run.da_mcmc_psi_nlg(model, end_ram, nsim_states, max_iter, conv_tol, iekf_iter);
+    mcmc_run.da_mcmc_psi_nlg(model, end_ram, nsim_states, max_iter, conv_tol, iekf_iter, 
+      n_threads);
     break;
   case 2:
-    mcmc_run.da_mcmc_bsf_nlg(model, end_ram, nsim_states, max_iter, conv_tol, iekf_iter);
+    mcmc_run.da_mcmc_bsf_nlg(model, end_ram, nsim_states, max_iter, conv_tol, iekf_iter, 
+      n_threads);
     break;
   }
   
   switch (type) { 
   case 1: {
-    return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+    return mcmc_run.profiler.append(Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   case 2: {
-    return Rcpp::List::create(
+    return mcmc_run.profiler.append(Rcpp::List::create(
       Rcpp::Named("alphahat") = mcmc_run.alphahat.t(), Rcpp::Named("Vt") = mcmc_run.Vt,
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   case 3: {
-    return Rcpp::List::create(
+    return mcmc_run.profiler.append(Rcpp::List::create(
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   }
   
@@ -685,8 +745,10 @@ Rcpp::List nonlinear_ekf_mcmc(const arma::mat& y, SEXP Z, SEXP H,
   const unsigned int seed, const unsigned int n_iter,
   const unsigned int n_burnin, const unsigned int n_thin,
   const double gamma, const double target_acceptance, const arma::mat S,
-  const bool end_ram, const unsigned int n_threads, 
-  const unsigned int iekf_iter, const unsigned int type) {
+  const bool end_ram, const unsigned int n_threads, const bool profile, 
+  const unsigned int iekf_iter, const unsigned int approx_type, 
+  const unsigned int n_ens, const double ukf_alpha, const double ukf_beta, 
+  const double ukf_kappa, const unsigned int type) {
   
   
   Rcpp::XPtr<nvec_fnPtr> xpfun_Z(Z);
@@ -706,7 +768,10 @@ Rcpp::List nonlinear_ekf_mcmc(const arma::mat& y, SEXP Z, SEXP H,
   nlg_amcmc mcmc_run(n_iter, n_burnin, n_thin, model.n,
     model.m, target_acceptance, gamma, S, type, false);
   
-  mcmc_run.ekf_mcmc(model, end_ram, iekf_iter);
+  mcmc_run.profiler.enabled = profile;
+  
+  mcmc_run.ekf_mcmc(model, end_ram, iekf_iter, approx_type, n_ens,
+      ukf_alpha, ukf_beta, ukf_kappa, n_threads);
   
   if (type == 2) {
     
@@ -714,26 +779,26 @@ Rcpp::List nonlinear_ekf_mcmc(const arma::mat& y, SEXP Z, SEXP H,
     arma::cube Vt(model.m, model.m, model.n + 1);
     mcmc_run.state_ekf_summary(model, alphahat, Vt, iekf_iter);
     
-    return Rcpp::List::create(Rcpp::Named("alphahat") = alphahat.t(), Rcpp::Named("Vt") = Vt,
+    return mcmc_run.profiler.append(Rcpp::List::create(Rcpp::Named("alphahat") = alphahat.t(), Rcpp::Named("Vt") = Vt,
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } else {
     
     if (type == 1) {
       mcmc_run.state_ekf_sample(model, n_threads, iekf_iter);
-      return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+      return mcmc_run.profiler.append(Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
         Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
         Rcpp::Named("counts") = mcmc_run.count_storage,
         Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
     } else {
-      return Rcpp::List::create(
+      return mcmc_run.profiler.append(Rcpp::List::create(
         Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
         Rcpp::Named("counts") = mcmc_run.count_storage,
         Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
     }
   }
 }
@@ -747,9 +812,12 @@ Rcpp::List nonlinear_is_mcmc(const arma::mat& y, SEXP Z, SEXP H,
   const unsigned int seed, const unsigned int nsim_states, const unsigned int n_iter,
   const unsigned int n_burnin, const unsigned int n_thin,
   const double gamma, const double target_acceptance, const arma::mat S,
-  const bool end_ram, const unsigned int n_threads, const unsigned int is_type,
+  const bool end_ram, const unsigned int n_threads, const bool profile,
+  const unsigned int is_type,
   const unsigned int simulation_method, const unsigned int max_iter,
   const double conv_tol, const unsigned int iekf_iter,
+  const unsigned int approx_type, const unsigned int n_ens,
+  const double ukf_alpha, const double ukf_beta, const double ukf_kappa,
   const unsigned int type) {
   
   
@@ -768,14 +836,23 @@ Rcpp::List nonlinear_is_mcmc(const arma::mat& y, SEXP Z, SEXP H,
     time_varying, seed);
   
   nlg_amcmc mcmc_run(n_iter, n_burnin, n_thin, model.n,
-    model.m, target_acceptance, gamma, S, type, simulation_method == 1);
+    model.m, target_acceptance, gamma, S, type, simulation_method == 1 && approx_type == 0);
+  
+  mcmc_run.profiler.enabled = profile;
   
-  mcmc_run.approx_mcmc(model, max_iter, conv_tol, end_ram, iekf_iter);
+  // approx_type > 0 uses the likelihood of EKF, UKF, or EnKF as the 
+  // approximation instead of the Gaussian approximation, corrected with BSF
+  if (approx_type > 0) {
+    mcmc_run.ekf_mcmc(model, end_ram, iekf_iter, approx_type, n_ens,
+      ukf_alpha, ukf_beta, ukf_kappa, n_threads);
+  } else {
+    mcmc_run.approx_mcmc(model, max_iter, conv_tol, end_ram, iekf_iter, n_threads);
+  }
   if(nsim_states > 0) {
     if (is_type == 3) {
       mcmc_run.expand();
     }
-    if (simulation_method == 1) {
+    if (simulation_method == 1 && approx_type == 0) {
       mcmc_run.is_correction_psi(model, nsim_states, is_type, n_threads);
     } else {
       mcmc_run.is_correction_bsf(model, nsim_states, is_type, n_threads);
@@ -784,13 +861,13 @@ Rcpp::List nonlinear_is_mcmc(const arma::mat& y, SEXP Z, SEXP H,
     mcmc_run.alpha_storage.zeros();
     mcmc_run.weight_storage.ones();
   }
-  return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+  return mcmc_run.profiler.append(Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
     Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
     Rcpp::Named("weights") = mcmc_run.weight_storage,
     Rcpp::Named("counts") = mcmc_run.count_storage,
     Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
     Rcpp::Named("S") = mcmc_run.S,
-    Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+    Rcpp::Named("posterior") = mcmc_run.posterior_storage));
 }
 
 // [[Rcpp::export]]
@@ -800,11 +877,14 @@ Rcpp::List general_gaussian_mcmc(const arma::mat& y, SEXP Z, SEXP H,
   SEXP D, SEXP C,
   SEXP log_prior_pdf, const arma::vec& known_params,
   const arma::mat& known_tv_params, const arma::uvec& time_varying,
+  const arma::umat& theta_dependence,
   const unsigned int n_states, const unsigned int n_etas,
   const unsigned int seed, const unsigned int n_iter,
   const unsigned int n_burnin, const unsigned int n_thin,
   const double gamma, const double target_acceptance, const arma::mat S,
-  const bool end_ram, const unsigned int n_threads, const unsigned int type) {
+  const bool end_ram, const unsigned int n_threads, const bool profile,
+  const unsigned int n_walkers, const unsigned int n_temps, const double max_temp,
+  const unsigned int type) {
   
   Rcpp::XPtr<lmat_fnPtr> xpfun_Z(Z);
   Rcpp::XPtr<lmat_fnPtr> xpfun_H(H);
@@ -819,23 +899,33 @@ Rcpp::List general_gaussian_mcmc(const arma::mat& y, SEXP Z, SEXP H,
   lgg_ssm model(y, *xpfun_Z, *xpfun_H, *xpfun_T, *xpfun_R, *xpfun_a1, *xpfun_P1, 
     *xpfun_D, *xpfun_C, theta, *xpfun_prior, known_params, known_tv_params, 
     time_varying, n_states, n_etas, seed);
+  // empty if not declared, in which case it is found by update_mgg
+  model.theta_dependence = theta_dependence;
   
   mcmc mcmc_run(n_iter, n_burnin, n_thin,
     model.n, model.m, target_acceptance, gamma, S, type);
   
-  mcmc_run.mcmc_gaussian(model, end_ram);
+  mcmc_run.profiler.enabled = profile;
+  
+  if (n_walkers > 0) {
+    mcmc_run.ensemble_gaussian(model, n_walkers, n_threads);
+  } else if (n_temps > 1) {
+    mcmc_run.pt_gaussian(model, end_ram, n_temps, max_temp, n_threads);
+  } else {
+    mcmc_run.mcmc_gaussian(model, end_ram, n_threads);
+  }
   if(type == 1) mcmc_run.state_posterior(model, n_threads);
   
   if(type == 1) {
-    return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+    return mcmc_run.profiler.append(Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } else {
-    return Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
+    return mcmc_run.profiler.append(Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   }
 }
@@ -6,41 +6,68 @@
 #include "nlg_ssm.h"
 #include "ung_ar1.h"
 #include "ugg_ar1.h"
+#include "predict_sample.h"
+
+namespace {
+// collect the output of predict_interval, predictions of the observations or 
+// signals are returned as matrices
+Rcpp::List interval_list(const arma::cube& intv, const arma::cube& mean_pred,
+  const arma::cube& sd_pred, const unsigned int predict_type) {
+  
+  if (predict_type < 3) {
+    return Rcpp::List::create(Rcpp::Named("intervals") = intv.slice(0),
+      Rcpp::Named("mean_pred") = mean_pred.slice(0),
+      Rcpp::Named("sd_pred") = sd_pred.slice(0));
+  }
+  return Rcpp::List::create(Rcpp::Named("intervals") = intv,
+    Rcpp::Named("mean_pred") = mean_pred,
+    Rcpp::Named("sd_pred") = sd_pred);
+}
+}
 
 // [[Rcpp::export]]
 Rcpp::List gaussian_predict(const Rcpp::List& model_,
   const arma::vec& probs, const arma::mat theta, const arma::mat alpha, 
   const arma::uvec& counts, const unsigned int predict_type,
   const bool intervals, const unsigned int seed, const int model_type, 
-  const unsigned int nsim, const arma::uvec& Z_ind,
+  const unsigned int nsim, const unsigned int n_threads, const arma::uvec& Z_ind,
   const arma::uvec& H_ind, const arma::uvec& T_ind, const arma::uvec& R_ind) {
   
   switch (model_type) {
   case 1: {
   ugg_ssm model(clone(model_), seed, Z_ind, H_ind, T_ind, R_ind);
   if (intervals) {
-    return model.predict_interval(probs, theta, alpha, counts, predict_type);
+    arma::cube intv, mean_pred, sd_pred;
+    model.predict_interval(probs, theta, alpha, counts, predict_type, 
+      intv, mean_pred, sd_pred, n_threads);
+    return interval_list(intv, mean_pred, sd_pred, predict_type);
   } else {
-    return Rcpp::List::create(model.predict_sample(theta, alpha, counts,
-      predict_type, nsim));
+    return Rcpp::List::create(predict_sample(model, theta, alpha, counts,
+      predict_type, nsim, n_threads));
   }
 } break;
   case 2: {
     ugg_bsm model(clone(model_), seed);
     if (intervals) {
-      return model.predict_interval(probs, theta, alpha, counts, predict_type);
+      arma::cube intv, mean_pred, sd_pred;
+      model.predict_interval(probs, theta, alpha, counts, predict_type, 
+        intv, mean_pred, sd_pred, n_threads);
+      return interval_list(intv, mean_pred, sd_pred, predict_type);
     } else {
-      return Rcpp::List::create(model.predict_sample(theta, alpha, counts, 
-        predict_type, nsim));
+      return Rcpp::List::create(predict_sample(model, theta, alpha, counts,
+        predict_type, nsim, n_threads));
     }
   } break;
   case 3: {
     ugg_ar1 model(clone(model_), seed);
     if (intervals) {
-      return model.predict_interval(probs, theta, alpha, counts, predict_type);
+      arma::cube intv, mean_pred, sd_pred;
+      model.predict_interval(probs, theta, alpha, counts, predict_type, 
+        intv, mean_pred, sd_pred, n_threads);
+      return interval_list(intv, mean_pred, sd_pred, predict_type);
     } else {
-      return Rcpp::List::create(model.predict_sample(theta, alpha, counts, 
-        predict_type, nsim));
+      return Rcpp::List::create(predict_sample(model, theta, alpha, counts,
+        predict_type, nsim, n_threads));
     }
   } break;
   }
@@ -52,25 +79,26 @@ arma::cube nongaussian_predict(const Rcpp::List& model_,
   const arma::vec& probs, const arma::mat& theta, const arma::mat& alpha, 
   const arma::uvec& counts, const unsigned int predict_type, 
   const unsigned int seed, const unsigned int model_type, const unsigned int nsim,
-  const arma::uvec& Z_ind, const arma::uvec& T_ind, const arma::uvec& R_ind) {
+  const unsigned int n_threads, const arma::uvec& Z_ind, const arma::uvec& T_ind, 
+  const arma::uvec& R_ind) {
   
   switch (model_type) {
   case 1: {
   ung_ssm model(clone(model_), seed, Z_ind, T_ind, R_ind);
   
-  return model.predict_sample(theta, alpha, counts, predict_type, nsim);
+  return predict_sample(model, theta, alpha, counts, predict_type, nsim, n_threads);
 } break;
   case 2: {
     ung_bsm model(clone(model_), seed);
-    return model.predict_sample(theta, alpha, counts, predict_type, nsim);
+    return predict_sample(model, theta, alpha, counts, predict_type, nsim, n_threads);
   } break;
   case 3: {
     ung_svm model(clone(model_), seed);
-    return model.predict_sample(theta, alpha, counts, predict_type, nsim);
+    return predict_sample(model, theta, alpha, counts, predict_type, nsim, n_threads);
   } break;
   case 4: {
     ung_ar1 model(clone(model_), seed);
-    return model.predict_sample(theta, alpha, counts, predict_type, nsim);
+    return predict_sample(model, theta, alpha, counts, predict_type, nsim, n_threads);
   } break;
   }
   return arma::cube(0,0,0);
@@ -84,7 +112,7 @@ arma::cube nonlinear_predict(const arma::mat& y, SEXP Z, SEXP H,
   const unsigned int n_states, const unsigned int n_etas,
   const arma::vec& probs, const arma::mat& theta, const arma::mat& alpha, 
   const arma::uvec& counts, const unsigned int predict_type, 
-  const unsigned int seed, const unsigned int nsim) {
+  const unsigned int seed, const unsigned int nsim, const unsigned int n_threads) {
   
   
   Rcpp::XPtr<nvec_fnPtr> xpfun_Z(Z);
@@ -101,7 +129,7 @@ arma::cube nonlinear_predict(const arma::mat& y, SEXP Z, SEXP H,
     *xpfun_a1, *xpfun_P1, theta.col(0), *xpfun_prior, known_params, known_tv_params, n_states, n_etas,
     time_varying, seed);
   
-  return model.predict_sample(theta, alpha, counts, predict_type, nsim);
+  return predict_sample(model, theta, alpha, counts, predict_type, nsim, n_threads);
   
 }
 
@@ -112,7 +140,8 @@ Rcpp::List nonlinear_predict_ekf(const arma::mat& y, SEXP Z, SEXP H,
   const arma::mat& known_tv_params, const arma::uvec& time_varying, 
   const unsigned int n_states, const unsigned int n_etas,
   const arma::vec& probs, const arma::mat& theta, const arma::mat& alpha_last, const arma::cube P_last, 
-  const arma::uvec& counts, const unsigned int predict_type) {
+  const arma::uvec& counts, const unsigned int predict_type, 
+  const unsigned int n_threads) {
   
   Rcpp::XPtr<nvec_fnPtr> xpfun_Z(Z);
   Rcpp::XPtr<nmat_fnPtr> xpfun_H(H);
@@ -127,6 +156,8 @@ Rcpp::List nonlinear_predict_ekf(const arma::mat& y, SEXP Z, SEXP H,
   nlg_ssm model(y, *xpfun_Z, *xpfun_H, *xpfun_T, *xpfun_R, *xpfun_Zg, *xpfun_Tg, 
     *xpfun_a1, *xpfun_P1, theta.col(0), *xpfun_prior, known_params, known_tv_params, n_states, n_etas,
     time_varying, 1);
-  return model.predict_interval(probs, theta,
-    alpha_last, P_last, counts, predict_type);
+  arma::cube intv, mean_pred, sd_pred;
+  model.predict_interval(probs, theta, alpha_last, P_last, counts, 
+    predict_type, intv, mean_pred, sd_pred, n_threads);
+  return interval_list(intv, mean_pred, sd_pred, predict_type);
 }
\ No newline at end of file
@@ -103,6 +103,28 @@ Rcpp::List bsf_smoother_sde(const arma::vec& y, const double x0,
     Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = alpha);
 }
 
+// [[Rcpp::export]]
+Rcpp::List bsf_online_sde(const arma::vec& y, const double x0, 
+  const bool positive, SEXP drift_pntr, SEXP diffusion_pntr, 
+  SEXP ddiffusion_pntr, SEXP log_prior_pdf_pntr, SEXP log_obs_density_pntr,
+  const arma::vec& theta, arma::vec alpha, const unsigned int nsim_states, 
+  const unsigned int L, const unsigned int seed) {
+  
+  Rcpp::XPtr<funcPtr> xpfun_drift(drift_pntr);
+  Rcpp::XPtr<funcPtr> xpfun_diffusion(diffusion_pntr);
+  Rcpp::XPtr<funcPtr> xpfun_ddiffusion(ddiffusion_pntr);
+  Rcpp::XPtr<prior_funcPtr> xpfun_prior(log_prior_pdf_pntr);
+  Rcpp::XPtr<obs_funcPtr> xpfun_obs(log_obs_density_pntr);
+  
+  sde_ssm model(y, theta, x0, positive, seed, *xpfun_drift,
+    *xpfun_diffusion, *xpfun_ddiffusion, *xpfun_prior, *xpfun_obs);
+  
+  double loglik = model.bsf_update(nsim_states, L, alpha);
+  
+  return Rcpp::List::create(
+    Rcpp::Named("alpha") = alpha, Rcpp::Named("logLik") = loglik);
+}
+
 // [[Rcpp::export]]
 Rcpp::List sde_pm_mcmc(const arma::vec& y, const double x0, 
   const bool positive, SEXP drift_pntr, SEXP diffusion_pntr, 
@@ -112,7 +134,7 @@ Rcpp::List sde_pm_mcmc(const arma::vec& y, const double x0,
   const unsigned int seed, const unsigned int n_iter, 
   const unsigned int n_burnin, const unsigned int n_thin,
   const double gamma, const double target_acceptance, const arma::mat S,
-  const bool end_ram, const unsigned int type) {
+  const bool end_ram, const bool profile, const unsigned int type) {
   
   Rcpp::XPtr<funcPtr> xpfun_drift(drift_pntr);
   Rcpp::XPtr<funcPtr> xpfun_diffusion(diffusion_pntr);
@@ -126,30 +148,32 @@ Rcpp::List sde_pm_mcmc(const arma::vec& y, const double x0,
   mcmc mcmc_run(n_iter, n_burnin, 
     n_thin, model.n, 1, target_acceptance, gamma, S, type);
   
+  mcmc_run.profiler.enabled = profile;
+  
   mcmc_run.pm_mcmc_bsf_sde(model, end_ram, nsim_states, L);
   
   switch (type) { 
   case 1: {
-    return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+    return mcmc_run.profiler.append(Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   case 2: {
-    return Rcpp::List::create(
+    return mcmc_run.profiler.append(Rcpp::List::create(
       Rcpp::Named("alphahat") = mcmc_run.alphahat.t(), Rcpp::Named("Vt") = mcmc_run.Vt,
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   case 3: {
-    return Rcpp::List::create(
+    return mcmc_run.profiler.append(Rcpp::List::create(
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   }
   
@@ -165,7 +189,7 @@ Rcpp::List sde_da_mcmc(const arma::vec& y, const double x0,
   const unsigned int n_iter, 
   const unsigned int n_burnin, const unsigned int n_thin,
   const double gamma, const double target_acceptance, const arma::mat S,
-  const bool end_ram, const unsigned int type) {
+  const bool end_ram, const bool profile, const unsigned int type) {
   
   Rcpp::XPtr<funcPtr> xpfun_drift(drift_pntr);
   Rcpp::XPtr<funcPtr> xpfun_diffusion(diffusion_pntr);
@@ -179,30 +203,32 @@ Rcpp::List sde_da_mcmc(const arma::vec& y, const double x0,
   mcmc mcmc_run(n_iter, n_burnin, 
     n_thin, model.n, 1, target_acceptance, gamma, S, type);
   
+  mcmc_run.profiler.enabled = profile;
+  
   mcmc_run.da_mcmc_bsf_sde(model, end_ram, nsim_states, L_c, L_f);
   
   switch (type) { 
   case 1: {
-    return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+    return mcmc_run.profiler.append(Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   case 2: {
-    return Rcpp::List::create(
+    return mcmc_run.profiler.append(Rcpp::List::create(
       Rcpp::Named("alphahat") = mcmc_run.alphahat.t(), Rcpp::Named("Vt") = mcmc_run.Vt,
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   case 3: {
-    return Rcpp::List::create(
+    return mcmc_run.profiler.append(Rcpp::List::create(
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   }
   return Rcpp::List::create(Rcpp::Named("error") = "error");
@@ -218,7 +244,7 @@ Rcpp::List sde_is_mcmc(const arma::vec& y, const double x0,
   const unsigned int n_burnin, const unsigned int n_thin,
   const double gamma, const double target_acceptance, const arma::mat S,
   const bool end_ram, const unsigned int is_type, const unsigned int n_threads,
-  const unsigned int type) {
+  const bool profile, const unsigned int type) {
   
   Rcpp::XPtr<funcPtr> xpfun_drift(drift_pntr);
   Rcpp::XPtr<funcPtr> xpfun_diffusion(diffusion_pntr);
@@ -232,6 +258,8 @@ Rcpp::List sde_is_mcmc(const arma::vec& y, const double x0,
   sde_amcmc mcmc_run(n_iter, n_burnin, n_thin, model.n, 
     target_acceptance, gamma, S, type);
   
+  mcmc_run.profiler.enabled = profile;
+  
   mcmc_run.approx_mcmc(model, end_ram, nsim_states, L_c); 
   
   if(is_type == 3) {
@@ -242,31 +270,31 @@ Rcpp::List sde_is_mcmc(const arma::vec& y, const double x0,
   
   switch (type) { 
   case 1: {
-    return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+    return mcmc_run.profiler.append(Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("weights") = mcmc_run.weight_storage,
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   case 2: {
-    return Rcpp::List::create(
+    return mcmc_run.profiler.append(Rcpp::List::create(
       Rcpp::Named("alphahat") = mcmc_run.alphahat.t(), Rcpp::Named("Vt") = mcmc_run.Vt,
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("weights") = mcmc_run.weight_storage,
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   case 3: {
-    return Rcpp::List::create(
+    return mcmc_run.profiler.append(Rcpp::List::create(
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("weights") = mcmc_run.weight_storage,
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
-      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage));
   } break;
   }
   
   return Rcpp::List::create(Rcpp::Named("error") = "error");
-}
\ No newline at end of file
+}
@@ -163,20 +163,21 @@ arma::mat gaussian_fast_smoother(const Rcpp::List& model_, const int model_type)
 
 // [[Rcpp::export]]
 arma::cube gaussian_sim_smoother(const Rcpp::List& model_, const unsigned int nsim, 
-  bool use_antithetic, const unsigned int seed, const int model_type) {
+  bool use_antithetic, const unsigned int seed, const unsigned int n_threads, 
+  const int model_type) {
   
   switch (model_type) {
   case 1: {
   ugg_ssm model(clone(model_), seed);
-  return model.simulate_states(nsim, use_antithetic);
+  return model.simulate_states(nsim, use_antithetic, n_threads);
 } break;
   case 2: {
     ugg_bsm model(clone(model_), seed);
-    return model.simulate_states(nsim, use_antithetic);
+    return model.simulate_states(nsim, use_antithetic, n_threads);
   } break;
   case 3: {
     ugg_ar1 model(clone(model_), seed);
-    return model.simulate_states(nsim, use_antithetic);
+    return model.simulate_states(nsim, use_antithetic, n_threads);
   } break;
   default:
     return arma::cube(0,0,0);
@@ -7,7 +7,7 @@ Rcpp::List ukf_nlg(const arma::mat& y, SEXP Z, SEXP H,
   const arma::mat& known_tv_params, const unsigned int n_states, 
   const unsigned int n_etas,  const arma::uvec& time_varying, 
   const double alpha, const double beta, 
-  const double kappa) {
+  const double kappa, const unsigned int n_threads) {
   
   Rcpp::XPtr<nvec_fnPtr> xpfun_Z(Z);
   Rcpp::XPtr<nmat_fnPtr> xpfun_H(H);
@@ -28,7 +28,7 @@ Rcpp::List ukf_nlg(const arma::mat& y, SEXP Z, SEXP H,
   arma::cube Pt(model.m, model.m, model.n + 1);
   arma::cube Ptt(model.m, model.m, model.n);
   
-  double logLik = model.ukf(at, att, Pt, Ptt, alpha, beta, kappa);
+  double logLik = model.ukf(at, att, Pt, Ptt, alpha, beta, kappa, n_threads);
   
   arma::inplace_trans(at);
   arma::inplace_trans(att);
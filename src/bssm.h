@@ -2,8 +2,15 @@
 #define BSSM_H
 
 //#define ARMA_NO_DEBUG
+// BSSM_STANDALONE builds the numerical core against plain Armadillo, 
+// without the R headers and the Rcpp::List constructors of the models 
+// (see tools/check_core.sh)
+#ifdef BSSM_STANDALONE
+#include <armadillo>
+#else
 #include <RcppArmadillo.h>
 // [[Rcpp::depends(RcppArmadillo)]]
 // [[Rcpp::plugins(cpp11)]]
+#endif
 
 #endif
@@ -4,6 +4,17 @@
 #include "bssm.h"
 #include "distr_consts.h"
 
+namespace {
+// logarithm of the binomial coefficient
+inline double lchoose(const double n, const double k) {
+#ifdef BSSM_STANDALONE
+  return std::lgamma(n + 1) - std::lgamma(k + 1) - std::lgamma(n - k + 1);
+#else
+  return R::lchoose(n, k);
+#endif
+}
+}
+
 double norm_log_const(double sd) {
   return -0.5 * std::log(2.0 * M_PI) - std::log(sd);
 }
@@ -13,11 +24,11 @@ double poisson_log_const(double y, double u) {
 }
 
 double binomial_log_const(double y, double u) {
-  return R::lchoose(u, y);
+  return lchoose(u, y);
 }
 
 double negbin_log_const(double y, double u, double phi) {
-  return R::lchoose(y + phi - 1, y) + phi * std::log(phi) + y * std::log(u);
+  return lchoose(y + phi - 1, y) + phi * std::log(phi) + y * std::log(u);
 }
 
 
@@ -36,7 +47,7 @@ double poisson_log_const(const arma::vec& y, const arma::vec& u) {
 double binomial_log_const(const arma::vec& y, const arma::vec& u) {
   double res = 0.0;
   for(unsigned int i = 0; i < y.n_elem; i++) {
-    res += R::lchoose(u(i), y(i));
+    res += lchoose(u(i), y(i));
   }
   return res;
 }
@@ -44,31 +55,13 @@ double binomial_log_const(const arma::vec& y, const arma::vec& u) {
 double negbin_log_const(const arma::vec&  y, const arma::vec& u, double phi) {
   double res = 0.0;
   for(unsigned int i = 0; i < y.n_elem; i++) {
-    res += R::lchoose(y(i) + phi - 1, y(i)) + phi * std::log(phi) + y(i) * std::log(u(i));
+    res += lchoose(y(i) + phi - 1, y(i)) + phi * std::log(phi) + y(i) * std::log(u(i));
   }
   return res;
 }
 
 // THESE ARE NOT REALLY CONSTANT IN ALL CASES SUCH AS SVM
 double compute_const_term(const ung_ssm& model, const ugg_ssm& approx_model) {
-  
-  double const_term = 0.0;
-  switch(model.distribution) {
-  case 0 :
-    const_term = arma::uvec(arma::find_finite(model.y)).n_elem * norm_log_const(model.phi);
-    break;
-  case 1 : {
-      arma::uvec y_ind(find_finite(model.y));
-      const_term = poisson_log_const(model.y(y_ind), model.u(y_ind));
-    } break;
-  case 2 : {
-    arma::uvec y_ind(find_finite(model.y));
-    const_term = binomial_log_const(model.y(y_ind), model.u(y_ind));
-  } break;
-  case 3 : {
-    arma::uvec y_ind(find_finite(model.y));
-    const_term = negbin_log_const(model.y(y_ind), model.u(y_ind), model.phi);
-  } break;
-  }
-  return const_term - norm_log_const(approx_model.y, approx_model.H);
-}
\ No newline at end of file
+  return model.log_obs_const() - norm_log_const(approx_model.y, approx_model.H);
+}
+
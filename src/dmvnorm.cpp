@@ -84,3 +84,34 @@ double fast_dmvnorm(const arma::vec& x, const arma::vec& mean,
   return constant - 0.5 * arma::accu(tmp % tmp);
 }
 
+
+dmvnorm_factor::dmvnorm_factor(const arma::mat& sigma, const bool lwr, 
+  const arma::uvec& obs) : constant(-std::numeric_limits<double>::infinity()) {
+  
+  unsigned int p = obs.n_elem;
+  if (lwr && p == sigma.n_rows) {
+    rows = arma::find(sigma.diag() > (std::numeric_limits<double>::epsilon() * p * sigma.diag().max()));
+    W = arma::inv(arma::trimatl(sigma(rows, rows)));
+    constant = -0.5 * rows.n_elem * std::log(2.0 * M_PI) + arma::accu(arma::log(W.diag()));
+  } else {
+    arma::mat U(p, p);
+    arma::mat V(p, p);
+    arma::vec s(p);
+    bool success;
+    if (lwr) {
+      arma::mat sigma2 = sigma * sigma.t();
+      success = arma::svd_econ(U, s, V, sigma2(obs, obs), "left");
+    } else {
+      success = arma::svd_econ(U, s, V, sigma(obs, obs), "left");
+    }
+    rows = obs;
+    if (success) {
+      arma::uvec nonzero = arma::find(s > (std::numeric_limits<double>::epsilon() * p * s(0)));
+      // x' U diag(1/s) U' x = |diag(1/sqrt(s)) U' x|^2
+      W = arma::diagmat(1.0 / arma::sqrt(s(nonzero))) * U.cols(nonzero).t();
+      constant = -0.5 * (nonzero.n_elem * std::log(2.0 * M_PI) + arma::accu(arma::log(s(nonzero))));
+    } else {
+      W.zeros(0, p);
+    }
+  }
+}
@@ -9,4 +9,27 @@ double precompute_dmvnorm(const arma::mat& sigma, arma::mat& Linv,
   const arma::uvec& nonzero);
 double fast_dmvnorm(const arma::vec& x, const arma::vec& mean, 
   const arma::mat& Linv, const arma::uvec& nonzero, const double constant);
+
+// factorisation of a covariance matrix for repeated evaluation of the
+// log-density with the same covariance, giving the same values as dmvnorm
+// with the corresponding arguments
+class dmvnorm_factor {
+  
+public:
+  
+  dmvnorm_factor() : constant(0.0) {}
+  // sigma is the lower triangular factor if lwr is true, otherwise the 
+  // covariance matrix, and obs are the indices of the observed elements of x
+  dmvnorm_factor(const arma::mat& sigma, const bool lwr, const arma::uvec& obs);
+  
+  double logpdf(const arma::vec& x, const arma::vec& mean) const {
+    arma::vec tmp = W * (x.rows(rows) - mean.rows(rows));
+    return constant - 0.5 * arma::dot(tmp, tmp);
+  }
+  
+private:
+  arma::mat W;
+  arma::uvec rows;
+  double constant;
+};
 #endif
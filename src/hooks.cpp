@@ -0,0 +1,45 @@
+#include <stdexcept>
+#include "hooks.h"
+#include "bssm.h"
+
+namespace {
+
+#ifdef BSSM_STANDALONE
+void r_interrupt() {
+}
+
+void r_error(const std::string& msg) {
+  throw std::runtime_error(msg);
+}
+#else
+void r_interrupt() {
+  Rcpp::checkUserInterrupt();
+}
+
+void r_error(const std::string& msg) {
+  Rcpp::stop(msg);
+}
+#endif
+
+interrupt_hook interrupt_handler = r_interrupt;
+error_hook error_handler = r_error;
+
+}
+
+void set_interrupt_hook(interrupt_hook hook) {
+  interrupt_handler = hook ? hook : r_interrupt;
+}
+
+void set_error_hook(error_hook hook) {
+  error_handler = hook ? hook : r_error;
+}
+
+void check_interrupt() {
+  interrupt_handler();
+}
+
+void stop_error(const std::string& msg) {
+  error_handler(msg);
+  // the handler is expected to throw, but make sure we do not continue
+  throw std::runtime_error(msg);
+}
@@ -0,0 +1,24 @@
+// interrupt and error hooks of the numerical core
+// by default these call Rcpp::checkUserInterrupt and Rcpp::stop (in the 
+// BSSM_STANDALONE build, do nothing and throw std::runtime_error), but other 
+// front-ends can install their own handlers so that the algorithms do not 
+// need to call R directly
+
+#ifndef HOOKS_H
+#define HOOKS_H
+
+#include <string>
+
+typedef void (*interrupt_hook)();
+typedef void (*error_hook)(const std::string& msg);
+
+// replace the handlers, null pointer restores the default (R) handler
+void set_interrupt_hook(interrupt_hook hook);
+void set_error_hook(error_hook hook);
+
+// called periodically from long running loops, may throw
+void check_interrupt();
+// signal an error, never returns
+[[noreturn]] void stop_error(const std::string& msg);
+
+#endif
@@ -1,46 +1,114 @@
-#include <boost/function.hpp>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include <boost/math/distributions/normal.hpp>
-#include <boost/math/tools/roots.hpp>
 #include "bssm.h"
 
-struct objective_gaussian {
-  objective_gaussian(const arma::vec& means, const arma::vec& sds, double prob) : 
-  means(means), sds(sds), prob(prob) {}
+// CDF of the Gaussian mixture with the given means, standard deviations and 
+// weights (summing to one), together with its derivative (the mixture density)
+struct mixture_cdf {
+  mixture_cdf(const double* means, const double* sds, const double* weights, 
+    const unsigned int n) : 
+  means(means), sds(sds), weights(weights), n(n) {}
   
-  double operator()(double b) const {
-    return Rcpp::sum(Rcpp::pnorm(Rcpp::as<Rcpp::NumericVector>(Rcpp::wrap((b - means)/sds))))/means.n_elem - prob;
+  void operator()(const double b, double& cdf, double& pdf) const {
+    cdf = 0.0;
+    pdf = 0.0;
+    for (unsigned int i = 0; i < n; i++) {
+      if (sds[i] > 0) {
+        double z = (b - means[i]) / sds[i];
+        cdf += weights[i] * 0.5 * std::erfc(-z * M_SQRT1_2);
+        pdf += weights[i] * std::exp(-0.5 * z * z) / sds[i];
+      } else {
+        cdf += weights[i] * (b >= means[i]);
+      }
+    }
+    pdf /= std::sqrt(2.0 * M_PI);
   }
   
 private:
-  arma::vec means;
-  arma::vec sds;
-  double prob;
+  const double* means;
+  const double* sds;
+  const double* weights;
+  const unsigned int n;
 };
 
+// find the quantile of the mixture within [lower, upper] using Newton 
+// iterations, falling back to bisection when the Newton step leaves the 
+// current bracket or the density is zero
+double mixture_quantile(const mixture_cdf& f, const double prob, 
+  double lower, double upper, double x) {
+  
+  const double tol = 1e-10;
+  const unsigned int max_iter = 1000;
+  
+  double cdf, pdf;
+  for (unsigned int iter = 0; iter < max_iter; iter++) {
+    f(x, cdf, pdf);
+    double diff = cdf - prob;
+    if (diff < 0) {
+      lower = x;
+    } else {
+      upper = x;
+    }
+    if ((upper - lower) <= tol * (1.0 + std::abs(x))) break;
+    
+    double x_new = x - diff / pdf;
+    if (!(pdf > 0) || !(x_new > lower && x_new < upper)) {
+      x_new = lower + (upper - lower) / 2.0;
+    }
+    if (std::abs(x_new - x) <= tol * (1.0 + std::abs(x))) {
+      x = x_new;
+      break;
+    }
+    x = x_new;
+  }
+  return x;
+}
+
 // [[Rcpp::depends(BH)]]
 // [[Rcpp::depends(RcppArmadillo)]]
-arma::mat intervals(arma::mat& means, const arma::mat& sds, const arma::vec& probs, unsigned int n_ahead) {
- 
-  boost::math::tools::eps_tolerance<double> tol;
+// quantiles of the Gaussian mixtures defined by the columns of means and sds, 
+// the components are weighted by the counts of the posterior samples
+arma::mat intervals(const arma::mat& means, const arma::mat& sds, 
+  const arma::uvec& counts, const arma::vec& probs, unsigned int n_ahead, 
+  const unsigned int n_threads) {
+  
+  arma::vec weights = arma::conv_to<arma::vec>::from(counts) / arma::accu(counts);
+  
+  boost::math::normal normal;
+  arma::vec z(probs.n_elem);
+  for (unsigned int j = 0; j < probs.n_elem; j++) {
+    z(j) = boost::math::quantile(normal, probs(j));
+  }
   
   arma::mat intv(n_ahead, probs.n_elem);
   
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads) if(n_threads > 1)
+#endif
   for (unsigned int i = 0; i < n_ahead; i++) {
-    double lower = means.col(i).min() - 2 * sds.col(i).max();
-    double upper = means.col(i).max() + 2 * sds.col(i).max();
+    
+    mixture_cdf f(means.colptr(i), sds.colptr(i), weights.memptr(), means.n_rows);
+    
+    // moments of the mixture for the initial guess
+    double mean = arma::dot(weights, means.col(i));
+    double sd = std::sqrt(std::max(0.0, arma::dot(weights, 
+      arma::square(sds.col(i)) + arma::square(means.col(i))) - mean * mean));
+    
     for (unsigned int j = 0; j < probs.n_elem; j++) {
-      boost::uintmax_t max_iter = 1000;
-      objective_gaussian f(means.col(i), sds.col(i), probs(j));
-      std::pair<double, double> r =
-        boost::math::tools::bisect(f, lower, upper, tol, max_iter);
-      if (!tol(r.first, r.second) || (max_iter >= 1000)) {
-        max_iter = 10000;
-        r =  boost::math::tools::bisect(f, 1000 * lower, 1000 * upper, tol, max_iter);
+      // the mixture CDF is at most prob at the smallest component quantile 
+      // and at least prob at the largest one
+      arma::vec component_quantiles = means.col(i) + z(j) * sds.col(i);
+      double lower = component_quantiles.min();
+      double upper = component_quantiles.max();
+      if (upper > lower) {
+        double guess = std::min(upper, std::max(lower, mean + z(j) * sd));
+        intv(i, j) = mixture_quantile(f, probs(j), lower, upper, guess);
+      } else {
+        intv(i, j) = lower;
       }
-      intv(i, j) = r.first + (r.second - r.first) / 2.0;
-      lower = intv(i, j);
     }
-    
   }
   return intv;
 }
@@ -3,8 +3,9 @@
 
 #include "bssm.h"
 
-arma::mat intervals(arma::mat& means, const arma::mat& sds, const arma::vec& probs, 
-  unsigned int n_ahead);
+arma::mat intervals(const arma::mat& means, const arma::mat& sds, 
+  const arma::uvec& counts, const arma::vec& probs, unsigned int n_ahead, 
+  const unsigned int n_threads = 1);
 
 
 #endif
@@ -17,7 +17,7 @@ lgg_ssm::lgg_ssm(const arma::mat& y_, lmat_fnPtr Z_fn_, lmat_fnPtr H_fn_,
   engine(seed), zero_tol(1e-8) {
 }
 
-mgg_ssm lgg_ssm::build_mgg() {
+mgg_ssm lgg_ssm::build_mgg(const unsigned int n_threads) {
   
   arma::vec a1 = a1_fn(theta, known_params);
   arma::mat P1 = P1_fn(theta, known_params);
@@ -28,24 +28,8 @@ mgg_ssm lgg_ssm::build_mgg() {
   arma::mat D(p, (n - 1) * time_varying(4) + 1);
   arma::mat C(m, (n - 1) * time_varying(5) + 1);
   
-  for (unsigned int t = 0; t < Z.n_slices; t++) {
-    Z.slice(t) = Z_fn(t, theta, known_params, known_tv_params);
-  }
-  for (unsigned int t = 0; t < H.n_slices; t++) {
-    H.slice(t) = H_fn(t, theta, known_params, known_tv_params);
-  }
-  for (unsigned int t = 0; t < T.n_slices; t++) {
-    T.slice(t) = T_fn(t, theta, known_params, known_tv_params);
-  }
-  for (unsigned int t = 0; t < R.n_slices; t++) {
-    R.slice(t) = R_fn(t, theta, known_params, known_tv_params);
-  }
-  for (unsigned int t = 0; t < D.n_cols; t++) {
-    D.col(t) = D_fn(t, theta, known_params, known_tv_params);
-  }
-  for (unsigned int t = 0; t < C.n_cols; t++) {
-    C.col(t) = C_fn(t, theta, known_params, known_tv_params);
-  }
+  fill_matrices(theta, arma::uvec(8, arma::fill::ones), Z, H, T, R, D, C, n_threads);
+  mgg_theta = theta;
  
  // set seed for new RNG stream based on the original model
  std::uniform_int_distribution<> unif(0, std::numeric_limits<int>::max());
@@ -56,26 +40,118 @@ mgg_ssm lgg_ssm::build_mgg() {
   return mgg_model;
 }
 
-void lgg_ssm::update_mgg(mgg_ssm& model) {
+void lgg_ssm::update_mgg(mgg_ssm& model, const unsigned int n_threads) {
+  
+  arma::uvec components(8, arma::fill::ones);
+  // without a previous build, all the components are recomputed
+  if (mgg_theta.n_elem == theta.n_elem) {
+    if (theta_dependence.n_rows != 8 || theta_dependence.n_cols != theta.n_elem) {
+      find_dependence(model, n_threads);
+    }
+    arma::uvec changed = arma::find(theta != mgg_theta);
+    components = arma::any(theta_dependence.cols(changed), 1);
+  }
   
-  for (unsigned int t = 0; t < model.Z.n_slices; t++) {
-    model.Z.slice(t) = Z_fn(t, theta, known_params, known_tv_params);
+  fill_matrices(theta, components, model.Z, model.H, model.T, model.R, 
+    model.D, model.C, n_threads);
+  if (components(6)) {
+    model.a1 = a1_fn(theta, known_params);
   }
-  for (unsigned int t = 0; t < model.H.n_slices; t++) {
-    model.H.slice(t) = H_fn(t, theta, known_params, known_tv_params);
+  if (components(7)) {
+    model.P1 = P1_fn(theta, known_params);
   }
-  for (unsigned int t = 0; t < model.T.n_slices; t++) {
-    model.T.slice(t) = T_fn(t, theta, known_params, known_tv_params);
+  if (components(1)) {
+    model.compute_HH();
   }
-  for (unsigned int t = 0; t < model.R.n_slices; t++) {
-    model.R.slice(t) = R_fn(t, theta, known_params, known_tv_params);
+  if (components(3)) {
+    model.compute_RR();
   }
-  for (unsigned int t = 0; t < model.D.n_cols; t++) {
-    model.D.col(t) = D_fn(t, theta, known_params, known_tv_params);
+  mgg_theta = theta;
+}
+
+// the time points are independent, so a single parallel loop over t 
+// covers all the (possibly time-invariant) components
+void lgg_ssm::fill_matrices(const arma::vec& theta_, const arma::uvec& components, 
+  arma::cube& Z, arma::cube& H, arma::cube& T, arma::cube& R, 
+  arma::mat& D, arma::mat& C, const unsigned int n_threads) const {
+  
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads) if(n_threads > 1)
+#endif
+  for (unsigned int t = 0; t < n; t++) {
+    if (components(0) && t < Z.n_slices) {
+      Z.slice(t) = Z_fn(t, theta_, known_params, known_tv_params);
+    }
+    if (components(1) && t < H.n_slices) {
+      H.slice(t) = H_fn(t, theta_, known_params, known_tv_params);
+    }
+    if (components(2) && t < T.n_slices) {
+      T.slice(t) = T_fn(t, theta_, known_params, known_tv_params);
+    }
+    if (components(3) && t < R.n_slices) {
+      R.slice(t) = R_fn(t, theta_, known_params, known_tv_params);
+    }
+    if (components(4) && t < D.n_cols) {
+      D.col(t) = D_fn(t, theta_, known_params, known_tv_params);
+    }
+    if (components(5) && t < C.n_cols) {
+      C.col(t) = C_fn(t, theta_, known_params, known_tv_params);
+    }
   }
-  for (unsigned int t = 0; t < model.C.n_cols; t++) {
-    model.C.col(t) = C_fn(t, theta, known_params, known_tv_params);
+}
+
+// compare the components of model (evaluated at mgg_theta) to the ones 
+// obtained when each element of theta is perturbed in turn. A dependence 
+// which shows up only at some values of theta could be missed at a single 
+// point, so the comparison is repeated at a second point where all the 
+// elements of theta differ from mgg_theta, and the results are combined.
+void lgg_ssm::find_dependence(const mgg_ssm& model, const unsigned int n_threads) {
+  
+  theta_dependence.zeros(8, mgg_theta.n_elem);
+  probe_dependence(mgg_theta, model.Z, model.H, model.T, model.R, model.D, 
+    model.C, model.a1, model.P1, n_threads);
+  
+  arma::vec theta1 = mgg_theta + 
+    0.1 * arma::max(arma::ones(mgg_theta.n_elem), arma::abs(mgg_theta));
+  arma::cube Z(arma::size(model.Z));
+  arma::cube H(arma::size(model.H));
+  arma::cube T(arma::size(model.T));
+  arma::cube R(arma::size(model.R));
+  arma::mat D(arma::size(model.D));
+  arma::mat C(arma::size(model.C));
+  fill_matrices(theta1, arma::uvec(8, arma::fill::ones), Z, H, T, R, D, C, 
+    n_threads);
+  probe_dependence(theta1, Z, H, T, R, D, C, a1_fn(theta1, known_params), 
+    P1_fn(theta1, known_params), n_threads);
+}
+
+// Non-finite values are compared as unequal so that they are always recomputed
+void lgg_ssm::probe_dependence(const arma::vec& theta0, const arma::cube& Z0, 
+  const arma::cube& H0, const arma::cube& T0, const arma::cube& R0, 
+  const arma::mat& D0, const arma::mat& C0, const arma::vec& a10, 
+  const arma::mat& P10, const unsigned int n_threads) {
+  
+  arma::uvec components(8, arma::fill::ones);
+  arma::cube Z(arma::size(Z0));
+  arma::cube H(arma::size(H0));
+  arma::cube T(arma::size(T0));
+  arma::cube R(arma::size(R0));
+  arma::mat D(arma::size(D0));
+  arma::mat C(arma::size(C0));
+  
+  for (unsigned int j = 0; j < theta0.n_elem; j++) {
+    arma::vec theta_j = theta0;
+    theta_j(j) += 1.0e-3 * std::max(1.0, std::abs(theta_j(j)));
+    fill_matrices(theta_j, components, Z, H, T, R, D, C, n_threads);
+    theta_dependence(0, j) |= !arma::approx_equal(Z, Z0, "absdiff", 0.0);
+    theta_dependence(1, j) |= !arma::approx_equal(H, H0, "absdiff", 0.0);
+    theta_dependence(2, j) |= !arma::approx_equal(T, T0, "absdiff", 0.0);
+    theta_dependence(3, j) |= !arma::approx_equal(R, R0, "absdiff", 0.0);
+    theta_dependence(4, j) |= !arma::approx_equal(D, D0, "absdiff", 0.0);
+    theta_dependence(5, j) |= !arma::approx_equal(C, C0, "absdiff", 0.0);
+    theta_dependence(6, j) |= !arma::approx_equal(a1_fn(theta_j, known_params), 
+      a10, "absdiff", 0.0);
+    theta_dependence(7, j) |= !arma::approx_equal(P1_fn(theta_j, known_params), 
+      P10, "absdiff", 0.0);
   }
-  model.compute_HH();
-  model.compute_RR();
-}
\ No newline at end of file
+}
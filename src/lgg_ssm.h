@@ -33,8 +33,13 @@ public:
     const arma::mat& known_tv_params, const arma::uvec& time_varying, 
     const unsigned int m, const unsigned int k,  const unsigned int seed);
   
-  mgg_ssm build_mgg();
-  void update_mgg(mgg_ssm& model);
+  // construct (or update) the model matrices of the corresponding mgg_ssm, 
+  // the time points are evaluated in parallel using n_threads, so the 
+  // user-defined functions must then be thread-safe
+  mgg_ssm build_mgg(const unsigned int n_threads = 1);
+  // only the components depending on the elements of theta which have 
+  // changed since the previous build_mgg or update_mgg are recomputed
+  void update_mgg(mgg_ssm& model, const unsigned int n_threads = 1);
   // linear functions of 
   // y_t = Z(alpha_t, theta,t) + H(theta,t)*eps_t, 
   // alpha_t+1 = T(alpha_t, theta,t) + R(theta, t)*eta_t
@@ -70,6 +75,25 @@ public:
   sitmo::prng_engine engine;
   const double zero_tol;
   
+  // theta_dependence(i, j) is 1 if the component i (in order Z, H, T, R, D, C, 
+  // a1, P1) depends on theta(j). If not given, it is found in the first call 
+  // of update_mgg by perturbing each element of theta in turn at two points
+  arma::umat theta_dependence;
+  
+private:
+  // evaluate the components of the model matrices flagged in components
+  void fill_matrices(const arma::vec& theta_, const arma::uvec& components, 
+    arma::cube& Z, arma::cube& H, arma::cube& T, arma::cube& R, 
+    arma::mat& D, arma::mat& C, const unsigned int n_threads) const;
+  void find_dependence(const mgg_ssm& model, const unsigned int n_threads);
+  // add the components which change when the elements of theta0 are 
+  // perturbed, given the components evaluated at theta0
+  void probe_dependence(const arma::vec& theta0, const arma::cube& Z0, 
+    const arma::cube& H0, const arma::cube& T0, const arma::cube& R0, 
+    const arma::mat& D0, const arma::mat& C0, const arma::vec& a10, 
+    const arma::mat& P10, const unsigned int n_threads);
+  // theta corresponding to the matrices of the latest built or updated mgg_ssm
+  arma::vec mgg_theta;
 };
 
 
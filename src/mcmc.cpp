@@ -18,6 +18,8 @@
 #include "distr_consts.h"
 #include "filter_smoother.h"
 #include "summary.h"
+#include "hooks.h"
+#include "tempering.h"
 
 mcmc::mcmc(const unsigned int n_iter, const unsigned int n_burnin,
   const unsigned int n_thin, const unsigned int n, const unsigned int m,
@@ -33,7 +35,7 @@ mcmc::mcmc(const unsigned int n_iter, const unsigned int n_burnin,
   alpha_storage(arma::cube((output_type == 1) * n + 1, m, (output_type == 1) * n_samples)), 
   alphahat(arma::mat(m, (output_type == 2) * n + 1, arma::fill::zeros)), 
   Vt(arma::cube(m, m, (output_type == 2) * n + 1, arma::fill::zeros)), S(S),
-  acceptance_rate(0.0), output_type(output_type) {
+  acceptance_rate(0.0), output_type(output_type), profiler() {
 }
 
 void mcmc::trim_storage() {
@@ -53,6 +55,7 @@ template void mcmc::state_posterior(lgg_ssm model, const unsigned int n_threads)
 template <class T>
 void mcmc::state_posterior(T model, const unsigned int n_threads) {
   
+  profiler.start();
   if(n_threads > 1) {
 #ifdef _OPENMP
 #pragma omp parallel num_threads(n_threads) default(shared) firstprivate(model)
@@ -77,6 +80,7 @@ void mcmc::state_posterior(T model, const unsigned int n_threads) {
   } else {
     state_sampler(model, theta_storage, alpha_storage);
   }
+  profiler.stop(mcmc_profiler::smoothing);
 }
 
 
@@ -91,6 +95,7 @@ template void mcmc::state_summary(ugg_ar1 model, arma::mat& alphahat,
 template <class T>
 void mcmc::state_summary(T model, arma::mat& alphahat, arma::cube& Vt) {
   
+  profiler.start();
   arma::cube Valpha(model.m, model.m, model.n + 1, arma::fill::zeros);
   
   arma::vec theta = theta_storage.col(0);
@@ -117,6 +122,7 @@ void mcmc::state_summary(T model, arma::mat& alphahat, arma::cube& Vt) {
     sum_w = tmp;
   }
   Vt += Valpha / sum_w; // Var[E(alpha)] + E[Var(alpha)]
+  profiler.stop(mcmc_profiler::smoothing);
 }
 
 template <class T>
@@ -143,23 +149,24 @@ void mcmc::state_sampler<lgg_ssm>(lgg_ssm& model, const arma::mat& theta, arma::
 // run MCMC for linear-Gaussian state space model
 // target the marginal p(theta | y)
 // sample states separately given the posterior sample of theta
-template void mcmc::mcmc_gaussian(ugg_ssm model, const bool end_ram);
-template void mcmc::mcmc_gaussian(ugg_bsm model, const bool end_ram);
-template void mcmc::mcmc_gaussian(ugg_ar1 model, const bool end_ram);
-template void mcmc::mcmc_gaussian(mgg_ssm model, const bool end_ram);
+template void mcmc::mcmc_gaussian(ugg_ssm model, const bool end_ram, const unsigned int n_threads);
+template void mcmc::mcmc_gaussian(ugg_bsm model, const bool end_ram, const unsigned int n_threads);
+template void mcmc::mcmc_gaussian(ugg_ar1 model, const bool end_ram, const unsigned int n_threads);
+template void mcmc::mcmc_gaussian(mgg_ssm model, const bool end_ram, const unsigned int n_threads);
 
 template<class T>
-void mcmc::mcmc_gaussian(T model, const bool end_ram) {
+void mcmc::mcmc_gaussian(T model, const bool end_ram, 
+  const unsigned int n_threads) {
   
   arma::vec theta = model.theta;
   double logprior = model.log_prior_pdf(theta);
   double loglik = model.log_likelihood();
   
   if (!std::isfinite(logprior))
-    Rcpp::stop("Initial prior probability is not finite.");
+    stop_error("Initial prior probability is not finite.");
   
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    stop_error("Initial log-likelihood is not finite.");
   
   std::normal_distribution<> normal(0.0, 1.0);
   std::uniform_real_distribution<> unif(0.0, 1.0);
@@ -170,7 +177,7 @@ void mcmc::mcmc_gaussian(T model, const bool end_ram) {
   for (unsigned int i = 1; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -187,7 +194,10 @@ void mcmc::mcmc_gaussian(T model, const bool end_ram) {
       // update model based on the proposal
       model.update_model(theta_prop);
       // compute log-likelihood with proposed theta
+      profiler.start();
       double loglik_prop = model.log_likelihood();
+      profiler.stop(mcmc_profiler::filtering);
+      profiler.add_loglik(loglik_prop);
       //compute the acceptance probability
       // use explicit min(...) as we need this value later
       acceptance_prob = 
@@ -205,8 +215,12 @@ void mcmc::mcmc_gaussian(T model, const bool end_ram) {
         new_value = true;
         
       }
-    } else acceptance_prob = 0.0;
+    } else {
+      acceptance_prob = 0.0;
+      profiler.add_rejection();
+    }
     
+    profiler.start();
     if (i > n_burnin && n_values % n_thin == 0) {
       //new block
       if (new_value) {
@@ -219,6 +233,7 @@ void mcmc::mcmc_gaussian(T model, const bool end_ram) {
         count_storage(n_stored - 1)++;
       }
     }
+    profiler.stop(mcmc_profiler::storage);
     if (!end_ram || i <= n_burnin) {
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
     }
@@ -230,9 +245,10 @@ void mcmc::mcmc_gaussian(T model, const bool end_ram) {
 }
 
 template <>
-void mcmc::mcmc_gaussian<lgg_ssm>(lgg_ssm model, const bool end_ram) {
+void mcmc::mcmc_gaussian<lgg_ssm>(lgg_ssm model, const bool end_ram, 
+  const unsigned int n_threads) {
   
-  mgg_ssm mgg_model = model.build_mgg();
+  mgg_ssm mgg_model = model.build_mgg(n_threads);
   arma::vec theta = model.theta;
   double logprior = model.log_prior_pdf(model.theta);
   double loglik = mgg_model.log_likelihood();
@@ -246,7 +262,7 @@ void mcmc::mcmc_gaussian<lgg_ssm>(lgg_ssm model, const bool end_ram) {
   for (unsigned int i = 1; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -259,11 +275,14 @@ void mcmc::mcmc_gaussian<lgg_ssm>(lgg_ssm model, const bool end_ram) {
     // compute prior
     model.theta = theta_prop;
     double logprior_prop = model.log_prior_pdf(model.theta);
-    model.update_mgg(mgg_model);
     if (arma::is_finite(logprior_prop)) {
       
+      model.update_mgg(mgg_model, n_threads);
       // compute log-likelihood with proposed theta
+      profiler.start();
       double loglik_prop = mgg_model.log_likelihood();
+      profiler.stop(mcmc_profiler::filtering);
+      profiler.add_loglik(loglik_prop);
       //compute the acceptance probability
       // use explicit min(...) as we need this value later
       // double q = proposal(theta, theta_prop);
@@ -281,8 +300,12 @@ void mcmc::mcmc_gaussian<lgg_ssm>(lgg_ssm model, const bool end_ram) {
         new_value = true;
         
       }
-    } else acceptance_prob = 0.0;
+    } else {
+      acceptance_prob = 0.0;
+      profiler.add_rejection();
+    }
     
+    profiler.start();
     if (i > n_burnin && n_values % n_thin == 0) {
       //new block
       if (new_value) {
@@ -295,6 +318,7 @@ void mcmc::mcmc_gaussian<lgg_ssm>(lgg_ssm model, const bool end_ram) {
         count_storage(n_stored - 1)++;
       }
     }
+    profiler.stop(mcmc_profiler::storage);
     if (!end_ram || i <= n_burnin) {
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
     }
@@ -304,6 +328,385 @@ void mcmc::mcmc_gaussian<lgg_ssm>(lgg_ssm model, const bool end_ram) {
   acceptance_rate /= (n_iter - n_burnin);
 }
 
+namespace {
+// workspace of a single thread in ensemble MCMC, 
+// the model (and for lgg_ssm the corresponding mgg_ssm) updated with theta
+template <class T>
+struct gaussian_workspace {
+  gaussian_workspace(const T& model) : model(model) {}
+  double log_likelihood(const arma::vec& theta) {
+    model.update_model(theta);
+    return model.log_likelihood();
+  }
+  double log_proposal_ratio(const arma::vec& new_theta, 
+    const arma::vec& old_theta) const {
+    return model.log_proposal_ratio(new_theta, old_theta);
+  }
+  T model;
+};
+template <>
+struct gaussian_workspace<lgg_ssm> {
+  gaussian_workspace(const lgg_ssm& model_) : model(model_), 
+    mgg_model(model.build_mgg()) {}
+  double log_likelihood(const arma::vec& theta) {
+    model.theta = theta;
+    model.update_mgg(mgg_model);
+    return mgg_model.log_likelihood();
+  }
+  double log_proposal_ratio(const arma::vec& new_theta, 
+    const arma::vec& old_theta) const {
+    return 0.0;
+  }
+  lgg_ssm model;
+  mgg_ssm mgg_model;
+};
+}
+
+// run ensemble MCMC for linear-Gaussian state space model
+// using the affine-invariant stretch move of Goodman and Weare (2010)
+// The walkers are updated in two halves, each using the other half as the 
+// complementary ensemble, so that the likelihoods of the proposals of a half 
+// can be computed in parallel. The random numbers are drawn outside the 
+// parallel regions, so the results do not depend on n_threads.
+// The states of all walkers after the burn-in are stored, 
+// with a new entry only when the walker has moved since it was last stored.
+template void mcmc::ensemble_gaussian(ugg_ssm model, 
+  const unsigned int n_walkers, const unsigned int n_threads);
+template void mcmc::ensemble_gaussian(ugg_bsm model, 
+  const unsigned int n_walkers, const unsigned int n_threads);
+template void mcmc::ensemble_gaussian(ugg_ar1 model, 
+  const unsigned int n_walkers, const unsigned int n_threads);
+template void mcmc::ensemble_gaussian(mgg_ssm model, 
+  const unsigned int n_walkers, const unsigned int n_threads);
+template void mcmc::ensemble_gaussian(lgg_ssm model, 
+  const unsigned int n_walkers, const unsigned int n_threads);
+
+template<class T>
+void mcmc::ensemble_gaussian(T model, const unsigned int n_walkers, 
+  const unsigned int n_threads) {
+  
+  if (n_walkers < 2) {
+    stop_error("Ensemble MCMC needs at least two walkers.");
+  }
+  // scale parameter of the stretch move
+  const double a = 2.0;
+  
+  std::vector<gaussian_workspace<T> > workspace;
+  workspace.reserve(n_threads);
+  for (unsigned int i = 0; i < n_threads; i++) {
+    workspace.emplace_back(model);
+  }
+  
+  std::normal_distribution<> normal(0.0, 1.0);
+  std::uniform_real_distribution<> unif(0.0, 1.0);
+  
+  // initial walkers are drawn around the initial theta using S
+  arma::mat theta(n_par, n_walkers);
+  arma::vec logprior(n_walkers);
+  arma::vec loglik(n_walkers);
+  theta.col(0) = model.theta;
+  logprior(0) = model.log_prior_pdf(model.theta);
+  if (!std::isfinite(logprior(0)))
+    stop_error("Initial prior probability is not finite.");
+  loglik(0) = workspace[0].log_likelihood(model.theta);
+  if (!std::isfinite(loglik(0)))
+    stop_error("Initial log-likelihood is not finite.");
+  
+  arma::uvec valid(n_walkers, arma::fill::zeros);
+  valid(0) = 1;
+  for (unsigned int attempt = 0; attempt < 100 && !arma::all(valid); attempt++) {
+    arma::uvec candidates = arma::find(valid == 0);
+    for (unsigned int w : candidates) {
+      arma::vec u(n_par);
+      for(unsigned int j = 0; j < n_par; j++) {
+        u(j) = normal(model.engine);
+      }
+      theta.col(w) = model.theta + S * u;
+      logprior(w) = model.log_prior_pdf(theta.col(w));
+    }
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads) if(n_threads > 1)
+#endif
+    for (unsigned int i = 0; i < candidates.n_elem; i++) {
+#ifdef _OPENMP
+      unsigned int thread = omp_get_thread_num();
+#else
+      unsigned int thread = 0;
+#endif
+      unsigned int w = candidates(i);
+      if (std::isfinite(logprior(w))) {
+        loglik(w) = workspace[thread].log_likelihood(theta.col(w));
+      } else {
+        loglik(w) = -std::numeric_limits<double>::infinity();
+      }
+    }
+    for (unsigned int w : candidates) {
+      valid(w) = std::isfinite(logprior(w)) && std::isfinite(loglik(w));
+    }
+  }
+  if (!arma::all(valid)) {
+    stop_error("Could not find initial values of the walkers with finite posterior density.");
+  }
+  
+  // storage is needed for all walkers
+  theta_storage.set_size(n_par, n_samples * n_walkers);
+  posterior_storage.set_size(n_samples * n_walkers);
+  count_storage.zeros(n_samples * n_walkers);
+  // index of the latest stored entry of each walker
+  arma::uvec last_stored(n_walkers, arma::fill::zeros);
+  std::vector<bool> new_value(n_walkers, true);
+  
+  const unsigned int half = n_walkers / 2;
+  arma::mat theta_prop(n_par, n_walkers - half);
+  arma::vec logprior_prop(n_walkers - half);
+  arma::vec loglik_prop(n_walkers - half);
+  arma::vec log_z(n_walkers - half);
+  
+  for (unsigned int i = 1; i <= n_iter; i++) {
+    
+    if (i % 16 == 0) {
+      check_interrupt();
+    }
+    
+    for (unsigned int h = 0; h < 2; h++) {
+      // walkers [start, end) are updated given the rest
+      unsigned int start = h * half;
+      unsigned int end = h == 0 ? half : n_walkers;
+      unsigned int n_comp = n_walkers - (end - start);
+      std::uniform_int_distribution<unsigned int> partner(0, n_comp - 1);
+      
+      for (unsigned int w = start; w < end; w++) {
+        unsigned int j = partner(model.engine);
+        // index in the complementary half
+        j = h == 0 ? half + j : j;
+        double z = std::pow((a - 1.0) * unif(model.engine) + 1.0, 2) / a;
+        log_z(w - start) = std::log(z);
+        theta_prop.col(w - start) = theta.col(j) + z * (theta.col(w) - theta.col(j));
+        logprior_prop(w - start) = model.log_prior_pdf(theta_prop.col(w - start));
+      }
+      
+      profiler.start();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads) if(n_threads > 1)
+#endif
+      for (unsigned int w = start; w < end; w++) {
+#ifdef _OPENMP
+        unsigned int thread = omp_get_thread_num();
+#else
+        unsigned int thread = 0;
+#endif
+        if (logprior_prop(w - start) > -std::numeric_limits<double>::infinity() && 
+          !std::isnan(logprior_prop(w - start))) {
+          loglik_prop(w - start) = 
+            workspace[thread].log_likelihood(theta_prop.col(w - start));
+        } else {
+          loglik_prop(w - start) = -std::numeric_limits<double>::infinity();
+        }
+      }
+      profiler.stop(mcmc_profiler::filtering);
+      
+      for (unsigned int w = start; w < end; w++) {
+        unsigned int k = w - start;
+        if (logprior_prop(k) > -std::numeric_limits<double>::infinity() && 
+          !std::isnan(logprior_prop(k))) {
+          profiler.add_loglik(loglik_prop(k));
+          double acceptance_prob = std::min(1.0, std::exp((n_par - 1.0) * log_z(k) + 
+            loglik_prop(k) - loglik(w) + logprior_prop(k) - logprior(w) + 
+            workspace[0].log_proposal_ratio(theta_prop.col(k), theta.col(w))));
+          if (unif(model.engine) < acceptance_prob) {
+            if (i > n_burnin) {
+              acceptance_rate++;
+            }
+            loglik(w) = loglik_prop(k);
+            logprior(w) = logprior_prop(k);
+            theta.col(w) = theta_prop.col(k);
+            new_value[w] = true;
+          }
+        } else {
+          profiler.add_rejection();
+        }
+      }
+    }
+    
+    profiler.start();
+    if (i > n_burnin && (i - n_burnin) % n_thin == 0) {
+      for (unsigned int w = 0; w < n_walkers; w++) {
+        //new block
+        if (new_value[w]) {
+          posterior_storage(n_stored) = logprior(w) + loglik(w);
+          theta_storage.col(n_stored) = theta.col(w);
+          count_storage(n_stored) = 1;
+          last_stored(w) = n_stored;
+          n_stored++;
+          new_value[w] = false;
+        } else {
+          count_storage(last_stored(w))++;
+        }
+      }
+    }
+    profiler.stop(mcmc_profiler::storage);
+  }
+  
+  trim_storage();
+  acceptance_rate /= (n_walkers * (n_iter - n_burnin));
+}
+
+// run parallel tempering MCMC for linear-Gaussian state space model
+// Replica r targets p(theta) p(y | theta)^beta_r, with beta_0 = 1 for the 
+// cold chain. The random walk Metropolis updates of the replicas are run in 
+// parallel, each replica using its own random number stream and adaptive 
+// proposal, after which swaps between adjacent replicas are proposed. 
+// Only the cold chain is stored.
+template void mcmc::pt_gaussian(ugg_ssm model, const bool end_ram, 
+  const unsigned int n_temps, const double max_temp, const unsigned int n_threads);
+template void mcmc::pt_gaussian(ugg_bsm model, const bool end_ram, 
+  const unsigned int n_temps, const double max_temp, const unsigned int n_threads);
+template void mcmc::pt_gaussian(ugg_ar1 model, const bool end_ram, 
+  const unsigned int n_temps, const double max_temp, const unsigned int n_threads);
+template void mcmc::pt_gaussian(mgg_ssm model, const bool end_ram, 
+  const unsigned int n_temps, const double max_temp, const unsigned int n_threads);
+template void mcmc::pt_gaussian(lgg_ssm model, const bool end_ram, 
+  const unsigned int n_temps, const double max_temp, const unsigned int n_threads);
+
+template<class T>
+void mcmc::pt_gaussian(T model, const bool end_ram, const unsigned int n_temps, 
+  const double max_temp, const unsigned int n_threads) {
+  
+  if (n_temps < 2) {
+    stop_error("Parallel tempering needs at least two temperatures.");
+  }
+  tempering ladder(n_temps, max_temp);
+  
+  std::vector<gaussian_workspace<T> > workspace;
+  workspace.reserve(n_temps);
+  for (unsigned int r = 0; r < n_temps; r++) {
+    workspace.emplace_back(model);
+  }
+  // each replica uses its own RNG stream keyed by the common seed, 
+  // so the results do not depend on the number of threads used
+  std::uniform_int_distribution<> unif_seed(0, std::numeric_limits<int>::max());
+  const unsigned int base_seed = unif_seed(model.engine);
+  std::vector<sitmo::prng_engine> engines;
+  engines.reserve(n_temps);
+  for (unsigned int r = 0; r < n_temps; r++) {
+    engines.emplace_back(base_seed + r);
+  }
+  
+  // all replicas start from the initial theta
+  arma::mat theta(n_par, n_temps);
+  theta.each_col() = model.theta;
+  arma::vec logprior(n_temps);
+  logprior.fill(model.log_prior_pdf(model.theta));
+  if (!std::isfinite(logprior(0)))
+    stop_error("Initial prior probability is not finite.");
+  arma::vec loglik(n_temps);
+  loglik.fill(workspace[0].log_likelihood(model.theta));
+  if (!std::isfinite(loglik(0)))
+    stop_error("Initial log-likelihood is not finite.");
+  
+  std::vector<arma::mat> S_r(n_temps, S);
+  std::vector<arma::vec> u(n_temps, arma::vec(n_par));
+  arma::vec loglik_prop(n_temps);
+  arma::vec acceptance_prob(n_temps);
+  arma::uvec accepted(n_temps);
+  
+  bool new_value = true;
+  unsigned int n_values = 0;
+  for (unsigned int i = 1; i <= n_iter; i++) {
+    
+    if (i % 16 == 0) {
+      check_interrupt();
+    }
+    
+    profiler.start();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads) if(n_threads > 1)
+#endif
+    for (unsigned int r = 0; r < n_temps; r++) {
+      
+      std::normal_distribution<> normal(0.0, 1.0);
+      std::uniform_real_distribution<> unif(0.0, 1.0);
+      
+      for(unsigned int j = 0; j < n_par; j++) {
+        u[r](j) = normal(engines[r]);
+      }
+      arma::vec theta_prop = theta.col(r) + S_r[r] * u[r];
+      double logprior_prop = workspace[r].model.log_prior_pdf(theta_prop);
+      accepted(r) = 0;
+      if (logprior_prop > -std::numeric_limits<double>::infinity() && 
+        !std::isnan(logprior_prop)) {
+        loglik_prop(r) = workspace[r].log_likelihood(theta_prop);
+        acceptance_prob(r) = std::min(1.0, 
+          std::exp(ladder.beta(r) * (loglik_prop(r) - loglik(r)) + 
+          logprior_prop - logprior(r) + 
+          workspace[r].log_proposal_ratio(theta_prop, theta.col(r))));
+        if (unif(engines[r]) < acceptance_prob(r)) {
+          accepted(r) = 1;
+          loglik(r) = loglik_prop(r);
+          logprior(r) = logprior_prop;
+          theta.col(r) = theta_prop;
+        }
+      } else {
+        loglik_prop(r) = arma::datum::nan;
+        acceptance_prob(r) = 0.0;
+      }
+      if (!end_ram || i <= n_burnin) {
+        ramcmc::adapt_S(S_r[r], u[r], acceptance_prob(r), target_acceptance, i, gamma);
+      }
+    }
+    profiler.stop(mcmc_profiler::filtering);
+    
+    // counters of the cold chain
+    if (std::isnan(loglik_prop(0))) {
+      profiler.add_rejection();
+    } else {
+      profiler.add_loglik(loglik_prop(0));
+    }
+    if (accepted(0)) {
+      if (i > n_burnin) {
+        acceptance_rate++;
+        n_values++;
+      }
+      new_value = true;
+    }
+    
+    // exchange the states of the accepted pairs
+    arma::uvec swapped = ladder.swap(loglik, model.engine);
+    for (unsigned int r : swapped) {
+      theta.swap_cols(r, r + 1);
+      std::swap(loglik(r), loglik(r + 1));
+      std::swap(logprior(r), logprior(r + 1));
+      if (r == 0) {
+        if (i > n_burnin && !accepted(0)) {
+          n_values++;
+        }
+        new_value = true;
+      }
+    }
+    if (!end_ram || i <= n_burnin) {
+      ladder.adapt(i, gamma);
+    }
+    
+    profiler.start();
+    if (i > n_burnin && n_values % n_thin == 0) {
+      //new block
+      if (new_value) {
+        posterior_storage(n_stored) = logprior(0) + loglik(0);
+        theta_storage.col(n_stored) = theta.col(0);
+        count_storage(n_stored) = 1;
+        n_stored++;
+        new_value = false;
+      } else {
+        count_storage(n_stored - 1)++;
+      }
+    }
+    profiler.stop(mcmc_profiler::storage);
+  }
+  S = S_r[0];
+  trim_storage();
+  acceptance_rate /= (n_iter - n_burnin);
+}
+
 
 // run pseudo-marginal MCMC for non-linear and/or non-Gaussian state space model
 // using psi-PF
@@ -333,7 +736,7 @@ void mcmc::pm_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
   // compute the log[p(theta)]
   double logprior = model.log_prior_pdf(theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    stop_error("Initial prior probability is not finite.");
   }
   // construct the approximate Gaussian model
   arma::vec mode_estimate = initial_mode;
@@ -343,7 +746,7 @@ void mcmc::pm_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
   double gaussian_loglik = approx_model.log_likelihood();
   
   if (!std::isfinite(gaussian_loglik))
-    Rcpp::stop("Initial gaussian log-likelihood is not finite.");
+    stop_error("Initial gaussian log-likelihood is not finite.");
   
   // compute unnormalized mode-based correction terms
   // log[g(y_t | ^alpha_t) / ~g(y_t | ^alpha_t)]
@@ -368,17 +771,23 @@ void mcmc::pm_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
   double ll_w = std::log(arma::accu(weights) / nsim_states);
   double loglik = gaussian_loglik + const_term + sum_scales + ll_w;
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    stop_error("Initial log-likelihood is not finite.");
   double acceptance_prob = 0.0;
   bool new_value = true;
   unsigned int n_values = 0;
   std::normal_distribution<> normal(0.0, 1.0);
   std::uniform_real_distribution<> unif(0.0, 1.0);
+  // smoothed states and Ft, Kt, Lt of the approximating model, 
+  // reused in simulation smoothing
+  arma::mat approx_alphahat(m, n + 1);
+  arma::vec approx_Ft(n);
+  arma::mat approx_Kt(m, n);
+  arma::cube approx_Lt(m, m, n);
   
   for (unsigned int i = 1; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -396,12 +805,15 @@ void mcmc::pm_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
       // update parameters
       model.update_model(theta_prop);
       
+      profiler.start();
       if (local_approx) {
         // construct the approximate Gaussian model
         mode_estimate = initial_mode;
-        model.approximate(approx_model, mode_estimate, max_iter, conv_tol);
+        gaussian_loglik = model.approximate(approx_model, mode_estimate, max_iter, conv_tol, 
+          approx_alphahat, approx_Ft, approx_Kt, approx_Lt);
       } else {
-        model.approximate(approx_model, mode_estimate, 0, conv_tol);
+        gaussian_loglik = model.approximate(approx_model, mode_estimate, 0, conv_tol, 
+          approx_alphahat, approx_Ft, approx_Kt, approx_Lt);
       }
       // compute unnormalized mode-based correction terms
       // log[g(y_t | ^alpha_t) / ~g(y_t | ^alpha_t)]
@@ -409,13 +821,19 @@ void mcmc::pm_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
       sum_scales = arma::accu(scales);
       // compute the constant term
       const_term = compute_const_term(model, approx_model);
+      profiler.stop(mcmc_profiler::approximation);
+      profiler.add_approx_iter(model.approx_iter);
       
-      alpha = approx_model.simulate_states(nsim_states, true);
+      profiler.start();
+      alpha = approx_model.simulate_states(nsim_states, true, approx_alphahat, 
+        approx_Ft, approx_Kt, approx_Lt);
       weights = arma::exp(model.importance_weights(approx_model, alpha) - sum_scales);
       ll_w = std::log(arma::accu(weights) / nsim_states);
+      profiler.stop(mcmc_profiler::filtering);
+      profiler.add_filter(weights);
+      profiler.add_loglik(ll_w);
       
-      double loglik_prop =
-        approx_model.log_likelihood() + const_term + sum_scales + ll_w;
+      double loglik_prop = gaussian_loglik + const_term + sum_scales + ll_w;
       
       //compute the acceptance probability
       // use explicit min(...) as we need this value later
@@ -430,6 +848,7 @@ void mcmc::pm_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
           n_values++;
         }
         if (output_type != 3) {
+          profiler.start();
           if (output_type == 1) {
             std::discrete_distribution<unsigned int> sample(weights.begin(), weights.end());
             sampled_alpha = alpha.slice(ind);
@@ -437,6 +856,7 @@ void mcmc::pm_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
             //summary statistics for single iteration
             weighted_summary(alpha, alphahat_i, Vt_i, weights);
           }
+          profiler.stop(mcmc_profiler::smoothing);
         }
         loglik = loglik_prop;
         logprior = logprior_prop;
@@ -444,8 +864,12 @@ void mcmc::pm_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
         new_value = true;
         
       }
-    } else acceptance_prob = 0.0;
+    } else {
+      acceptance_prob = 0.0;
+      profiler.add_rejection();
+    }
     
+    profiler.start();
     // note: thinning does not affect this
     if (i > n_burnin && output_type == 2) {
       arma::mat diff = alphahat_i - alphahat;
@@ -471,6 +895,7 @@ void mcmc::pm_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
         count_storage(n_stored - 1)++;
       }
     }
+    profiler.stop(mcmc_profiler::storage);
     
     if (!end_ram || i <= n_burnin) {
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
@@ -512,7 +937,7 @@ void mcmc::pm_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
   // compute the log[p(theta)]
   double logprior = model.log_prior_pdf(theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    stop_error("Initial prior probability is not finite.");
   }
   // construct the approximate Gaussian model
   arma::vec mode_estimate = initial_mode;
@@ -537,7 +962,7 @@ void mcmc::pm_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
   double loglik = model.psi_filter(approx_model, approx_loglik, scales,
     nsim_states, alpha, weights, indices);
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    stop_error("Initial log-likelihood is not finite.");
   
   filter_smoother(alpha, indices);
   arma::vec w = weights.col(n);
@@ -556,7 +981,7 @@ void mcmc::pm_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
   for (unsigned int i = 1; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -574,12 +999,13 @@ void mcmc::pm_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
       // update parameters
       model.update_model(theta_prop);
       
+      profiler.start();
       if (local_approx) {
         // construct the approximate Gaussian model
         mode_estimate = initial_mode;
-        model.approximate(approx_model, mode_estimate, max_iter, conv_tol);
+        gaussian_loglik = model.approximate(approx_model, mode_estimate, max_iter, conv_tol);
       } else {
-        model.approximate(approx_model, mode_estimate, 0, conv_tol);
+        gaussian_loglik = model.approximate(approx_model, mode_estimate, 0, conv_tol);
       }
       // compute unnormalized mode-based correction terms
       // log[g(y_t | ^alpha_t) / ~g(y_t | ^alpha_t)]
@@ -587,12 +1013,16 @@ void mcmc::pm_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
       sum_scales = arma::accu(scales);
       // compute the constant term
       const_term = compute_const_term(model, approx_model);
-      // compute the log-likelihood of the approximate model
-      gaussian_loglik = approx_model.log_likelihood();
+      profiler.stop(mcmc_profiler::approximation);
+      profiler.add_approx_iter(model.approx_iter);
       approx_loglik = gaussian_loglik + const_term + sum_scales;
       
+      profiler.start();
       double loglik_prop = model.psi_filter(approx_model, approx_loglik, scales,
         nsim_states, alpha, weights, indices);
+      profiler.stop(mcmc_profiler::filtering);
+      profiler.add_filter(weights);
+      profiler.add_loglik(loglik_prop);
       
       //compute the acceptance probability
       // use explicit min(...) as we need this value later
@@ -609,6 +1039,7 @@ void mcmc::pm_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
           n_values++;
         }
         if (output_type != 3) {
+          profiler.start();
           filter_smoother(alpha, indices);
           w = weights.col(n);
           if (output_type == 1) {
@@ -617,6 +1048,7 @@ void mcmc::pm_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
           } else {
             weighted_summary(alpha, alphahat_i, Vt_i, w);
           }
+          profiler.stop(mcmc_profiler::smoothing);
         }
         loglik = loglik_prop;
         logprior = logprior_prop;
@@ -624,8 +1056,12 @@ void mcmc::pm_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
         new_value = true;
         
       }
-    } else acceptance_prob = 0.0;
+    } else {
+      acceptance_prob = 0.0;
+      profiler.add_rejection();
+    }
     
+    profiler.start();
     // note: thinning does not affect this
     if (i > n_burnin && output_type == 2) {
       arma::mat diff = alphahat_i - alphahat;
@@ -651,6 +1087,7 @@ void mcmc::pm_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
         count_storage(n_stored - 1)++;
       }
     }
+    profiler.stop(mcmc_profiler::storage);
     
     if (!end_ram || i <= n_burnin) {
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
@@ -686,14 +1123,14 @@ void mcmc::pm_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
   // compute the log[p(theta)]
   double logprior = model.log_prior_pdf(theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    stop_error("Initial prior probability is not finite.");
   }
   arma::cube alpha(m, n + 1, nsim_states);
   arma::mat weights(nsim_states, n + 1);
   arma::umat indices(nsim_states, n);
   double loglik = model.bsf_filter(nsim_states, alpha, weights, indices);
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    stop_error("Initial log-likelihood is not finite.");
   filter_smoother(alpha, indices);
   arma::vec w = weights.col(n);
   std::discrete_distribution<unsigned int> sample0(w.begin(), w.end());
@@ -712,7 +1149,7 @@ void mcmc::pm_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
   for (unsigned int i = 1; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -730,7 +1167,11 @@ void mcmc::pm_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
       // update parameters
       model.update_model(theta_prop);
       
+      profiler.start();
       double loglik_prop = model.bsf_filter(nsim_states, alpha, weights, indices);
+      profiler.stop(mcmc_profiler::filtering);
+      profiler.add_filter(weights);
+      profiler.add_loglik(loglik_prop);
       
       //compute the acceptance probability
       // use explicit min(...) as we need this value later
@@ -747,6 +1188,7 @@ void mcmc::pm_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
           n_values++;
         }
         if (output_type != 3) {
+          profiler.start();
           filter_smoother(alpha, indices);
           w = weights.col(n);
           if (output_type == 1) {
@@ -755,14 +1197,19 @@ void mcmc::pm_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
           } else {
             weighted_summary(alpha, alphahat_i, Vt_i, w);
           }
+          profiler.stop(mcmc_profiler::smoothing);
         }
         loglik = loglik_prop;
         logprior = logprior_prop;
         theta = theta_prop;
         new_value = true;
       }
-    } else acceptance_prob = 0.0;
+    } else {
+      acceptance_prob = 0.0;
+      profiler.add_rejection();
+    }
     
+    profiler.start();
     // note: thinning does not affect this
     if (i > n_burnin && output_type == 2) {
       arma::mat diff = alphahat_i - alphahat;
@@ -788,6 +1235,7 @@ void mcmc::pm_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
         count_storage(n_stored - 1)++;
       }
     }
+    profiler.stop(mcmc_profiler::storage);
     
     if (!end_ram || i <= n_burnin) {
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
@@ -828,7 +1276,7 @@ void mcmc::da_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
   // compute the log[p(theta)]
   double logprior = model.log_prior_pdf(theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    stop_error("Initial prior probability is not finite.");
   }
   // construct the approximate Gaussian model
   arma::vec mode_estimate = initial_mode;
@@ -860,16 +1308,22 @@ void mcmc::da_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
   double ll_w = std::log(arma::accu(weights) / nsim_states);
   double loglik = gaussian_loglik + const_term + sum_scales + ll_w;
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    stop_error("Initial log-likelihood is not finite.");
   double acceptance_prob = 0.0;
   bool new_value = true;
   unsigned int n_values = 0;
   std::normal_distribution<> normal(0.0, 1.0);
   std::uniform_real_distribution<> unif(0.0, 1.0);
+  // smoothed states and Ft, Kt, Lt of the approximating model, 
+  // reused in simulation smoothing
+  arma::mat approx_alphahat(m, n + 1);
+  arma::vec approx_Ft(n);
+  arma::mat approx_Kt(m, n);
+  arma::cube approx_Lt(m, m, n);
   for (unsigned int i = 1; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -887,12 +1341,15 @@ void mcmc::da_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
       // update parameters
       model.update_model(theta_prop);
       
+      profiler.start();
       if (local_approx) {
         // construct the approximate Gaussian model
         mode_estimate = initial_mode;
-        model.approximate(approx_model, mode_estimate, max_iter, conv_tol);
+        gaussian_loglik = model.approximate(approx_model, mode_estimate, max_iter, conv_tol, 
+          approx_alphahat, approx_Ft, approx_Kt, approx_Lt);
       } else {
-        model.approximate(approx_model, mode_estimate, 0, conv_tol);
+        gaussian_loglik = model.approximate(approx_model, mode_estimate, 0, conv_tol, 
+          approx_alphahat, approx_Ft, approx_Kt, approx_Lt);
       }
       // compute unnormalized mode-based correction terms
       // log[g(y_t | ^alpha_t) / ~g(y_t | ^alpha_t)]
@@ -900,8 +1357,8 @@ void mcmc::da_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
       sum_scales = arma::accu(scales);
       // compute the constant term
       const_term = compute_const_term(model, approx_model);
-      // compute the log-likelihood of the approximate model
-      gaussian_loglik = approx_model.log_likelihood();
+      profiler.stop(mcmc_profiler::approximation);
+      profiler.add_approx_iter(model.approx_iter);
       double approx_loglik_prop = gaussian_loglik + const_term + sum_scales;
       
       // stage 1 acceptance probability, used in RAM as well
@@ -912,9 +1369,14 @@ void mcmc::da_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
       // initial acceptance
       if (unif(model.engine) < acceptance_prob) {
         
-        alpha = approx_model.simulate_states(nsim_states, true);
+        profiler.start();
+        alpha = approx_model.simulate_states(nsim_states, true, approx_alphahat, 
+          approx_Ft, approx_Kt, approx_Lt);
         weights = arma::exp(model.importance_weights(approx_model, alpha) - sum_scales);
         double ll_w_prop = std::log(arma::accu(weights) / nsim_states);
+        profiler.stop(mcmc_profiler::filtering);
+        profiler.add_filter(weights);
+        profiler.add_loglik(ll_w_prop);
         
         //just in case
         if(std::isfinite(ll_w_prop)) {
@@ -927,6 +1389,7 @@ void mcmc::da_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
               n_values++;
             }
             if (output_type != 3) {
+              profiler.start();
               if (output_type == 1) {
                 std::discrete_distribution<unsigned int> sample(weights.begin(), weights.end());
                 sampled_alpha = alpha.slice(sample(model.engine));
@@ -934,6 +1397,7 @@ void mcmc::da_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
                 //summary statistics for single iteration
                 weighted_summary(alpha, alphahat_i, Vt_i, weights);
               }
+              profiler.stop(mcmc_profiler::smoothing);
             }
             approx_loglik = approx_loglik_prop;
             loglik = approx_loglik + ll_w_prop;
@@ -944,8 +1408,12 @@ void mcmc::da_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
           }
         }
       }
-    } else acceptance_prob = 0.0;
+    } else {
+      acceptance_prob = 0.0;
+      profiler.add_rejection();
+    }
     
+    profiler.start();
     // note: thinning does not affect this
     if (i > n_burnin && output_type == 2) {
       arma::mat diff = alphahat_i - alphahat;
@@ -971,6 +1439,7 @@ void mcmc::da_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
         count_storage(n_stored - 1)++;
       }
     }
+    profiler.stop(mcmc_profiler::storage);
     
     if (!end_ram || i <= n_burnin) {
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
@@ -1011,7 +1480,7 @@ void mcmc::da_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
   // compute the log[p(theta)]
   double logprior = model.log_prior_pdf(theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    stop_error("Initial prior probability is not finite.");
   }
   // construct the approximate Gaussian model
   arma::vec mode_estimate = initial_mode;
@@ -1035,7 +1504,7 @@ void mcmc::da_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
   double loglik = model.psi_filter(approx_model, approx_loglik, scales,
     nsim_states, alpha, weights, indices);
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    stop_error("Initial log-likelihood is not finite.");
   filter_smoother(alpha, indices);
   arma::vec w = weights.col(n);
   std::discrete_distribution<unsigned int> sample0(w.begin(), w.end());
@@ -1052,7 +1521,7 @@ void mcmc::da_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
   for (unsigned int i = 1; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -1070,12 +1539,13 @@ void mcmc::da_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
       // update parameters
       model.update_model(theta_prop);
       
+      profiler.start();
       if (local_approx) {
         // construct the approximate Gaussian model
         mode_estimate = initial_mode;
-        model.approximate(approx_model, mode_estimate, max_iter, conv_tol);
+        gaussian_loglik = model.approximate(approx_model, mode_estimate, max_iter, conv_tol);
       } else {
-        model.approximate(approx_model, mode_estimate, 0, conv_tol);
+        gaussian_loglik = model.approximate(approx_model, mode_estimate, 0, conv_tol);
       }
       // compute unnormalized mode-based correction terms
       // log[g(y_t | ^alpha_t) / ~g(y_t | ^alpha_t)]
@@ -1083,8 +1553,8 @@ void mcmc::da_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
       sum_scales = arma::accu(scales);
       // compute the constant term
       const_term = compute_const_term(model, approx_model);
-      // compute the log-likelihood of the approximate model
-      gaussian_loglik = approx_model.log_likelihood();
+      profiler.stop(mcmc_profiler::approximation);
+      profiler.add_approx_iter(model.approx_iter);
       double approx_loglik_prop = gaussian_loglik + const_term + sum_scales;
       
       // stage 1 acceptance probability, used in RAM as well
@@ -1095,8 +1565,12 @@ void mcmc::da_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
       // initial acceptance
       if (unif(model.engine) < acceptance_prob) {
         
+        profiler.start();
         double loglik_prop = model.psi_filter(approx_model, approx_loglik_prop, scales,
           nsim_states, alpha, weights, indices);
+        profiler.stop(mcmc_profiler::filtering);
+        profiler.add_filter(weights);
+        profiler.add_loglik(loglik_prop);
         
         //just in case
         if(std::isfinite(loglik_prop)) {
@@ -1109,6 +1583,7 @@ void mcmc::da_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
               n_values++;
             }
             if (output_type != 3) {
+              profiler.start();
               filter_smoother(alpha, indices);
               w = weights.col(n);
               if (output_type == 1) {
@@ -1117,6 +1592,7 @@ void mcmc::da_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
               } else {
                 weighted_summary(alpha, alphahat_i, Vt_i, w);
               }
+              profiler.stop(mcmc_profiler::smoothing);
             }
             approx_loglik = approx_loglik_prop;
             loglik = loglik_prop;
@@ -1126,8 +1602,12 @@ void mcmc::da_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
           }
         }
       }
-    } else acceptance_prob = 0.0;
+    } else {
+      acceptance_prob = 0.0;
+      profiler.add_rejection();
+    }
     
+    profiler.start();
     // note: thinning does not affect this
     if (i > n_burnin && output_type == 2) {
       arma::mat diff = alphahat_i - alphahat;
@@ -1153,6 +1633,7 @@ void mcmc::da_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
         count_storage(n_stored - 1)++;
       }
     }
+    profiler.stop(mcmc_profiler::storage);
     
     if (!end_ram || i <= n_burnin) {
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
@@ -1192,7 +1673,7 @@ void mcmc::da_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
   // compute the log[p(theta)]
   double logprior = model.log_prior_pdf(theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    stop_error("Initial prior probability is not finite.");
   }
   // construct the approximate Gaussian model
   arma::vec mode_estimate = initial_mode;
@@ -1215,7 +1696,7 @@ void mcmc::da_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
   arma::umat indices(nsim_states, n);
   double loglik = model.bsf_filter(nsim_states, alpha, weights, indices);
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    stop_error("Initial log-likelihood is not finite.");
   filter_smoother(alpha, indices);
   arma::vec w = weights.col(n);
   std::discrete_distribution<unsigned int> sample0(w.begin(), w.end());
@@ -1233,7 +1714,7 @@ void mcmc::da_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
   for (unsigned int i = 1; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -1251,12 +1732,13 @@ void mcmc::da_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
       // update parameters
       model.update_model(theta_prop);
       
+      profiler.start();
       if (local_approx) {
         // construct the approximate Gaussian model
         mode_estimate = initial_mode;
-        model.approximate(approx_model, mode_estimate, max_iter, conv_tol);
+        gaussian_loglik = model.approximate(approx_model, mode_estimate, max_iter, conv_tol);
       } else {
-        model.approximate(approx_model, mode_estimate, 0, conv_tol);
+        gaussian_loglik = model.approximate(approx_model, mode_estimate, 0, conv_tol);
       }
       // compute unnormalized mode-based correction terms
       // log[g(y_t | ^alpha_t) / ~g(y_t | ^alpha_t)]
@@ -1264,8 +1746,8 @@ void mcmc::da_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
       sum_scales = arma::accu(scales);
       // compute the constant term
       const_term = compute_const_term(model, approx_model);
-      // compute the log-likelihood of the approximate model
-      gaussian_loglik = approx_model.log_likelihood();
+      profiler.stop(mcmc_profiler::approximation);
+      profiler.add_approx_iter(model.approx_iter);
       double approx_loglik_prop = gaussian_loglik + const_term + sum_scales;
       
       // stage 1 acceptance probability, used in RAM as well
@@ -1276,7 +1758,11 @@ void mcmc::da_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
       // initial acceptance
       if (unif(model.engine) < acceptance_prob) {
         
+        profiler.start();
         double loglik_prop = model.bsf_filter(nsim_states, alpha, weights, indices);
+        profiler.stop(mcmc_profiler::filtering);
+        profiler.add_filter(weights);
+        profiler.add_loglik(loglik_prop);
         
         //just in case
         if(std::isfinite(loglik_prop)) {
@@ -1288,6 +1774,7 @@ void mcmc::da_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
               n_values++;
             }
             if (output_type != 3) {
+              profiler.start();
               filter_smoother(alpha, indices);
               w = weights.col(n);
               if (output_type == 1) {
@@ -1296,6 +1783,7 @@ void mcmc::da_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
               } else {
                 weighted_summary(alpha, alphahat_i, Vt_i, w);
               }
+              profiler.stop(mcmc_profiler::smoothing);
             }
             approx_loglik = approx_loglik_prop;
             loglik = loglik_prop;
@@ -1305,8 +1793,12 @@ void mcmc::da_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
           }
         }
       }
-    } else acceptance_prob = 0.0;
+    } else {
+      acceptance_prob = 0.0;
+      profiler.add_rejection();
+    }
     
+    profiler.start();
     // note: thinning does not affect this
     if (i > n_burnin && output_type == 2) {
       arma::mat diff = alphahat_i - alphahat;
@@ -1332,6 +1824,7 @@ void mcmc::da_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
         count_storage(n_stored - 1)++;
       }
     }
+    profiler.stop(mcmc_profiler::storage);
     
     if (!end_ram || i <= n_burnin) {
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
@@ -1348,20 +1841,22 @@ void mcmc::da_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
 // using psi-PF
 void mcmc::pm_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
   const unsigned int nsim_states, const unsigned int max_iter,
-  const double conv_tol, const unsigned int iekf_iter) {
+  const double conv_tol, const unsigned int iekf_iter, 
+  const unsigned int n_threads) {
   
   unsigned int m = model.m;
   unsigned n = model.n;
   // compute the log[p(theta)]
   double logprior = model.log_prior_pdf(model.theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    stop_error("Initial prior probability is not finite.");
   }
   // construct the approximate Gaussian model
   arma::mat mode_estimate(m, n);
-  mgg_ssm approx_model0 = model.approximate(mode_estimate, max_iter, conv_tol, iekf_iter);
+  mgg_ssm approx_model0 = model.approximate(mode_estimate, max_iter, conv_tol, iekf_iter, 
+    n_threads);
   if(!arma::is_finite(mode_estimate)) {
-    Rcpp::stop("Approximation did not converge. ");
+    stop_error("Approximation did not converge. ");
   }
   // compute the log-likelihood of the gaussian model
   double gaussian_loglik = approx_model0.log_likelihood();
@@ -1373,7 +1868,7 @@ void mcmc::pm_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
   double loglik = model.psi_filter(approx_model0, gaussian_loglik,
     nsim_states, alpha, weights, indices);
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    stop_error("Initial log-likelihood is not finite.");
   filter_smoother(alpha, indices);
   arma::vec w = weights.col(n);
   std::discrete_distribution<unsigned int> sample0(w.begin(), w.end());
@@ -1392,7 +1887,7 @@ void mcmc::pm_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
   for (unsigned int i = 1; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -1414,15 +1909,24 @@ void mcmc::pm_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
       
       double loglik_prop;
       // construct the approximate Gaussian model
-      mgg_ssm approx_model = model.approximate(mode_estimate, max_iter, conv_tol, iekf_iter);
+      profiler.start();
+      mgg_ssm approx_model = model.approximate(mode_estimate, max_iter, conv_tol, iekf_iter, 
+        n_threads);
+      profiler.stop(mcmc_profiler::approximation);
+      profiler.add_approx_iter(model.approx_iter);
       if(!arma::is_finite(mode_estimate)) {
         gaussian_loglik = -std::numeric_limits<double>::infinity();
         loglik_prop = -std::numeric_limits<double>::infinity();
+        profiler.add_loglik(loglik_prop);
       } else {
         // compute the log-likelihood of the approximate model
         gaussian_loglik = approx_model.log_likelihood();
+        profiler.start();
         loglik_prop = model.psi_filter(approx_model, gaussian_loglik,
           nsim_states, alpha, weights, indices);
+        profiler.stop(mcmc_profiler::filtering);
+        profiler.add_filter(weights);
+        profiler.add_loglik(loglik_prop);
       }
       //compute the acceptance probability
       // use explicit min(...) as we need this value later
@@ -1441,6 +1945,7 @@ void mcmc::pm_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
           n_values++;
         }
         if (output_type != 3) {
+          profiler.start();
           filter_smoother(alpha, indices);
           w = weights.col(n);
           if (output_type == 1) {
@@ -1449,14 +1954,19 @@ void mcmc::pm_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
           } else {
             weighted_summary(alpha, alphahat_i, Vt_i, w);
           }
+          profiler.stop(mcmc_profiler::smoothing);
         }
         loglik = loglik_prop;
         logprior = logprior_prop;
         theta = theta_prop;
         new_value = true;
       }
-    } else acceptance_prob = 0.0;
+    } else {
+      acceptance_prob = 0.0;
+      profiler.add_rejection();
+    }
     
+    profiler.start();
     // note: thinning does not affect this
     if (i > n_burnin && output_type == 2) {
       arma::mat diff = alphahat_i - alphahat;
@@ -1482,6 +1992,7 @@ void mcmc::pm_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
         count_storage(n_stored - 1)++;
       }
     }
+    profiler.stop(mcmc_profiler::storage);
     
     if (!end_ram || i <= n_burnin) {
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
@@ -1503,7 +2014,7 @@ void mcmc::pm_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram,
   // compute the log[p(theta)]
   double logprior = model.log_prior_pdf(model.theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    stop_error("Initial prior probability is not finite.");
   }
   
   arma::cube alpha(m, n + 1, nsim_states);
@@ -1511,7 +2022,7 @@ void mcmc::pm_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram,
   arma::umat indices(nsim_states, n);
   double loglik = model.bsf_filter(nsim_states, alpha, weights, indices);
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    stop_error("Initial log-likelihood is not finite.");
   filter_smoother(alpha, indices);
   arma::vec w = weights.col(n);
   std::discrete_distribution<unsigned int> sample0(w.begin(), w.end());
@@ -1531,7 +2042,7 @@ void mcmc::pm_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram,
   for (unsigned int i = 1; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -1550,7 +2061,11 @@ void mcmc::pm_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram,
       // update parameters
       model.theta = theta_prop;
       
+      profiler.start();
       double loglik_prop = model.bsf_filter(nsim_states, alpha, weights, indices);
+      profiler.stop(mcmc_profiler::filtering);
+      profiler.add_filter(weights);
+      profiler.add_loglik(loglik_prop);
       
       //compute the acceptance probability
       // use explicit min(...) as we need this value later
@@ -1566,6 +2081,7 @@ void mcmc::pm_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram,
           n_values++;
         }
         if (output_type != 3) {
+          profiler.start();
           filter_smoother(alpha, indices);
           w = weights.col(n);
           if (output_type == 1) {
@@ -1574,14 +2090,19 @@ void mcmc::pm_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram,
           } else {
             weighted_summary(alpha, alphahat_i, Vt_i, w);
           }
+          profiler.stop(mcmc_profiler::smoothing);
         }
         loglik = loglik_prop;
         logprior = logprior_prop;
         theta = theta_prop;
         new_value = true;
       }
-    } else acceptance_prob = 0.0;
+    } else {
+      acceptance_prob = 0.0;
+      profiler.add_rejection();
+    }
     
+    profiler.start();
     // note: thinning does not affect this
     if (i > n_burnin && output_type == 2) {
       arma::mat diff = alphahat_i - alphahat;
@@ -1607,6 +2128,7 @@ void mcmc::pm_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram,
         count_storage(n_stored - 1)++;
       }
     }
+    profiler.stop(mcmc_profiler::storage);
     
     if (!end_ram || i <= n_burnin) {
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
@@ -1623,20 +2145,22 @@ void mcmc::pm_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram,
 // using psi-PF
 void mcmc::da_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
   const unsigned int nsim_states, const unsigned int max_iter,
-  const double conv_tol, const unsigned int iekf_iter) {
+  const double conv_tol, const unsigned int iekf_iter, 
+  const unsigned int n_threads) {
   
   unsigned int m = model.m;
   unsigned n = model.n;
   // compute the log[p(theta)]
   double logprior = model.log_prior_pdf(model.theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    stop_error("Initial prior probability is not finite.");
   }
   // construct the approximate Gaussian model
   arma::mat mode_estimate(m, n);
-  mgg_ssm approx_model0 = model.approximate(mode_estimate, max_iter, conv_tol, iekf_iter);
+  mgg_ssm approx_model0 = model.approximate(mode_estimate, max_iter, conv_tol, iekf_iter, 
+    n_threads);
   if(!arma::is_finite(mode_estimate)) {
-    Rcpp::stop("Approximation did not converge.");
+    stop_error("Approximation did not converge.");
   }
   // compute the log-likelihood of the approximate model
   double approx_loglik = approx_model0.log_likelihood();
@@ -1647,7 +2171,7 @@ void mcmc::da_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
   double loglik = model.psi_filter(approx_model0, approx_loglik,
     nsim_states, alpha, weights, indices);
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    stop_error("Initial log-likelihood is not finite.");
   approx_loglik += arma::accu(model.scaling_factors(approx_model0, mode_estimate));
   filter_smoother(alpha, indices);
   arma::vec w = weights.col(n);
@@ -1668,7 +2192,7 @@ void mcmc::da_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
   for (unsigned int i = 1; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -1686,10 +2210,14 @@ void mcmc::da_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
       // update parameters
       model.theta = theta_prop;
       // construct the approximate Gaussian model
-      
-      mgg_ssm approx_model = model.approximate(mode_estimate, max_iter, conv_tol, iekf_iter);
+      profiler.start();
+      mgg_ssm approx_model = model.approximate(mode_estimate, max_iter, conv_tol, iekf_iter, 
+        n_threads);
+      profiler.stop(mcmc_profiler::approximation);
+      profiler.add_approx_iter(model.approx_iter);
       if(!arma::is_finite(mode_estimate)) {
         acceptance_prob = 0;
+        profiler.add_rejection();
       } else {
         double sum_scales = arma::accu(model.scaling_factors(approx_model, mode_estimate));
         // compute the log-likelihood of the approximate model
@@ -1701,8 +2229,12 @@ void mcmc::da_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
         // initial acceptance
         if (unif(model.engine) < acceptance_prob) {
           
+          profiler.start();
           double loglik_prop = model.psi_filter(approx_model, approx_loglik_prop - sum_scales,
             nsim_states, alpha, weights, indices);
+          profiler.stop(mcmc_profiler::filtering);
+          profiler.add_filter(weights);
+          profiler.add_loglik(loglik_prop);
           
           //just in case
           if(std::isfinite(loglik_prop)) {
@@ -1716,6 +2248,7 @@ void mcmc::da_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
                 n_values++;
               }
               if (output_type != 3) {
+                profiler.start();
                 filter_smoother(alpha, indices);
                 w = weights.col(n);
                 if (output_type == 1) {
@@ -1724,6 +2257,7 @@ void mcmc::da_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
                 } else {
                   weighted_summary(alpha, alphahat_i, Vt_i, w);
                 }
+                profiler.stop(mcmc_profiler::smoothing);
               }
               approx_loglik = approx_loglik_prop;
               loglik = loglik_prop;
@@ -1734,8 +2268,12 @@ void mcmc::da_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
           }
         }
       }
-    } else acceptance_prob = 0.0;
+    } else {
+      acceptance_prob = 0.0;
+      profiler.add_rejection();
+    }
     
+    profiler.start();
     // note: thinning does not affect this
     if (i > n_burnin && output_type == 2) {
       arma::mat diff = alphahat_i - alphahat;
@@ -1761,6 +2299,7 @@ void mcmc::da_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
         count_storage(n_stored - 1)++;
       }
     }
+    profiler.stop(mcmc_profiler::storage);
     
     if (!end_ram || i <= n_burnin) {
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
@@ -1776,20 +2315,22 @@ void mcmc::da_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
 // run delayed acceptance MCMC for non-linear Gaussian state space model
 // using BSF
 void mcmc::da_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, const unsigned int nsim_states,
-  const unsigned int max_iter, const double conv_tol, const unsigned int iekf_iter) {
+  const unsigned int max_iter, const double conv_tol, const unsigned int iekf_iter, 
+  const unsigned int n_threads) {
   
   unsigned int m = model.m;
   unsigned n = model.n;
   // compute the log[p(theta)]
   double logprior = model.log_prior_pdf(model.theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    stop_error("Initial prior probability is not finite.");
   }
   // construct the approximate Gaussian model
   arma::mat mode_estimate(m, n);
-  mgg_ssm approx_model0 = model.approximate(mode_estimate, max_iter, conv_tol, iekf_iter);
+  mgg_ssm approx_model0 = model.approximate(mode_estimate, max_iter, conv_tol, iekf_iter, 
+    n_threads);
   if(!arma::is_finite(mode_estimate)) {
-    Rcpp::stop("Approximation did not converge. ");
+    stop_error("Approximation did not converge. ");
   }
   // compute the log-likelihood of the approximate model
   double sum_scales = arma::accu(model.scaling_factors(approx_model0, mode_estimate));
@@ -1800,7 +2341,7 @@ void mcmc::da_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, const unsigned int
   arma::umat indices(nsim_states, n);
   double loglik = model.bsf_filter(nsim_states, alpha, weights, indices);
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    stop_error("Initial log-likelihood is not finite.");
   filter_smoother(alpha, indices);
   arma::vec w = weights.col(n);
   std::discrete_distribution<unsigned int> sample0(w.begin(), w.end());
@@ -1820,7 +2361,7 @@ void mcmc::da_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, const unsigned int
   for (unsigned int i = 1; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -1839,10 +2380,15 @@ void mcmc::da_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, const unsigned int
       model.theta = theta_prop;
       
       // construct the approximate Gaussian model
-      mgg_ssm approx_model = model.approximate(mode_estimate, max_iter, conv_tol, iekf_iter);
+      profiler.start();
+      mgg_ssm approx_model = model.approximate(mode_estimate, max_iter, conv_tol, iekf_iter, 
+        n_threads);
+      profiler.stop(mcmc_profiler::approximation);
+      profiler.add_approx_iter(model.approx_iter);
       
       if(!arma::is_finite(mode_estimate)) {
         acceptance_prob = 0;
+        profiler.add_rejection();
       } else {
         
         // compute the log-likelihood of the approximate model
@@ -1859,7 +2405,11 @@ void mcmc::da_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, const unsigned int
         if (unif(model.engine) < acceptance_prob) {
           
           
+          profiler.start();
           double loglik_prop = model.bsf_filter(nsim_states, alpha, weights, indices);
+          profiler.stop(mcmc_profiler::filtering);
+          profiler.add_filter(weights);
+          profiler.add_loglik(loglik_prop);
           
           //just in case
           if(std::isfinite(loglik_prop)) {
@@ -1872,6 +2422,7 @@ void mcmc::da_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, const unsigned int
                 n_values++;
               }
               if (output_type != 3) {
+                profiler.start();
                 filter_smoother(alpha, indices);
                 w = weights.col(n);
                 if (output_type == 1) {
@@ -1880,6 +2431,7 @@ void mcmc::da_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, const unsigned int
                 } else {
                   weighted_summary(alpha, alphahat_i, Vt_i, w);
                 }
+                profiler.stop(mcmc_profiler::smoothing);
               }
               approx_loglik = approx_loglik_prop;
               loglik = loglik_prop;
@@ -1890,8 +2442,12 @@ void mcmc::da_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, const unsigned int
           }
         }
       }
-    } else acceptance_prob = 0.0;
+    } else {
+      acceptance_prob = 0.0;
+      profiler.add_rejection();
+    }
     
+    profiler.start();
     // note: thinning does not affect this
     if (i > n_burnin && output_type == 2) {
       arma::mat diff = alphahat_i - alphahat;
@@ -1917,6 +2473,7 @@ void mcmc::da_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, const unsigned int
         count_storage(n_stored - 1)++;
       }
     }
+    profiler.stop(mcmc_profiler::storage);
     
     if (!end_ram || i <= n_burnin) {
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
@@ -1938,7 +2495,7 @@ void mcmc::pm_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
   // compute the log[p(theta)]
   double logprior = model.log_prior_pdf(model.theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    stop_error("Initial prior probability is not finite.");
   }
   
   arma::cube alpha(m, n + 1, nsim_states);
@@ -1946,7 +2503,7 @@ void mcmc::pm_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
   arma::umat indices(nsim_states, n);
   double loglik = model.bsf_filter(nsim_states, L, alpha, weights, indices);
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    stop_error("Initial log-likelihood is not finite.");
   filter_smoother(alpha, indices);
   arma::vec w = weights.col(n);
   std::discrete_distribution<unsigned int> sample0(w.begin(), w.end());
@@ -1967,7 +2524,7 @@ void mcmc::pm_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
   for (unsigned int i = 1; i <= n_iter; i++) {
     
     if (i % 4 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -1986,7 +2543,11 @@ void mcmc::pm_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
       // update parameters
       model.theta = theta_prop;
       
+      profiler.start();
       double loglik_prop = model.bsf_filter(nsim_states, L, alpha, weights, indices);
+      profiler.stop(mcmc_profiler::filtering);
+      profiler.add_filter(weights);
+      profiler.add_loglik(loglik_prop);
       
       //compute the acceptance probability
       // use explicit min(...) as we need this value later;
@@ -2001,6 +2562,7 @@ void mcmc::pm_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
           n_values++;
         }
         if (output_type != 3) {
+          profiler.start();
           filter_smoother(alpha, indices);
           w = weights.col(n);
           if (output_type == 1) {
@@ -2009,14 +2571,19 @@ void mcmc::pm_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
           } else {
             weighted_summary(alpha, alphahat_i, Vt_i, w);
           }
+          profiler.stop(mcmc_profiler::smoothing);
         }
         loglik = loglik_prop;
         logprior = logprior_prop;
         theta = theta_prop;
         new_value = true;
       }
-    } else acceptance_prob = 0.0;
+    } else {
+      acceptance_prob = 0.0;
+      profiler.add_rejection();
+    }
     
+    profiler.start();
     // note: thinning does not affect this
     if (i > n_burnin && output_type == 2) {
       arma::mat diff = alphahat_i - alphahat;
@@ -2042,6 +2609,7 @@ void mcmc::pm_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
         count_storage(n_stored - 1)++;
       }
     }
+    profiler.stop(mcmc_profiler::storage);
     
     if (!end_ram || i <= n_burnin) {
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
@@ -2064,7 +2632,7 @@ void mcmc::da_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
   // compute the log[p(theta)]
   double logprior = model.log_prior_pdf(model.theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    stop_error("Initial prior probability is not finite.");
   }
   arma::cube alpha(m, n + 1, nsim_states);
   arma::mat weights(nsim_states, n + 1);
@@ -2074,7 +2642,7 @@ void mcmc::da_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
   double loglik_f = 0.0;
   loglik_f = model.bsf_filter(nsim_states, L_f, alpha, weights, indices);
   if (!std::isfinite(loglik_f))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    stop_error("Initial log-likelihood is not finite.");
   filter_smoother(alpha, indices);
   arma::vec w = weights.col(n);
   std::discrete_distribution<unsigned int> sample0(w.begin(), w.end());
@@ -2094,7 +2662,7 @@ void mcmc::da_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
   for (unsigned int i = 1; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -2115,7 +2683,11 @@ void mcmc::da_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
       // compute the coarse estimate
       // we could make this bit more efficient if we only stored and returned loglik...
       tmp_engine = model.coarse_engine;
+      profiler.start();
       double loglik_c_prop = model.bsf_filter(nsim_states, L_c, alpha, weights, indices);
+      profiler.stop(mcmc_profiler::filtering);
+      profiler.add_filter(weights);
+      profiler.add_loglik(loglik_c_prop);
       
       if(!arma::is_finite(loglik_c_prop)) {
         acceptance_prob = 0;
@@ -2128,7 +2700,11 @@ void mcmc::da_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
         // initial acceptance
         if (unif(model.engine) < acceptance_prob) {
           
+          profiler.start();
           double loglik_f_prop = model.bsf_filter(nsim_states, L_f, alpha, weights, indices);
+          profiler.stop(mcmc_profiler::filtering);
+          profiler.add_filter(weights);
+          profiler.add_loglik(loglik_f_prop);
           
           //just in case
           if(std::isfinite(loglik_f_prop)) {
@@ -2145,6 +2721,7 @@ void mcmc::da_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
                 n_values++;
               }
               if (output_type != 3) {
+                profiler.start();
                 filter_smoother(alpha, indices);
                 w = weights.col(n);
                 if (output_type == 1) {
@@ -2153,6 +2730,7 @@ void mcmc::da_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
                 } else {
                   weighted_summary(alpha, alphahat_i, Vt_i, w);
                 }
+                profiler.stop(mcmc_profiler::smoothing);
               }
               loglik_c = loglik_c_prop;
               loglik_f = loglik_f_prop;
@@ -2167,8 +2745,12 @@ void mcmc::da_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
           }
         }
       }
-    } else acceptance_prob = 0.0;
+    } else {
+      acceptance_prob = 0.0;
+      profiler.add_rejection();
+    }
     
+    profiler.start();
     // note: thinning does not affect this
     if (i > n_burnin && output_type == 2) {
       arma::mat diff = alphahat_i - alphahat;
@@ -2194,6 +2776,7 @@ void mcmc::da_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
         count_storage(n_stored - 1)++;
       }
     }
+    profiler.stop(mcmc_profiler::storage);
     
     if (!end_ram || i <= n_burnin) {
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
@@ -2,6 +2,7 @@
 #define MCMC_H
 
 #include "bssm.h"
+#include "profiler.h"
 
 class nlg_ssm;
 class lgg_ssm;
@@ -38,9 +39,20 @@ public:
   template <class T>
   void state_sampler(T& model, const arma::mat& theta, arma::cube& alpha);
   
-  // gaussian mcmc
+  // gaussian mcmc, n_threads is used in constructing the model 
+  // matrices of lgg_ssm
   template<class T>
-  void mcmc_gaussian(T model, const bool end_ram);
+  void mcmc_gaussian(T model, const bool end_ram, const unsigned int n_threads = 1);
+  // ensemble mcmc with affine-invariant moves, the likelihoods of the 
+  // walkers are computed in parallel using n_threads
+  template<class T>
+  void ensemble_gaussian(T model, const unsigned int n_walkers, 
+    const unsigned int n_threads = 1);
+  // parallel tempering with n_temps replicas updated in parallel using 
+  // n_threads, only the cold chain is stored
+  template<class T>
+  void pt_gaussian(T model, const bool end_ram, const unsigned int n_temps, 
+    const double max_temp, const unsigned int n_threads = 1);
   
   // pseudo-marginal mcmc
   template<class T>
@@ -70,15 +82,18 @@ public:
   
   // using non-linear models
   void pm_mcmc_psi_nlg(nlg_ssm model, const bool end_ram, const unsigned int nsim_states, 
-    const unsigned int max_iter, const double conv_tol, const unsigned int iekf_iter);
+    const unsigned int max_iter, const double conv_tol, const unsigned int iekf_iter, 
+    const unsigned int n_threads = 1);
   void pm_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, 
     const unsigned int nsim_states);
   void ekf_mcmc_nlg(nlg_ssm model, const bool end_ram, const unsigned int max_iter, 
     const double conv_tol, const unsigned int iekf_iter);
   void da_mcmc_psi_nlg(nlg_ssm model, const bool end_ram, const unsigned int nsim_states,
-    const unsigned int max_iter, const double conv_tol, const unsigned int iekf_iter);
+    const unsigned int max_iter, const double conv_tol, const unsigned int iekf_iter, 
+    const unsigned int n_threads = 1);
   void da_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, const unsigned int nsim_states,
-    const unsigned int max_iter, const double conv_tol, const unsigned int iekf_iter);
+    const unsigned int max_iter, const double conv_tol, const unsigned int iekf_iter, 
+    const unsigned int n_threads = 1);
   
   // sde models
   void pm_mcmc_bsf_sde(sde_ssm model, const bool end_ram, const unsigned int nsim_states,
@@ -95,6 +110,8 @@ public:
   arma::mat S;
   double acceptance_rate;
   unsigned int output_type;
+  // optional timings and counters of the algorithm
+  mcmc_profiler profiler;
   
 };
 
@@ -1,6 +1,7 @@
 #include "mgg_ssm.h"
 #include "psd_chol.h"
 
+#ifndef BSSM_STANDALONE
 // General constructor of mgg_ssm object from Rcpp::List
 // with parameter indices
 mgg_ssm::mgg_ssm(const Rcpp::List& model, const unsigned int seed,
@@ -29,6 +30,7 @@ mgg_ssm::mgg_ssm(const Rcpp::List& model, const unsigned int seed,
   compute_HH();
   compute_RR();
 }
+#endif
 
 // General constructor of mgg_ssm object for approximating models
 mgg_ssm::mgg_ssm(const arma::mat& y, const arma::cube& Z, const arma::cube& H,
@@ -141,9 +143,14 @@ void mgg_ssm::compute_xbeta(){
 
 double mgg_ssm::log_likelihood() const {
   
-  double logLik = 0;
   arma::vec at = a1;
   arma::mat Pt = P1;
+  return log_likelihood(at, Pt);
+}
+
+double mgg_ssm::log_likelihood(arma::vec& at, arma::mat& Pt) const {
+  
+  double logLik = 0;
   
   arma::mat y_tmp = y;
   if(xreg.n_cols > 0) {
@@ -10,6 +10,7 @@ class mgg_ssm {
   
 public:
   
+#ifndef BSSM_STANDALONE
   // constructor from Rcpp::List
   mgg_ssm(const Rcpp::List& model, 
     const unsigned int seed = 1, 
@@ -17,6 +18,7 @@ public:
     const arma::uvec& H_ind_ = arma::uvec(), 
     const arma::uvec& T_ind_ = arma::uvec(), 
     const arma::uvec& R_ind_ = arma::uvec());
+#endif
   
   // constructor from armadillo objects
   mgg_ssm(const arma::mat& y, const arma::cube& Z, const arma::cube& H, 
@@ -45,6 +47,9 @@ public:
   
   // compute the log-likelihood using Kalman filter
   double log_likelihood() const;
+  // log-likelihood given the predictive distribution N(at, Pt) of the first 
+  // state, at and Pt are updated to the prediction of the state after y(n - 1)
+  double log_likelihood(arma::vec& at, arma::mat& Pt) const;
   
   arma::cube simulate_states();
   void smoother(arma::mat& at, arma::cube& Pt) const; 
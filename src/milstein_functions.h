@@ -1,7 +1,7 @@
 #ifndef MILSTEIN_FN_H
 #define MILSTEIN_FN_H
 
-#include <RcppArmadillo.h>
+#include "bssm.h"
 #include "sitmo.h"
 
 // typedef for a pointer of drift/diffusion functions
@@ -9,6 +9,7 @@
 #include "rep_mat.h"
 #include "filter_smoother.h"
 #include "summary.h"
+#include "hooks.h"
 
 nlg_amcmc::nlg_amcmc(const unsigned int n_iter, 
   const unsigned int n_burnin, const unsigned int n_thin, const unsigned int n, 
@@ -38,12 +39,16 @@ void nlg_amcmc::trim_storage() {
     mode_storage.resize(mode_storage.n_rows, mode_storage.n_cols, n_stored);
     scales_storage.resize(n_stored);
   }
+  approx_index = arma::linspace<arma::uvec>(0, n_stored - 1, n_stored);
 }
 
 void nlg_amcmc::expand() {
   
   //trim extras first just in case
   trim_storage();
+  // the modes are shared by the copies of each draw, 
+  // so only their indices are expanded
+  approx_index = rep_uvec(approx_index, count_storage);
   n_stored = arma::accu(count_storage);
   
   arma::mat expanded_theta = rep_mat(theta_storage, count_storage);
@@ -65,49 +70,48 @@ void nlg_amcmc::expand() {
   arma::vec expanded_prior = rep_vec(prior_storage, count_storage);
   prior_storage.set_size(n_stored);
   prior_storage = expanded_prior;
-
+  
+  if (store_modes) {
+    arma::vec expanded_scales = rep_vec(scales_storage, count_storage);
+    scales_storage.set_size(n_stored);
+    scales_storage = expanded_scales;
+  }
+  
   count_storage.resize(n_stored);
   count_storage.ones();
   
   if (output_type == 1) {
-    arma::cube expanded_alpha = rep_cube(alpha_storage, count_storage);
+    // the states are simulated separately for each copy in IS correction, 
+    // so there is no need to copy the approximate ones
     alpha_storage.set_size(alpha_storage.n_rows, alpha_storage.n_cols, n_stored);
-    alpha_storage = expanded_alpha;
   }
-  if (store_modes) {
-    arma::mat expanded_scales = rep_mat(scales_storage, count_storage);
-    scales_storage.set_size(scales_storage.n_rows, n_stored);
-    scales_storage = expanded_scales;
 
-    arma::cube expanded_mode = rep_cube(mode_storage, count_storage);
-    mode_storage.set_size(mode_storage.n_rows, mode_storage.n_cols, n_stored);
-    mode_storage = expanded_mode;
-  }
-  
 }
 // run approximate MCMC for
 // non-linear Gaussian state space model
 
 void nlg_amcmc::approx_mcmc(nlg_ssm model, const unsigned int max_iter, 
-  const double conv_tol, const bool end_ram, const unsigned int iekf_iter) {
+  const double conv_tol, const bool end_ram, const unsigned int iekf_iter, 
+  const unsigned int n_threads) {
   
   unsigned int m = model.m;
   unsigned n = model.n;
   
   double logprior = model.log_prior_pdf(model.theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    stop_error("Initial prior probability is not finite.");
   }
   arma::mat mode_estimate(m, n);
-  mgg_ssm approx_model0 = model.approximate(mode_estimate, max_iter, conv_tol, iekf_iter);
+  mgg_ssm approx_model0 = model.approximate(mode_estimate, max_iter, conv_tol, iekf_iter, 
+    n_threads);
   if (!arma::is_finite(mode_estimate)) {
-    Rcpp::stop("Approximation based on initial theta failed.");
+    stop_error("Approximation based on initial theta failed.");
   }
   double sum_scales = arma::accu(model.scaling_factors(approx_model0, mode_estimate));
   // compute the log-likelihood of the approximate model
   double loglik = approx_model0.log_likelihood() + sum_scales;
   if (!arma::is_finite(loglik)) {
-    Rcpp::stop("Initial approximate likelihood is not finite.");
+    stop_error("Initial approximate likelihood is not finite.");
   }
   double acceptance_prob = 0.0;
   std::normal_distribution<> normal(0.0, 1.0);
@@ -119,7 +123,7 @@ void nlg_amcmc::approx_mcmc(nlg_ssm model, const unsigned int max_iter,
   
   for (unsigned int i = 1; i <= n_iter; i++) {
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -138,8 +142,11 @@ void nlg_amcmc::approx_mcmc(nlg_ssm model, const unsigned int max_iter,
       // update parameters
       model.theta = theta_prop;
       arma::mat mode_estimate_prop(m, n);
+      profiler.start();
       mgg_ssm approx_model = model.approximate(mode_estimate_prop, max_iter, 
-        conv_tol, iekf_iter);
+        conv_tol, iekf_iter, n_threads);
+      profiler.stop(mcmc_profiler::approximation);
+      profiler.add_approx_iter(model.approx_iter);
       double loglik_prop;
       double sum_scales_prop = 0.0; // initialize in order to get rid of false warning
       if(!is_finite(mode_estimate_prop)) {
@@ -150,6 +157,7 @@ void nlg_amcmc::approx_mcmc(nlg_ssm model, const unsigned int max_iter,
         // compute the log-likelihood of the approximate model
         loglik_prop = approx_model.log_likelihood() + sum_scales_prop;
       }
+      profiler.add_loglik(loglik_prop);
       
       if (loglik_prop > -std::numeric_limits<double>::infinity() && !std::isnan(loglik_prop)) {
         
@@ -172,8 +180,12 @@ void nlg_amcmc::approx_mcmc(nlg_ssm model, const unsigned int max_iter,
         mode_estimate = mode_estimate_prop;
         new_value = true;
       }
-    } else acceptance_prob = 0.0;
+    } else {
+      acceptance_prob = 0.0;
+      profiler.add_rejection();
+    }
     
+    profiler.start();
     if (i > n_burnin && n_values % n_thin == 0) {
       //new block
       if (new_value) {
@@ -191,6 +203,7 @@ void nlg_amcmc::approx_mcmc(nlg_ssm model, const unsigned int max_iter,
         count_storage(n_stored - 1)++;
       }
     }
+    profiler.stop(mcmc_profiler::storage);
     
     if (!end_ram || i <= n_burnin) {
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
@@ -201,14 +214,35 @@ void nlg_amcmc::approx_mcmc(nlg_ssm model, const unsigned int max_iter,
   acceptance_rate /= (n_iter - n_burnin);
 }
 
-void nlg_amcmc::ekf_mcmc(nlg_ssm model, const bool end_ram, const unsigned int iekf_iter) {
+double nlg_amcmc::filter_loglik(const nlg_ssm& model, const unsigned int approx_type,
+  const unsigned int iekf_iter, const unsigned int n_ens, 
+  const double ukf_alpha, const double ukf_beta, const double ukf_kappa,
+  const unsigned int n_threads) const {
+  
+  switch (approx_type) {
+  case 2:
+    return model.ukf_loglik(ukf_alpha, ukf_beta, ukf_kappa, n_threads);
+  case 3:
+    return model.enkf_loglik(n_ens, false, n_threads);
+  case 4:
+    return model.enkf_loglik(n_ens, true, n_threads);
+  default:
+    return model.ekf_loglik(iekf_iter);
+  }
+}
+
+void nlg_amcmc::ekf_mcmc(nlg_ssm model, const bool end_ram, const unsigned int iekf_iter,
+  const unsigned int approx_type, const unsigned int n_ens, 
+  const double ukf_alpha, const double ukf_beta, const double ukf_kappa,
+  const unsigned int n_threads) {
   
   double logprior = model.log_prior_pdf(model.theta);
   
   // compute the log-likelihood
-  double loglik = model.ekf_loglik(iekf_iter);
+  double loglik = filter_loglik(model, approx_type, iekf_iter, n_ens, 
+    ukf_alpha, ukf_beta, ukf_kappa, n_threads);
   if (!arma::is_finite(loglik)) {
-    Rcpp::stop("Initial approximate likelihood is not finite.");
+    stop_error("Initial approximate likelihood is not finite.");
   }
   double acceptance_prob = 0.0;
   std::normal_distribution<> normal(0.0, 1.0);
@@ -220,7 +254,7 @@ void nlg_amcmc::ekf_mcmc(nlg_ssm model, const bool end_ram, const unsigned int i
   
   for (unsigned int i = 1; i <= n_iter; i++) {
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -237,7 +271,11 @@ void nlg_amcmc::ekf_mcmc(nlg_ssm model, const bool end_ram, const unsigned int i
     if (logprior_prop > -std::numeric_limits<double>::infinity() && !std::isnan(logprior_prop)) {
       // update parameters
       model.theta = theta_prop;
-      double loglik_prop = model.ekf_loglik(iekf_iter);
+      profiler.start();
+      double loglik_prop = filter_loglik(model, approx_type, iekf_iter, n_ens,
+        ukf_alpha, ukf_beta, ukf_kappa, n_threads);
+      profiler.stop(mcmc_profiler::filtering);
+      profiler.add_loglik(loglik_prop);
       
       if (loglik_prop > -std::numeric_limits<double>::infinity() && !std::isnan(loglik_prop)) {
         
@@ -258,8 +296,12 @@ void nlg_amcmc::ekf_mcmc(nlg_ssm model, const bool end_ram, const unsigned int i
         theta = theta_prop;
         new_value = true;
       }
-    } else acceptance_prob = 0.0;
+    } else {
+      acceptance_prob = 0.0;
+      profiler.add_rejection();
+    }
     
+    profiler.start();
     if (i > n_burnin && n_values % n_thin == 0) {
       //new block
       if (new_value) {
@@ -273,6 +315,7 @@ void nlg_amcmc::ekf_mcmc(nlg_ssm model, const bool end_ram, const unsigned int i
         count_storage(n_stored - 1)++;
       }
     }
+    profiler.stop(mcmc_profiler::storage);
     
     if (!end_ram || i <= n_burnin) {
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
@@ -286,6 +329,7 @@ void nlg_amcmc::ekf_mcmc(nlg_ssm model, const bool end_ram, const unsigned int i
 void nlg_amcmc::is_correction_bsf(nlg_ssm model, const unsigned int nsim_states, 
   const unsigned int is_type, const unsigned int n_threads) {
   
+  profiler.start();
   arma::cube Valpha(model.m, model.m, model.n + 1, arma::fill::zeros);
   double sum_w = 0.0;
   
@@ -382,12 +426,14 @@ if (output_type == 2) {
   Vt += Valpha / theta_storage.n_cols; // Var[E(alpha)] + E[Var(alpha)]
 }
 posterior_storage = prior_storage + arma::log(weight_storage);
+profiler.stop(mcmc_profiler::is_correction);
 }
 
 
 void nlg_amcmc::is_correction_psi(nlg_ssm model, const unsigned int nsim_states, 
   const unsigned int is_type, const unsigned int n_threads) {
   
+  profiler.start();
   arma::cube Valpha(model.m, model.m, model.n + 1, arma::fill::zeros);
   double sum_w = 0.0;
   
@@ -420,19 +466,18 @@ void nlg_amcmc::is_correction_psi(nlg_ssm model, const unsigned int nsim_states,
     
     approx_model.a1 = model.a1_fn(model.theta, model.known_params);
     approx_model.P1 = model.P1_fn(model.theta, model.known_params);
+    const arma::mat& mode_i = mode_storage.slice(approx_index(i));
     for (unsigned int t = 0; t < Z.n_slices; t++) {
-      approx_model.Z.slice(t) = model.Z_gn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params);
-      approx_model.T.slice(t) = model.T_gn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params);
-      approx_model.D.col(t) = model.Z_fn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params) -
-        approx_model.Z.slice(t) * mode_storage.slice(i).col(t);
-      approx_model.C.col(t) =  model.T_fn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params) -
-        approx_model.T.slice(t) * mode_storage.slice(i).col(t);
+      approx_model.D.col(t) = model.Z_linear(t, mode_i.col(t), approx_model.Z.slice(t)) -
+        approx_model.Z.slice(t) * mode_i.col(t);
+      approx_model.C.col(t) = model.T_linear(t, mode_i.col(t), approx_model.T.slice(t)) -
+        approx_model.T.slice(t) * mode_i.col(t);
     }
     for (unsigned int t = 0; t < H.n_slices; t++) {
-      approx_model.H.slice(t) = model.H_fn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params);
+      approx_model.H.slice(t) = model.H_fn(t, mode_i.col(t), model.theta, model.known_params, model.known_tv_params);
     }
     for (unsigned int t = 0; t < R.n_slices; t++) {
-      approx_model.R.slice(t) = model.R_fn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params);
+      approx_model.R.slice(t) = model.R_fn(t, mode_i.col(t), model.theta, model.known_params, model.known_tv_params);
     }
     approx_model.compute_HH();
     approx_model.compute_RR();
@@ -498,19 +543,18 @@ for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
   
   approx_model.a1 = model.a1_fn(model.theta, model.known_params);
   approx_model.P1 = model.P1_fn(model.theta, model.known_params);
+  const arma::mat& mode_i = mode_storage.slice(approx_index(i));
   for (unsigned int t = 0; t < Z.n_slices; t++) {
-    approx_model.Z.slice(t) = model.Z_gn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params);
-    approx_model.T.slice(t) = model.T_gn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params);
-    approx_model.D.col(t) = model.Z_fn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params) -
-      approx_model.Z.slice(t) * mode_storage.slice(i).col(t);
-    approx_model.C.col(t) =  model.T_fn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params) -
-      approx_model.T.slice(t) * mode_storage.slice(i).col(t);
+    approx_model.D.col(t) = model.Z_linear(t, mode_i.col(t), approx_model.Z.slice(t)) -
+      approx_model.Z.slice(t) * mode_i.col(t);
+    approx_model.C.col(t) = model.T_linear(t, mode_i.col(t), approx_model.T.slice(t)) -
+      approx_model.T.slice(t) * mode_i.col(t);
   }
   for (unsigned int t = 0; t < H.n_slices; t++) {
-    approx_model.H.slice(t) = model.H_fn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params);
+    approx_model.H.slice(t) = model.H_fn(t, mode_i.col(t), model.theta, model.known_params, model.known_tv_params);
   }
   for (unsigned int t = 0; t < R.n_slices; t++) {
-    approx_model.R.slice(t) = model.R_fn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params);
+    approx_model.R.slice(t) = model.R_fn(t, mode_i.col(t), model.theta, model.known_params, model.known_tv_params);
   }
   approx_model.compute_HH();
   approx_model.compute_RR();
@@ -557,10 +601,12 @@ if (output_type == 2) {
 }
 posterior_storage = prior_storage + approx_loglik_storage - scales_storage + 
   arma::log(weight_storage);
+  profiler.stop(mcmc_profiler::is_correction);
 }
 
 void nlg_amcmc::state_ekf_sample(nlg_ssm model, const unsigned int n_threads, const unsigned int iekf_iter) {
   
+  profiler.start();
 #ifdef _OPENMP
 #pragma omp parallel num_threads(n_threads) default(shared) firstprivate(model)
 {
@@ -596,11 +642,9 @@ void nlg_amcmc::state_ekf_sample(nlg_ssm model, const unsigned int n_threads, co
     approx_model.a1 = model.a1_fn(model.theta, model.known_params);
     approx_model.P1 = model.P1_fn(model.theta, model.known_params);
     for (unsigned int t = 0; t < Z.n_slices; t++) {
-      approx_model.Z.slice(t) = model.Z_gn(t, at.col(t), model.theta, model.known_params, model.known_tv_params);
-      approx_model.T.slice(t) = model.T_gn(t, att.col(t), model.theta, model.known_params, model.known_tv_params);
-      approx_model.D.col(t) = model.Z_fn(t, at.col(t), model.theta, model.known_params, model.known_tv_params) -
+      approx_model.D.col(t) = model.Z_linear(t, at.col(t), approx_model.Z.slice(t)) -
         approx_model.Z.slice(t) * at.col(t);
-      approx_model.C.col(t) =  model.T_fn(t, att.col(t), model.theta, model.known_params, model.known_tv_params) -
+      approx_model.C.col(t) = model.T_linear(t, att.col(t), approx_model.T.slice(t)) -
         approx_model.T.slice(t) * att.col(t);
     }
     for (unsigned int t = 0; t < H.n_slices; t++) {
@@ -647,11 +691,9 @@ for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
   approx_model.a1 = model.a1_fn(model.theta, model.known_params);
   approx_model.P1 = model.P1_fn(model.theta, model.known_params);
   for (unsigned int t = 0; t < Z.n_slices; t++) {
-    approx_model.Z.slice(t) = model.Z_gn(t, at.col(t), model.theta, model.known_params, model.known_tv_params);
-    approx_model.T.slice(t) = model.T_gn(t, att.col(t), model.theta, model.known_params, model.known_tv_params);
-    approx_model.D.col(t) = model.Z_fn(t, at.col(t), model.theta, model.known_params, model.known_tv_params) -
+    approx_model.D.col(t) = model.Z_linear(t, at.col(t), approx_model.Z.slice(t)) -
       approx_model.Z.slice(t) * at.col(t);
-    approx_model.C.col(t) =  model.T_fn(t, att.col(t), model.theta, model.known_params, model.known_tv_params) -
+    approx_model.C.col(t) = model.T_linear(t, att.col(t), approx_model.T.slice(t)) -
       approx_model.T.slice(t) * att.col(t);
   }
   for (unsigned int t = 0; t < H.n_slices; t++) {
@@ -668,11 +710,13 @@ for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
 #endif
 
 posterior_storage = prior_storage + approx_loglik_storage;
+profiler.stop(mcmc_profiler::smoothing);
 }
 
 void nlg_amcmc::state_ekf_summary(nlg_ssm& model,
   arma::mat& alphahat, arma::cube& Vt, const unsigned int iekf_iter) {
   
+  profiler.start();
   // first iteration
   model.theta = theta_storage.col(0);
   model.ekf_smoother(alphahat, Vt, iekf_iter);
@@ -698,6 +742,7 @@ void nlg_amcmc::state_ekf_summary(nlg_ssm& model,
     sum_w = tmp;
   }
   Vt += Valpha / sum_w; // Var[E(alpha)] + E[Var(alpha)]
+  profiler.stop(mcmc_profiler::smoothing);
 }
 
 
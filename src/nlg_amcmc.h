@@ -17,9 +17,18 @@ public:
   void expand();
   
   void approx_mcmc(nlg_ssm model, const unsigned int max_iter, 
-    const double conv_tol, const bool end_ram, const unsigned int iekf_iter);
+    const double conv_tol, const bool end_ram, const unsigned int iekf_iter, 
+    const unsigned int n_threads = 1);
   
-  void ekf_mcmc(nlg_ssm model, const bool end_ram, const unsigned int iekf_iter);
+  // MCMC targeting the approximate posterior based on the likelihood given by
+  // EKF (approx_type = 1), UKF (2), or EnKF with n_ens members using 
+  // perturbed observations (3) or square-root analysis (4). The UKF uses the 
+  // parameters ukf_alpha, ukf_beta and ukf_kappa, and the UKF and EnKF use 
+  // n_threads threads
+  void ekf_mcmc(nlg_ssm model, const bool end_ram, const unsigned int iekf_iter,
+    const unsigned int approx_type = 1, const unsigned int n_ens = 0,
+    const double ukf_alpha = 1.0, const double ukf_beta = 0.0, 
+    const double ukf_kappa = 2.0, const unsigned int n_threads = 1);
   
   void is_correction_bsf(nlg_ssm model, const unsigned int nsim_states, 
     const unsigned int is_type, const unsigned int n_threads);
@@ -37,11 +46,19 @@ public:
 private:
   
   void trim_storage();
+  // log-likelihood of the filter used by ekf_mcmc
+  double filter_loglik(const nlg_ssm& model, const unsigned int approx_type,
+    const unsigned int iekf_iter, const unsigned int n_ens, 
+    const double ukf_alpha, const double ukf_beta, const double ukf_kappa,
+    const unsigned int n_threads) const;
   arma::vec approx_loglik_storage;
   arma::vec scales_storage;
   arma::vec prior_storage;
   const bool store_modes;
   arma::cube mode_storage;
+  // slice of mode_storage corresponding to each draw, 
+  // differs from 0, 1, ... only after expand()
+  arma::uvec approx_index;
 };
 
 
@@ -3,9 +3,9 @@
 #include "sample.h"
 #include "dmvnorm.h"
 #include "conditional_dist.h"
-#include "rep_mat.h"
 #include "psd_chol.h"
 #include "interval.h"
+#include "hooks.h"
 
 nlg_ssm::nlg_ssm(const arma::mat& y, nvec_fnPtr Z_fn_, nmat_fnPtr H_fn_, nvec_fnPtr T_fn_, 
   nmat_fnPtr R_fn_, nmat_fnPtr Z_gn_, nmat_fnPtr T_gn_, a1_fnPtr a1_fn_, P1_fnPtr P1_fn_,
@@ -18,16 +18,168 @@ nlg_ssm::nlg_ssm(const arma::mat& y, nvec_fnPtr Z_fn_, nmat_fnPtr H_fn_, nvec_fn
   log_prior_pdf(log_prior_pdf_), known_params(known_params), 
   known_tv_params(known_tv_params), m(m), k(k), n(y.n_cols),  p(y.n_rows),
   Zgtv(time_varying(0)), Tgtv(time_varying(1)), Htv(time_varying(2)),
-  Rtv(time_varying(3)), seed(seed), 
-  engine(seed), zero_tol(1e-8) {
+  Rtv(time_varying(3)), 
+  Hsv(time_varying.n_elem > 4 ? time_varying(4) : 1), 
+  Rsv(time_varying.n_elem > 5 ? time_varying(5) : 1), seed(seed), 
+  engine(seed), zero_tol(1e-8), approx_iter(0), 
+  H_fixed(Htv == 0 && Hsv == 0), RR_fixed(Rtv == 0 && Rsv == 0), 
+  H_factor_theta(1), RR_factor_theta(1) {
+  // NaN never matches theta, so the factorisations are computed at first use
+  H_factor_theta.fill(arma::datum::nan);
+  RR_factor_theta.fill(arma::datum::nan);
 }
 
-Rcpp::List nlg_ssm::predict_interval(const arma::vec& probs, const arma::mat& thetasim,
+namespace {
+// forward difference approximation of the Jacobian of f at alpha, 
+// reusing the value f(alpha)
+arma::mat numerical_jacobian(nvec_fnPtr f, const unsigned int t, 
+  const arma::vec& alpha, const arma::vec& value, const arma::vec& theta, 
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  
+  const double sqrt_eps = std::sqrt(std::numeric_limits<double>::epsilon());
+  arma::mat jac(value.n_elem, alpha.n_elem);
+  arma::vec x = alpha;
+  for (unsigned int j = 0; j < alpha.n_elem; j++) {
+    x(j) = alpha(j) + sqrt_eps * std::max(1.0, std::abs(alpha(j)));
+    // use the step which is exactly representable
+    double h = x(j) - alpha(j);
+    jac.col(j) = (f(t, x, theta, known_params, known_tv_params) - value) / h;
+    x(j) = alpha(j);
+  }
+  return jac;
+}
+
+bool same_theta(const arma::vec& x, const arma::vec& y) {
+  return x.n_elem == y.n_elem && arma::all(x == y);
+}
+
+// rank-one update (sign = 1) or downdate (sign = -1) of lower triangular L
+// so that L L' + sign * x x' is overwritten by its Cholesky factor, using
+// Givens or hyperbolic rotations. Returns false if the downdated matrix is
+// not positive definite in the non-degenerate directions of L
+bool chol_update(arma::mat& L, arma::vec x, const double sign) {
+  unsigned int n = x.n_elem;
+  for (unsigned int k = 0; k < n; k++) {
+    if (x(k) == 0.0) continue;
+    double r2 = L(k, k) * L(k, k) + sign * x(k) * x(k);
+    if (r2 <= 0.0) return false;
+    double r = std::sqrt(r2);
+    double c = L(k, k) / r;
+    double s = x(k) / r;
+    L(k, k) = r;
+    if (k + 1 < n) {
+      arma::span rest(k + 1, n - 1);
+      arma::vec Lk = L(rest, k);
+      L(rest, k) = c * Lk + sign * s * x(rest);
+      x(rest) = c * x(rest) - s * Lk;
+    }
+  }
+  return true;
+}
+
+// lower triangular S with S S' = A A' + w x x', using QR decomposition of A'
+// and rank-one update (or downdate if w < 0)
+bool sqrt_cov(const arma::mat& A, const arma::vec& x, const double w, arma::mat& S) {
+  arma::mat Q, R;
+  if (A.n_cols < A.n_rows || !arma::qr_econ(Q, R, A.t())) return false;
+  S = R.t();
+  for (unsigned int j = 0; j < S.n_cols; j++) {
+    if (S(j, j) < 0.0) S.col(j) *= -1.0;
+  }
+  return chol_update(S, std::sqrt(std::abs(w)) * x, w < 0.0 ? -1.0 : 1.0);
+}
+
+// matrix of independent standard normal variates
+arma::mat normal_draws(const unsigned int n_rows, const unsigned int n_cols, 
+  sitmo::prng_engine& eng) {
+  std::normal_distribution<> normal(0.0, 1.0);
+  arma::mat draws(n_rows, n_cols);
+  for (unsigned int j = 0; j < draws.n_elem; j++) {
+    draws(j) = normal(eng);
+  }
+  return draws;
+}
+
+// as dmvnorm(x, mean, L, true, true) for lower triangular L, 
+// but using a triangular solve instead of inverse
+double chol_logpdf(const arma::vec& x, const arma::vec& mean, const arma::mat& L) {
+  arma::vec d = L.diag();
+  arma::uvec nonzero = arma::find(d > (std::numeric_limits<double>::epsilon() * L.n_cols * d.max()));
+  arma::vec tmp = arma::solve(arma::trimatl(L(nonzero, nonzero)), 
+    x.rows(nonzero) - mean.rows(nonzero));
+  return -0.5 * (nonzero.n_elem * std::log(2.0 * M_PI) + arma::dot(tmp, tmp)) - 
+    arma::accu(arma::log(d(nonzero)));
+}
+}
+
+const dmvnorm_factor& nlg_ssm::invariant_H(const arma::vec& alpha) const {
+  if (!same_theta(theta, H_factor_theta)) {
+    H_factor = dmvnorm_factor(H_fn(0, alpha, theta, known_params, known_tv_params), 
+      true, arma::regspace<arma::uvec>(0, p - 1));
+    H_factor_theta = theta;
+  }
+  return H_factor;
+}
+
+const dmvnorm_factor& nlg_ssm::invariant_RR(const arma::vec& alpha) const {
+  if (!same_theta(theta, RR_factor_theta)) {
+    arma::mat R = R_fn(0, alpha, theta, known_params, known_tv_params);
+    RR_factor = dmvnorm_factor(R * R.t(), false, arma::regspace<arma::uvec>(0, m - 1));
+    RR_factor_theta = theta;
+  }
+  return RR_factor;
+}
+
+arma::vec nlg_ssm::Z_linear(const unsigned int t, const arma::vec& alpha, 
+  arma::mat& Zg) const {
+  arma::vec value = Z_fn(t, alpha, theta, known_params, known_tv_params);
+  if (Z_gn) {
+    Zg = Z_gn(t, alpha, theta, known_params, known_tv_params);
+  } else {
+    Zg = numerical_jacobian(Z_fn, t, alpha, value, theta, known_params, 
+      known_tv_params);
+  }
+  return value;
+}
+
+arma::vec nlg_ssm::T_linear(const unsigned int t, const arma::vec& alpha, 
+  arma::mat& Tg) const {
+  arma::vec value = T_fn(t, alpha, theta, known_params, known_tv_params);
+  if (T_gn) {
+    Tg = T_gn(t, alpha, theta, known_params, known_tv_params);
+  } else {
+    Tg = numerical_jacobian(T_fn, t, alpha, value, theta, known_params, 
+      known_tv_params);
+  }
+  return value;
+}
+
+arma::mat nlg_ssm::Z_jacobian(const unsigned int t, const arma::vec& alpha) const {
+  if (Z_gn) {
+    return Z_gn(t, alpha, theta, known_params, known_tv_params);
+  }
+  arma::mat Zg;
+  Z_linear(t, alpha, Zg);
+  return Zg;
+}
+
+arma::mat nlg_ssm::T_jacobian(const unsigned int t, const arma::vec& alpha) const {
+  if (T_gn) {
+    return T_gn(t, alpha, theta, known_params, known_tv_params);
+  }
+  arma::mat Tg;
+  T_linear(t, alpha, Tg);
+  return Tg;
+}
+
+void nlg_ssm::predict_interval(const arma::vec& probs, const arma::mat& thetasim,
   const arma::mat& alpha_last, const arma::cube& P_last, 
-  const arma::uvec& counts, const unsigned int predict_type) {
+  const arma::uvec& counts, const unsigned int predict_type, 
+  arma::cube& intv, arma::cube& mean_pred, arma::cube& sd_pred,
+  const unsigned int n_threads) {
   
   if(p > 1) 
-    Rcpp::stop("Interval prediction using EKF is currently not supported for multivariate observations.");
+    stop_error("Interval prediction using EKF is currently not supported for multivariate observations.");
   theta = thetasim.col(0);
   
   arma::mat at(m, n);
@@ -36,8 +188,8 @@ Rcpp::List nlg_ssm::predict_interval(const arma::vec& probs, const arma::mat& th
   Pt.slice(0) = P_last.slice(0);
   
   for (unsigned int t = 0; t < (n - 1); t++) {
-    at.col(t + 1) = T_fn(t, at.col(t), theta, known_params, known_tv_params);
-    arma::mat Tg = T_gn(t, at.col(t), theta, known_params, known_tv_params);
+    arma::mat Tg;
+    at.col(t + 1) = T_linear(t, at.col(t), Tg);
     arma::mat Rt = R_fn(t, at.col(t), theta, known_params, known_tv_params);
     Pt.slice(t + 1) = Tg * Pt.slice(t) * Tg.t() + Rt * Rt.t();
   }
@@ -46,19 +198,19 @@ Rcpp::List nlg_ssm::predict_interval(const arma::vec& probs, const arma::mat& th
   
   if (predict_type < 3) {
     
-    arma::mat mean_pred(n, n_samples);
-    arma::mat var_pred(n, n_samples);
+    arma::mat mean_t(n, n_samples);
+    arma::mat var_t(n, n_samples);
     
     for(unsigned int t = 0; t < n; t++) {
-      mean_pred(t, 0) = arma::as_scalar(Z_fn(t, at.col(t), theta, known_params, known_tv_params));
-      arma::mat Zg = Z_gn(t, at.col(t), theta, known_params, known_tv_params);
-      var_pred(t, 0) = arma::as_scalar(Zg * Pt.slice(t) * Zg.t());
+      arma::mat Zg;
+      mean_t(t, 0) = arma::as_scalar(Z_linear(t, at.col(t), Zg));
+      var_t(t, 0) = arma::as_scalar(Zg * Pt.slice(t) * Zg.t());
     }
     
     if (predict_type == 1) {
       for(unsigned int t = 0; t < n; t++) {
         arma::mat HHt = H_fn(t, at.col(t), theta, known_params, known_tv_params);
-        var_pred(t, 0) += arma::as_scalar(HHt * HHt.t());
+        var_t(t, 0) += arma::as_scalar(HHt * HHt.t());
       }
     }
     
@@ -69,44 +221,41 @@ Rcpp::List nlg_ssm::predict_interval(const arma::vec& probs, const arma::mat& th
       Pt.slice(0) = P_last.slice(i);
       
       for (unsigned int t = 0; t < (n - 1); t++) {
-        at.col(t + 1) = T_fn(t, at.col(t), theta, known_params, known_tv_params);
-        arma::mat Tg = T_gn(t, at.col(t), theta, known_params, known_tv_params);
+        arma::mat Tg;
+        at.col(t + 1) = T_linear(t, at.col(t), Tg);
         arma::mat Rt = R_fn(t, at.col(t), theta, known_params, known_tv_params);
         Pt.slice(t + 1) = Tg * Pt.slice(t) * Tg.t() + Rt * Rt.t();
       }
       for(unsigned int t = 0; t < n; t++) {
-        mean_pred(t, i) = arma::as_scalar(Z_fn(t, at.col(t), theta, known_params, known_tv_params));
-        arma::mat Zg = Z_gn(t, at.col(t), theta, known_params, known_tv_params);
-        var_pred(t, i) = arma::as_scalar(Zg * Pt.slice(t) * Zg.t());
+        arma::mat Zg;
+        mean_t(t, i) = arma::as_scalar(Z_linear(t, at.col(t), Zg));
+        var_t(t, i) = arma::as_scalar(Zg * Pt.slice(t) * Zg.t());
       }
       
       if (predict_type == 1) {
         for(unsigned int t = 0; t < n; t++) {
           arma::mat HHt = H_fn(t, at.col(t), theta, known_params, known_tv_params);
-          var_pred(t, i) += arma::as_scalar(HHt * HHt.t());
+          var_t(t, i) += arma::as_scalar(HHt * HHt.t());
         }
       }
       
     }
     
-    arma::mat expanded_sd = rep_mat(arma::sqrt(var_pred), counts);
-    arma::inplace_trans(expanded_sd);
-    arma::mat expanded_mean = rep_mat(mean_pred, counts);
-    arma::inplace_trans(expanded_mean);
-    
-    arma::mat intv = intervals(expanded_mean, expanded_sd, probs, n);
-    
-    return Rcpp::List::create(Rcpp::Named("intervals") = intv,
-      Rcpp::Named("mean_pred") = expanded_mean,
-      Rcpp::Named("sd_pred") = expanded_sd);
+    sd_pred.set_size(n_samples, n, 1);
+    sd_pred.slice(0) = arma::sqrt(var_t).t();
+    mean_pred.set_size(n_samples, n, 1);
+    mean_pred.slice(0) = mean_t.t();
+    intv.set_size(n, probs.n_elem, 1);
+    intv.slice(0) = intervals(mean_pred.slice(0), sd_pred.slice(0), 
+      counts, probs, n, n_threads);
   } else {
     
-    arma::cube mean_pred(n, n_samples, m);
-    arma::cube var_pred(n, n_samples, m);
+    arma::cube mean_t(n, n_samples, m);
+    arma::cube var_t(n, n_samples, m);
     
     for(unsigned int t = 0; t < n; t++) {
-      mean_pred.tube(t, 0) = at.col(t);
-      var_pred.tube(t, 0) = Pt.slice(t).diag();
+      mean_t.tube(t, 0) = at.col(t);
+      var_t.tube(t, 0) = Pt.slice(t).diag();
     }
     
     for (unsigned int i = 1; i < n_samples; i++) {
@@ -116,61 +265,35 @@ Rcpp::List nlg_ssm::predict_interval(const arma::vec& probs, const arma::mat& th
       Pt.slice(0) = P_last.slice(i);
       
       for (unsigned int t = 0; t < (n - 1); t++) {
-        at.col(t + 1) = T_fn(t, at.col(t), theta, known_params, known_tv_params);
-        arma::mat Tg = T_gn(t, at.col(t), theta, known_params, known_tv_params);
+        arma::mat Tg;
+        at.col(t + 1) = T_linear(t, at.col(t), Tg);
         arma::mat Rt = R_fn(t, at.col(t), theta, known_params, known_tv_params);
         Pt.slice(t + 1) = Tg * Pt.slice(t) * Tg.t() + Rt * Rt.t();
       }
       
       
       for(unsigned int t = 0; t < n; t++) {
-        mean_pred.tube(t, i) = at.col(t);
-        var_pred.tube(t, i) = Pt.slice(t).diag();
+        mean_t.tube(t, i) = at.col(t);
+        var_t.tube(t, i) = Pt.slice(t).diag();
       }
     }
     
-    arma::cube intv(n, probs.n_elem, m);
-    arma::cube expanded_sd(arma::accu(counts), n, m);
-    arma::cube expanded_mean(arma::accu(counts), n, m);
+    intv.set_size(n, probs.n_elem, m);
+    sd_pred.set_size(n_samples, n, m);
+    mean_pred.set_size(n_samples, n, m);
     for (unsigned int i = 0; i < m; i++) {
-      arma::mat tmp1 = rep_mat(arma::sqrt(var_pred.slice(i)), counts);
-      expanded_sd.slice(i) = tmp1.t();
-      arma::mat tmp2 = rep_mat(mean_pred.slice(i), counts);
-      expanded_mean.slice(i) = tmp2.t();
-      intv.slice(i) = intervals(expanded_mean.slice(i), expanded_sd.slice(i),
-        probs, n);
+      sd_pred.slice(i) = arma::sqrt(var_t.slice(i)).t();
+      mean_pred.slice(i) = mean_t.slice(i).t();
+      intv.slice(i) = intervals(mean_pred.slice(i), sd_pred.slice(i),
+        counts, probs, n, n_threads);
     }
-    
-    
-    return Rcpp::List::create(Rcpp::Named("intervals") = intv,
-      Rcpp::Named("mean_pred") = expanded_mean,
-      Rcpp::Named("sd_pred") = expanded_sd);
-  }
-}
-
-arma::cube nlg_ssm::predict_sample(const arma::mat& thetasim, 
-  const arma::mat& alpha, const arma::uvec& counts, 
-  const unsigned int predict_type, const unsigned int nsim) {
-  
-  unsigned int d = p;
-  if (predict_type == 3) d = m;
-  arma::mat expanded_theta = rep_mat(thetasim, counts);
-  arma::mat expanded_alpha = rep_mat(alpha, counts);
-  unsigned int n_samples = expanded_theta.n_cols;
-  arma::cube sample(d, n, nsim * n_samples);
-  for (unsigned int i = 0; i < n_samples; i++) {
-    
-    theta = expanded_theta.col(i);
-    
-    sample.slices(i * nsim, (i + 1) * nsim - 1) = 
-      sample_model(expanded_alpha.col(i), predict_type, nsim);
-    
   }
-  return sample;
 }
 
+// simulate nsim future paths starting from a1_sim using the given RNG
 arma::cube nlg_ssm::sample_model(const arma::vec& a1_sim,
-  const unsigned int predict_type, const unsigned int nsim) {
+  const unsigned int predict_type, const unsigned int nsim, 
+  sitmo::prng_engine& draw_engine) const {
   
   arma::cube alpha(m, n, nsim);
   
@@ -183,7 +306,7 @@ arma::cube nlg_ssm::sample_model(const arma::vec& a1_sim,
     for (unsigned int t = 0; t < (n - 1); t++) {
       arma::vec uk(k);
       for(unsigned int j = 0; j < k; j++) {
-        uk(j) = normal(engine);
+        uk(j) = normal(draw_engine);
       }
       alpha.slice(i).col(t + 1) = T_fn(t, alpha.slice(i).col(t), 
         theta, known_params, known_tv_params) +  
@@ -205,7 +328,7 @@ arma::cube nlg_ssm::sample_model(const arma::vec& a1_sim,
         for (unsigned int t = 0; t < n; t++) {
           arma::vec up(p);
           for (unsigned int j = 0; j < p; j++) {
-            up(j) = normal(engine);
+            up(j) = normal(draw_engine);
           }
           y_pred.slice(i).col(t) += H_fn(t, alpha.slice(i).col(t), 
             theta, known_params, known_tv_params) * up;
@@ -233,7 +356,8 @@ double nlg_ssm::ekf(arma::mat& at, arma::mat& att, arma::cube& Pt,
     
     if (na_y.n_elem < p) {
       
-      arma::mat Zg = Z_gn(t, at.col(t), theta, known_params, known_tv_params);
+      arma::mat Zg;
+      arma::vec Zt = Z_linear(t, at.col(t), Zg);
       arma::mat HHt = H_fn(t, at.col(t), theta, known_params, known_tv_params);
       HHt = HHt * HHt.t();
       
@@ -253,8 +377,7 @@ double nlg_ssm::ekf(arma::mat& at, arma::mat& att, arma::cube& Pt,
       chol_ok = arma::chol(cholF, Ft);
       if (!chol_ok) return -std::numeric_limits<double>::infinity();
       
-      arma::vec vt = y.col(t) - 
-        Z_fn(t, at.col(t), theta, known_params, known_tv_params);
+      arma::vec vt = y.col(t) - Zt;
       vt.rows(na_y).zeros();
       
       arma::mat inv_cholF = arma::inv(arma::trimatu(cholF));
@@ -264,7 +387,7 @@ double nlg_ssm::ekf(arma::mat& at, arma::mat& att, arma::cube& Pt,
       unsigned int i = 0;
       while (diff > 1e-4 && i < iekf_iter) {
         i++;
-        Zg = Z_gn(t, atthat, theta, known_params, known_tv_params);
+        Zt = Z_linear(t, atthat, Zg);
         HHt = H_fn(t, atthat, theta, known_params, known_tv_params);
         HHt = HHt * HHt.t();
         
@@ -282,9 +405,7 @@ double nlg_ssm::ekf(arma::mat& at, arma::mat& att, arma::cube& Pt,
         chol_ok = arma::chol(cholF, Ft);
         if(!chol_ok) return -std::numeric_limits<double>::infinity();
         
-        vt = y.col(t) - 
-          Z_fn(t, atthat, theta, known_params, known_tv_params) - 
-          Zg * (at.col(t) - atthat);
+        vt = y.col(t) - Zt - Zg * (at.col(t) - atthat);
         vt.rows(na_y).zeros();
         
         inv_cholF = arma::inv(arma::trimatu(cholF));
@@ -308,8 +429,8 @@ double nlg_ssm::ekf(arma::mat& at, arma::mat& att, arma::cube& Pt,
       Ptt.slice(t) = Pt.slice(t);
     } 
     
-    at.col(t + 1) = T_fn(t, att.col(t), theta, known_params, known_tv_params);
-    arma::mat Tg = T_gn(t, att.col(t), theta, known_params, known_tv_params);
+    arma::mat Tg;
+    at.col(t + 1) = T_linear(t, att.col(t), Tg);
     arma::mat Rt = R_fn(t, att.col(t), theta, known_params, known_tv_params);
     Pt.slice(t + 1) = Tg * Ptt.slice(t) * Tg.t() + Rt * Rt.t();
   }
@@ -334,7 +455,8 @@ double nlg_ssm::ekf_loglik(const unsigned int iekf_iter) const {
     arma::vec att = at;
     arma::mat Ptt = Pt;
     if (na_y.n_elem < p) {
-      arma::mat Zg = Z_gn(t, at, theta, known_params, known_tv_params);
+      arma::mat Zg;
+      arma::vec Zt = Z_linear(t, at, Zg);
       arma::mat HHt = H_fn(t, at, theta, known_params, known_tv_params);
       HHt = HHt * HHt.t();
       
@@ -353,8 +475,7 @@ double nlg_ssm::ekf_loglik(const unsigned int iekf_iter) const {
       chol_ok = arma::chol(cholF, Ft);
       if (!chol_ok) return -std::numeric_limits<double>::infinity();
       
-      arma::vec vt = y.col(t) - 
-        Z_fn(t, at, theta, known_params, known_tv_params);
+      arma::vec vt = y.col(t) - Zt;
       vt.rows(na_y).zeros();
       
       arma::mat inv_cholF = arma::inv(arma::trimatu(cholF));
@@ -365,7 +486,7 @@ double nlg_ssm::ekf_loglik(const unsigned int iekf_iter) const {
       unsigned int i = 0;
       while (diff > 1e-4 && i < iekf_iter) {
         i++;
-        Zg = Z_gn(t, atthat, theta, known_params, known_tv_params);
+        Zt = Z_linear(t, atthat, Zg);
         HHt = H_fn(t, atthat, theta, known_params, known_tv_params);
         HHt = HHt * HHt.t();
         
@@ -384,9 +505,7 @@ double nlg_ssm::ekf_loglik(const unsigned int iekf_iter) const {
         chol_ok = arma::chol(cholF, Ft);
         if (!chol_ok) return -std::numeric_limits<double>::infinity();
         
-        vt = y.col(t) - 
-          Z_fn(t, atthat, theta, known_params, known_tv_params) - 
-          Zg * (at.col(t) - atthat);
+        vt = y.col(t) - Zt - Zg * (at.col(t) - atthat);
         vt.rows(na_y).zeros();
         
         inv_cholF = arma::inv(arma::trimatu(cholF));
@@ -408,9 +527,8 @@ double nlg_ssm::ekf_loglik(const unsigned int iekf_iter) const {
         2.0 * arma::accu(arma::log(arma::diagvec(cholF))) + Fv.t() * Fv);
     }
     
-    at = T_fn(t, att, theta, known_params, known_tv_params);
-    
-    arma::mat Tg = T_gn(t, att, theta, known_params, known_tv_params);
+    arma::mat Tg;
+    at = T_linear(t, att, Tg);
     arma::mat Rt = R_fn(t, att, theta, known_params, known_tv_params);
     Pt = Tg * Ptt * Tg.t() + Rt * Rt.t();
     
@@ -439,7 +557,8 @@ double nlg_ssm::ekf_smoother(arma::mat& at, arma::cube& Pt, const unsigned int i
     
     if (na_y.n_elem < p) {
       
-      arma::mat Zg = Z_gn(t, at.col(t), theta, known_params, known_tv_params);
+      arma::mat Zg;
+      arma::vec Zt = Z_linear(t, at.col(t), Zg);
       arma::mat HHt = H_fn(t, at.col(t), theta, known_params, known_tv_params);
       HHt = HHt * HHt.t();
       if (na_y.n_elem > 0) {
@@ -457,8 +576,7 @@ double nlg_ssm::ekf_smoother(arma::mat& at, arma::cube& Pt, const unsigned int i
       chol_ok = arma::chol(cholF, Ft);
       if (!chol_ok) return -std::numeric_limits<double>::infinity();
       
-      vt.col(t) = y.col(t) - 
-        Z_fn(t, at.col(t), theta, known_params, known_tv_params);
+      vt.col(t) = y.col(t) - Zt;
       uvect(0) = t;
       vt.submat(na_y, uvect).zeros();
     
@@ -472,7 +590,7 @@ double nlg_ssm::ekf_smoother(arma::mat& at, arma::cube& Pt, const unsigned int i
       while (diff > 1e-4 && i < iekf_iter) {
         i++;
         
-        Zg = Z_gn(t, atthat, theta, known_params, known_tv_params);
+        Zt = Z_linear(t, atthat, Zg);
         HHt = H_fn(t, atthat, theta, known_params, known_tv_params);
         HHt = HHt * HHt.t();
         
@@ -490,9 +608,7 @@ double nlg_ssm::ekf_smoother(arma::mat& at, arma::cube& Pt, const unsigned int i
         chol_ok = arma::chol(cholF, Ft);
         if (!chol_ok) return -std::numeric_limits<double>::infinity();
         
-        vt.col(t) = y.col(t) - 
-          Z_fn(t, atthat, theta, known_params, known_tv_params) - 
-          Zg * (at.col(t) - atthat);
+        vt.col(t) = y.col(t) - Zt - Zg * (at.col(t) - atthat);
         vt.rows(na_y).zeros();
         
         inv_cholF = arma::inv(arma::trimatu(cholF));
@@ -515,8 +631,8 @@ double nlg_ssm::ekf_smoother(arma::mat& at, arma::cube& Pt, const unsigned int i
       att.col(t) = at.col(t);
     }
     
-    at.col(t + 1) = T_fn(t, att.col(t), theta, known_params, known_tv_params);
-    arma::mat Tg = T_gn(t, att.col(t), theta, known_params, known_tv_params);
+    arma::mat Tg;
+    at.col(t + 1) = T_linear(t, att.col(t), Tg);
     arma::mat Rt = R_fn(t, att.col(t), theta, known_params, known_tv_params);
     Pt.slice(t + 1) = Tg * Ptt * Tg.t() + Rt * Rt.t();
   }
@@ -526,10 +642,10 @@ double nlg_ssm::ekf_smoother(arma::mat& at, arma::cube& Pt, const unsigned int i
   arma::mat Nt(m, m, arma::fill::zeros);
   
   for (int t = (n - 1); t >= 0; t--) {
-    arma::mat Tg = T_gn(t, att.col(t), theta, known_params, known_tv_params);
+    arma::mat Tg = T_jacobian(t, att.col(t));
     arma::uvec na_y = arma::find_nonfinite(y.col(t));
     if (na_y.n_elem < p) {
-      arma::mat Zg = Z_gn(t, at.col(t), theta, known_params, known_tv_params);
+      arma::mat Zg = Z_jacobian(t, at.col(t));
       Zg.rows(na_y).zeros();
       arma::mat L = Tg * (arma::eye(m, m) - Kt.slice(t) * Zg);
       rt = ZFinv.slice(t) * vt.col(t) + L.t() * rt;
@@ -568,7 +684,8 @@ double nlg_ssm::ekf_fast_smoother(arma::mat& at, const unsigned int iekf_iter) c
     
     if (na_y.n_elem < p) {
       
-      arma::mat Zg = Z_gn(t, at.col(t), theta, known_params, known_tv_params);
+      arma::mat Zg;
+      arma::vec Zt = Z_linear(t, at.col(t), Zg);
       arma::mat HHt = H_fn(t, at.col(t), theta, known_params, known_tv_params);
       HHt = HHt * HHt.t();
       
@@ -587,8 +704,7 @@ double nlg_ssm::ekf_fast_smoother(arma::mat& at, const unsigned int iekf_iter) c
       chol_ok = arma::chol(cholF, Ft);
       if (!chol_ok) return -std::numeric_limits<double>::infinity();
       
-      vt.col(t) = y.col(t) - 
-        Z_fn(t, at.col(t), theta, known_params, known_tv_params);
+      vt.col(t) = y.col(t) - Zt;
       vt.rows(na_y).zeros();
       
       arma::mat inv_cholF = arma::inv(arma::trimatu(cholF));
@@ -601,7 +717,7 @@ double nlg_ssm::ekf_fast_smoother(arma::mat& at, const unsigned int iekf_iter) c
       unsigned int i = 0;
       while (diff > 1e-4 && i < iekf_iter) {
         i++;
-        Zg = Z_gn(t, atthat, theta, known_params, known_tv_params);
+        Zt = Z_linear(t, atthat, Zg);
         HHt = H_fn(t, atthat, theta, known_params, known_tv_params);
         HHt = HHt * HHt.t();
         
@@ -620,9 +736,7 @@ double nlg_ssm::ekf_fast_smoother(arma::mat& at, const unsigned int iekf_iter) c
         chol_ok = arma::chol(cholF, Ft);
         if (!chol_ok) return -std::numeric_limits<double>::infinity();
         
-        vt.col(t) = y.col(t) - 
-          Z_fn(t, atthat, theta, known_params, known_tv_params) - 
-          Zg * (at.col(t) - atthat);
+        vt.col(t) = y.col(t) - Zt - Zg * (at.col(t) - atthat);
         vt.rows(na_y).zeros();
         
         inv_cholF = arma::inv(arma::trimatu(cholF));
@@ -645,8 +759,8 @@ double nlg_ssm::ekf_fast_smoother(arma::mat& at, const unsigned int iekf_iter) c
       att.col(t) = at.col(t);
     }
     
-    at.col(t + 1) = T_fn(t, att.col(t), theta, known_params, known_tv_params);
-    arma::mat Tg = T_gn(t, att.col(t), theta, known_params, known_tv_params);
+    arma::mat Tg;
+    at.col(t + 1) = T_linear(t, att.col(t), Tg);
     arma::mat Rt = R_fn(t, att.col(t), theta, known_params, known_tv_params);
     Pt.slice(t + 1) = Tg * Ptt * Tg.t() + Rt * Rt.t();
     
@@ -655,10 +769,10 @@ double nlg_ssm::ekf_fast_smoother(arma::mat& at, const unsigned int iekf_iter) c
   
   arma::vec rt(m, arma::fill::zeros);
   for (int t = (n - 1); t >= 0; t--) {
-    arma::mat Tg = T_gn(t, att.col(t), theta, known_params, known_tv_params);
+    arma::mat Tg = T_jacobian(t, att.col(t));
     arma::uvec na_y = arma::find_nonfinite(y.col(t));
     if (na_y.n_elem < p) {
-      arma::mat Zg = Z_gn(t, at.col(t), theta, known_params, known_tv_params);
+      arma::mat Zg = Z_jacobian(t, at.col(t));
       Zg.rows(na_y).zeros();
       arma::mat L = Tg * (arma::eye(m, m) - Kt.slice(t) * Zg);
       rt = ZFinv.slice(t) * vt.col(t) + L.t() * rt;
@@ -674,23 +788,19 @@ double nlg_ssm::ekf_fast_smoother(arma::mat& at, const unsigned int iekf_iter) c
 // Unscented Kalman filter, Särkkä (2013) p.107 (UKF) and
 // Note that the initial distribution is given for alpha_1
 // so we first do update instead of prediction
+// square-root UKF, which propagates the Cholesky factors of Pt and Ptt, 
+// see van der Merwe & Wan (2001)
 double nlg_ssm::ukf(arma::mat& at, arma::mat& att, arma::cube& Pt, 
-  arma::cube& Ptt, const double alpha, const double beta, const double kappa) const {
-  
-  // // Parameters of UKF, currently fixed for simplicity
-  // These are from Särkkä?
-  // double alpha = 1.0;
-  // double beta = 0.0;
-  // double kappa = 4.0;
-  // van der Merwe et al:
-  // alpha something small...
-  // beta = 4? 
-  // kappa = 0
-  //DK? alpha=1, beta=0, kappa 3-m?
+  arma::cube& Ptt, const double alpha, const double beta, const double kappa,
+  const unsigned int n_threads) const {
+  
   const double LOG2PI = std::log(2.0 * M_PI);
   double logLik = 0.0;
   
   double lambda = alpha * alpha * (m + kappa) - m;
+  if (lambda + m <= 0.0) {
+    stop_error("Invalid parameters of UKF, alpha^2 * (m + kappa) must be positive.");
+  }
   
   unsigned int n_sigma = 2 * m + 1;
   arma::vec wm(n_sigma);
@@ -698,22 +808,21 @@ double nlg_ssm::ukf(arma::mat& at, arma::mat& att, arma::cube& Pt,
   wm.subvec(1, n_sigma - 1).fill(1.0 / (2.0 * (lambda + m)));
   arma::vec wc = wm;
   wc(0) +=  1.0 - alpha * alpha + beta;
-  
+  const double sqrt_wc = std::sqrt(wc(1));
   
   double sqrt_m_lambda = std::sqrt(m + lambda);
   
   at.col(0) = a1_fn(theta, known_params);
   Pt.slice(0) = P1_fn(theta, known_params);
+  // Cholesky factors of Pt and Ptt
+  arma::mat cholP = psd_chol(Pt.slice(0));
+  arma::mat cholPtt(m, m);
   
+  arma::mat sigma(m, n_sigma);
   for (unsigned int t = 0; t < n; t++) {
     // update step
     
-    // compute cholesky of Pt
-    arma::mat cholP(m, m);
-    cholP = psd_chol(Pt.slice(t));
-    
     // form the sigma points
-    arma::mat sigma(m, n_sigma);
     sigma.col(0) = at.col(t);
     for (unsigned int i = 1; i <= m; i++) {
       sigma.col(i) = at.col(t) + sqrt_m_lambda * cholP.col(i - 1);
@@ -726,61 +835,188 @@ double nlg_ssm::ukf(arma::mat& at, arma::mat& att, arma::cube& Pt,
       
       // propagate sigma points
       arma::mat sigma_y(obs_y.n_elem, n_sigma);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads) if(n_threads > 1)
+#endif
       for (unsigned int i = 0; i < n_sigma; i++) {
         sigma_y.col(i) = Z_fn(t, sigma.col(i), theta, known_params, known_tv_params).rows(obs_y);
       }
       arma::vec pred_mean = sigma_y * wm;
-      arma::mat pred_var = H_fn(t, at.col(t), theta, known_params, known_tv_params).submat(obs_y, obs_y);
-      arma::mat pred_cov(m, obs_y.n_elem, arma::fill::zeros);
-      for (unsigned int i = 0; i < n_sigma; i++) {
-        arma::vec tmp = sigma_y.col(i) - pred_mean;
-        pred_var += wc(i) * tmp * tmp.t();
-        pred_cov += wc(i) * (sigma.col(i) - at.col(t)) * tmp.t();
+      arma::mat dev_y = sigma_y.each_col() - pred_mean;
+      arma::mat H = H_fn(t, at.col(t), theta, known_params, known_tv_params).rows(obs_y);
+      // Cholesky factor of the prediction variance
+      arma::mat cholF;
+      if (!sqrt_cov(arma::join_rows(sqrt_wc * dev_y.cols(1, n_sigma - 1), H), 
+        dev_y.col(0), wc(0), cholF)) {
+        arma::mat pred_var = H * H.t() + dev_y * arma::diagmat(wc) * dev_y.t();
+        cholF = arma::chol(arma::symmatu(pred_var), "lower");
       }
+      arma::mat pred_cov = (sigma.each_col() - at.col(t)) * arma::diagmat(wc) * dev_y.t();
+      
       // filtered estimates
       arma::vec v = arma::mat(y.rows(obs_y)).col(t) - pred_mean;
-      arma::mat K = arma::solve(pred_var, pred_cov.t()).t();
+      // K = C F^-1 = C L'^-1 L^-1
+      arma::mat K = arma::solve(arma::trimatu(cholF.t()), 
+        arma::solve(arma::trimatl(cholF), pred_cov.t())).t();
       att.col(t) = at.col(t) + K * v;
-      Ptt.slice(t) = Pt.slice(t) - K * pred_var * K.t();
+      // Ptt = Pt - (K L) (K L)'
+      arma::mat U = K * cholF;
+      cholPtt = cholP;
+      bool success = true;
+      for (unsigned int j = 0; j < U.n_cols && success; j++) {
+        success = chol_update(cholPtt, U.col(j), -1.0);
+      }
+      if (!success) {
+        cholPtt = psd_chol(arma::symmatu(cholP * cholP.t() - U * U.t()));
+      }
+      Ptt.slice(t) = cholPtt * cholPtt.t();
       
-      arma::mat cholF = arma::chol(pred_var);
-      arma::mat inv_cholF = arma::inv(arma::trimatu(cholF));
-      arma::vec Fv = inv_cholF.t() * v; 
-      logLik -= 0.5 * arma::as_scalar(obs_y.n_elem * LOG2PI + 
-        2.0 * arma::accu(arma::log(arma::diagvec(cholF))) + Fv.t() * Fv);
+      arma::vec Fv = arma::solve(arma::trimatl(cholF), v); 
+      logLik -= 0.5 * (obs_y.n_elem * LOG2PI + 
+        2.0 * arma::accu(arma::log(arma::abs(arma::diagvec(cholF)))) + arma::dot(Fv, Fv));
     } else {
       att.col(t) = at.col(t);
       Ptt.slice(t) = Pt.slice(t);
+      cholPtt = cholP;
     }
     
     // prediction
-    // compute cholesky of Ptt
-    arma::mat cholPtt = psd_chol(Ptt.slice(t));
-    
     // form the sigma points and propagate
-    sigma.col(0) = T_fn(t, att.col(t), theta, known_params, known_tv_params);
-    for (unsigned int i = 1; i <= m; i++) {
-      sigma.col(i) = T_fn(t, att.col(t) + sqrt_m_lambda * cholPtt.col(i - 1), 
-        theta, known_params, known_tv_params);
-      sigma.col(i + m) = T_fn(t, att.col(t) - sqrt_m_lambda * cholPtt.col(i - 1), 
-        theta, known_params, known_tv_params);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads) if(n_threads > 1)
+#endif
+    for (unsigned int i = 0; i < n_sigma; i++) {
+      arma::vec x = att.col(t);
+      if (i > 0) {
+        unsigned int j = (i - 1) % m;
+        x += (i <= m ? sqrt_m_lambda : -sqrt_m_lambda) * cholPtt.col(j);
+      }
+      sigma.col(i) = T_fn(t, x, theta, known_params, known_tv_params);
     }
     
     at.col(t + 1) = sigma * wm;
     
     arma::mat Rt = R_fn(t, att.col(t), theta, known_params, known_tv_params);
-    Pt.slice(t + 1) = Rt * Rt.t();
-    for (unsigned int i = 0; i < n_sigma; i++) {
-      arma::vec tmp = sigma.col(i) - at.col(t + 1);
-      Pt.slice(t + 1) += wc(i) * tmp * tmp.t();
+    arma::mat dev = sigma.each_col() - at.col(t + 1);
+    if (!sqrt_cov(arma::join_rows(sqrt_wc * dev.cols(1, n_sigma - 1), Rt), 
+      dev.col(0), wc(0), cholP)) {
+      cholP = psd_chol(arma::symmatu(Rt * Rt.t() + dev * arma::diagmat(wc) * dev.t()));
     }
+    Pt.slice(t + 1) = cholP * cholP.t();
   }
   return logLik;
 }
 
+double nlg_ssm::ukf_loglik(const double alpha, const double beta, 
+  const double kappa, const unsigned int n_threads) const {
+  
+  arma::mat at(m, n + 1);
+  arma::mat att(m, n);
+  arma::cube Pt(m, m, n + 1);
+  arma::cube Ptt(m, m, n);
+  return ukf(at, att, Pt, Ptt, alpha, beta, kappa, n_threads);
+}
+
+double nlg_ssm::enkf(const unsigned int n_ens, const bool square_root, 
+  sitmo::prng_engine& eng, arma::cube& alpha, const bool smooth, 
+  const unsigned int n_threads, const unsigned int lag) const {
+  
+  if (n_ens < 2) {
+    stop_error("Ensemble size must be at least 2.");
+  }
+  const double LOG2PI = std::log(2.0 * M_PI);
+  const bool store = alpha.n_slices == n;
+  // anomalies are scaled so that A A' is the sample covariance
+  const double scale = 1.0 / std::sqrt(n_ens - 1.0);
+  double logLik = 0.0;
+  
+  arma::mat X = psd_chol(P1_fn(theta, known_params)) * normal_draws(m, n_ens, eng);
+  X.each_col() += a1_fn(theta, known_params);
+  
+  for (unsigned int t = 0; t < n; t++) {
+    
+    arma::uvec obs_y = arma::find_finite(y.col(t));
+    if (obs_y.n_elem > 0) {
+      
+      arma::mat Y(obs_y.n_elem, n_ens);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads) if(n_threads > 1)
+#endif
+      for (unsigned int i = 0; i < n_ens; i++) {
+        Y.col(i) = Z_fn(t, X.col(i), theta, known_params, known_tv_params).rows(obs_y);
+      }
+      arma::vec x_mean = arma::mean(X, 1);
+      arma::vec y_mean = arma::mean(Y, 1);
+      arma::mat A = (X.each_col() - x_mean) * scale;
+      arma::mat B = (Y.each_col() - y_mean) * scale;
+      arma::mat H = H_fn(t, x_mean, theta, known_params, known_tv_params).rows(obs_y);
+      
+      // Cholesky factor of the prediction variance B B' + H H' 
+      arma::mat cholF;
+      if (!arma::chol(cholF, arma::symmatu(B * B.t() + H * H.t()), "lower")) {
+        return -std::numeric_limits<double>::infinity();
+      }
+      arma::mat W = arma::solve(arma::trimatl(cholF), B);
+      arma::vec v = arma::mat(y.rows(obs_y)).col(t) - y_mean;
+      arma::vec Fv = arma::solve(arma::trimatl(cholF), v);
+      logLik -= 0.5 * (obs_y.n_elem * LOG2PI + 
+        2.0 * arma::accu(arma::log(arma::diagvec(cholF))) + arma::dot(Fv, Fv));
+      
+      // the analysis is X + A G, as the gain is A B' (B B' + H H')^-1
+      arma::mat G;
+      if (square_root) {
+        // mean update and symmetric square root of I - W'W
+        arma::vec mu;
+        arma::mat U;
+        arma::eig_sym(mu, U, arma::eye(n_ens, n_ens) - W.t() * W);
+        mu = arma::sqrt(arma::clamp(mu, 0.0, 1.0));
+        G = (U * arma::diagmat(mu) * U.t() - arma::eye(n_ens, n_ens)) / scale;
+        G.each_col() += W.t() * Fv;
+      } else {
+        // perturbed observations
+        arma::mat D = H * normal_draws(H.n_cols, n_ens, eng) - Y;
+        D.each_col() += arma::mat(y.rows(obs_y)).col(t);
+        G = W.t() * arma::solve(arma::trimatl(cholF), D);
+      }
+      X += A * G;
+      // the same transformation of the earlier ensembles gives the smoother
+      if (store && smooth) {
+        for (unsigned int s = (t > lag ? t - lag : 0); s < t; s++) {
+          arma::mat A_s = (alpha.slice(s).each_col() - arma::mean(alpha.slice(s), 1)) * scale;
+          alpha.slice(s) += A_s * G;
+        }
+      }
+    }
+    if (store) {
+      alpha.slice(t) = X;
+    }
+    
+    if (t < (n - 1)) {
+      arma::mat eta = normal_draws(k, n_ens, eng);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads) if(n_threads > 1)
+#endif
+      for (unsigned int i = 0; i < n_ens; i++) {
+        arma::vec x = X.col(i);
+        X.col(i) = T_fn(t, x, theta, known_params, known_tv_params) + 
+          R_fn(t, x, theta, known_params, known_tv_params) * eta.col(i);
+      }
+    }
+  }
+  return logLik;
+}
+
+double nlg_ssm::enkf_loglik(const unsigned int n_ens, const bool square_root, 
+  const unsigned int n_threads) const {
+  
+  sitmo::prng_engine eng(seed);
+  arma::cube alpha;
+  return enkf(n_ens, square_root, eng, alpha, false, n_threads);
+}
+
 mgg_ssm nlg_ssm::approximate(arma::mat& mode_estimate, 
   const unsigned int max_iter, const double conv_tol, 
-  const unsigned int iekf_iter) const {
+  const unsigned int iekf_iter, const unsigned int n_threads) const {
   
   // initial approximation is based on EKF (at and att)
   arma::mat at(m, n + 1);
@@ -805,51 +1041,59 @@ mgg_ssm nlg_ssm::approximate(arma::mat& mode_estimate,
   arma::vec a1 = a1_fn(theta, known_params);
   arma::mat P1 = P1_fn(theta, known_params);
   arma::cube Z(p, m, n);
-  for (unsigned int t = 0; t < Z.n_slices; t++) {
-    Z.slice(t) = Z_gn(t, at.col(t), theta, known_params, known_tv_params);
-  }
   arma::cube H(p, p, (n - 1) * Htv + 1);
-  for (unsigned int t = 0; t < H.n_slices; t++) {
-    H.slice(t) = H_fn(t, at.col(t), theta, known_params, known_tv_params);
-  }
   arma::cube T(m, m, n);
-  for (unsigned int t = 0; t < T.n_slices; t++) {
-    T.slice(t) = T_gn(t, att.col(t), theta, known_params, known_tv_params);
-  }
-  
   arma::cube R(m, k, (n - 1) * Rtv + 1);
-  for (unsigned int t = 0; t < R.n_slices; t++) {
-    R.slice(t) = R_fn(t, att.col(t), theta, known_params, known_tv_params);
-  }
   arma::mat D(p, n,arma::fill::zeros);
   arma::mat C(m, n,arma::fill::zeros);
   
+  // the time points are independent given the EKF estimates
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads) if(n_threads > 1)
+#endif
   for (unsigned int t = 0; t < n; t++) {
-    D.col(t) = Z_fn(t, at.col(t), theta, known_params, known_tv_params) -
-      Z.slice(t) * at.col(t);
-    C.col(t) =  T_fn(t, att.col(t), theta, known_params, known_tv_params) -
-      T.slice(t) * att.col(t);
+    if (t < H.n_slices) {
+      H.slice(t) = H_fn(t, at.col(t), theta, known_params, known_tv_params);
+    }
+    if (t < R.n_slices) {
+      R.slice(t) = R_fn(t, att.col(t), theta, known_params, known_tv_params);
+    }
+    D.col(t) = Z_linear(t, at.col(t), Z.slice(t)) - Z.slice(t) * at.col(t);
+    C.col(t) = T_linear(t, att.col(t), T.slice(t)) - T.slice(t) * att.col(t);
   }
   
   mgg_ssm approx_model(y, Z, H, T, R, a1, P1, arma::cube(0,0,0),
     arma::mat(0,0), D, C, seed);
   // Refine approximation iteratively
-  mode_estimate = approximate(approx_model, max_iter, conv_tol);
+  mode_estimate = approximate(approx_model, max_iter, conv_tol, n_threads);
   
   return approx_model;
 }
 
 arma::mat nlg_ssm::approximate(mgg_ssm& approx_model,
-  const unsigned int max_iter, const double conv_tol) const {
+  const unsigned int max_iter, const double conv_tol, 
+  const unsigned int n_threads) const {
   
   
   //check model
+  approx_iter = 0;
   arma::mat mode_estimate = approx_model.fast_smoother().head_cols(n);
   if (!arma::is_finite(mode_estimate)) {
     return mode_estimate;
   }
+  // values of the model functions at the current mode estimate, evaluated 
+  // with the log-density and reused in the next linearisation
+  arma::mat Z_values(p, n);
+  arma::mat T_values(m, n);
+  arma::cube H(p, p, approx_model.H.n_slices);
+  arma::cube R(m, k, approx_model.R.n_slices);
+  arma::mat Z_values_new(p, n);
+  arma::mat T_values_new(m, n);
+  arma::cube H_new(p, p, approx_model.H.n_slices);
+  arma::cube R_new(m, k, approx_model.R.n_slices);
+  
   double ll;
-  if (max_iter > 0) ll = log_signal_pdf(mode_estimate);
+  if (max_iter > 0) ll = log_signal_pdf(mode_estimate, Z_values, T_values, H, R, n_threads);
   unsigned int i = 0;
   double rel_diff = 1.0e300; 
   double abs_diff = 1;
@@ -857,32 +1101,44 @@ arma::mat nlg_ssm::approximate(mgg_ssm& approx_model,
   while(i < max_iter && rel_diff > conv_tol && abs_diff > 1e-4) {
     
     i++;
-    for (unsigned int t = 0; t < approx_model.Z.n_slices; t++) {
-      approx_model.Z.slice(t) = Z_gn(t, mode_estimate.col(t), theta, known_params, known_tv_params);
-    }
-    
-    for (unsigned int t = 0; t < approx_model.T.n_slices; t++) {
-      approx_model.T.slice(t) = T_gn(t, mode_estimate.col(t), theta, known_params, known_tv_params);
+    approx_iter = i;
+    // the function values at the mode are already known from the evaluation 
+    // of the log-density, only the Jacobians of the distinct slices are needed
+    const unsigned int n_jac = std::max(approx_model.Z.n_slices, approx_model.T.n_slices);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads) if(n_threads > 1)
+#endif
+    for (unsigned int t = 0; t < n_jac; t++) {
+      if (t < approx_model.Z.n_slices) {
+        if (Z_gn) {
+          approx_model.Z.slice(t) = Z_gn(t, mode_estimate.col(t), theta, known_params, known_tv_params);
+        } else {
+          approx_model.Z.slice(t) = numerical_jacobian(Z_fn, t, mode_estimate.col(t), 
+            Z_values.col(t), theta, known_params, known_tv_params);
+        }
+      }
+      if (t < approx_model.T.n_slices) {
+        if (T_gn) {
+          approx_model.T.slice(t) = T_gn(t, mode_estimate.col(t), theta, known_params, known_tv_params);
+        } else {
+          approx_model.T.slice(t) = numerical_jacobian(T_fn, t, mode_estimate.col(t), 
+            T_values.col(t), theta, known_params, known_tv_params);
+        }
+      }
     }
-    
     for (unsigned int t = 0; t < n; t++) {
-      approx_model.D.col(t) = Z_fn(t, mode_estimate.col(t), theta, known_params, known_tv_params) -
-        approx_model.Z.slice(t * Zgtv) * mode_estimate.col(t);
-      approx_model.C.col(t) =  T_fn(t, mode_estimate.col(t), theta, known_params, known_tv_params) -
-        approx_model.T.slice(t * Tgtv) * mode_estimate.col(t);
-    }
-    for (unsigned int t = 0; t < approx_model.H.n_slices; t++) {
-      approx_model.H.slice(t) = H_fn(t, mode_estimate.col(t), theta, known_params, known_tv_params);
-    }
-    for (unsigned int t = 0; t < approx_model.R.n_slices; t++) {
-      approx_model.R.slice(t) = R_fn(t, mode_estimate.col(t), theta, known_params, known_tv_params);
+      approx_model.D.col(t) = Z_values.col(t) - approx_model.Z.slice(t * Zgtv) * mode_estimate.col(t);
+      approx_model.C.col(t) = T_values.col(t) - approx_model.T.slice(t * Tgtv) * mode_estimate.col(t);
     }
+    approx_model.H = H;
+    approx_model.R = R;
     approx_model.compute_HH();
     approx_model.compute_RR();
     
     // compute new value of mode
     arma::mat mode_estimate_new = approx_model.fast_smoother().head_cols(n);
-    double ll_new = log_signal_pdf(mode_estimate_new);
+    double ll_new = log_signal_pdf(mode_estimate_new, Z_values_new, T_values_new, 
+      H_new, R_new, n_threads);
     abs_diff = ll_new - ll;
     rel_diff = abs_diff / std::abs(ll);
     if (!arma::is_finite(mode_estimate_new) || !arma::is_finite(ll_new)) {
@@ -900,7 +1156,8 @@ arma::mat nlg_ssm::approximate(mgg_ssm& approx_model,
         step_size = step_size / 2.0;
         mode_estimate = (1.0 - step_size) * mode_estimate_old + step_size * mode_estimate_new;
         
-        ll_new = log_signal_pdf(mode_estimate);
+        ll_new = log_signal_pdf(mode_estimate, Z_values_new, T_values_new, 
+          H_new, R_new, n_threads);
         abs_diff = ll_new - ll;
         rel_diff = abs_diff / std::abs(ll);
         ii++;
@@ -917,6 +1174,10 @@ arma::mat nlg_ssm::approximate(mgg_ssm& approx_model,
     }
     mode_estimate = mode_estimate_new;
     ll = ll_new;
+    std::swap(Z_values, Z_values_new);
+    std::swap(T_values, T_values_new);
+    std::swap(H, H_new);
+    std::swap(R, R_new);
     
   }
   if (i == max_iter && max_iter > 0) {
@@ -935,48 +1196,39 @@ arma::vec nlg_ssm::log_weights(const mgg_ssm& approx_model,
   arma::uvec na_y = arma::find_nonfinite(y.col(t));
   if (na_y.n_elem < p) {
     
-    // original H depends on time or state <=> approx H depends on time or state, or missing values
-    if(Htv == 1 || na_y.n_elem > 0) {
+    // H of the approximating model does not depend on the particles
+    dmvnorm_factor H_a(approx_model.H.slice(t * approx_model.Htv), true, 
+      arma::find_finite(y.col(t)));
+    // original H depends on time or state, or missing values
+    if(!H_fixed || na_y.n_elem > 0) {
       for (unsigned int i = 0; i < alpha.n_slices; i++) {
         weights(i) = 
           dmvnorm(y.col(t), Z_fn(t, alpha.slice(i).col(t), theta, known_params, known_tv_params), 
             H_fn(t, alpha.slice(i).col(t), theta, known_params, known_tv_params), true, true) -
-              dmvnorm(y.col(t), approx_model.D.col(t) + approx_model.Z.slice(t * approx_model.Ztv) * alpha.slice(i).col(t),  
-                approx_model.H.slice(t * approx_model.Htv), true, true);
+              H_a.logpdf(y.col(t), approx_model.D.col(t) + 
+                approx_model.Z.slice(t * approx_model.Ztv) * alpha.slice(i).col(t));
       }
     } else {
-      arma::mat H = H_fn(t, alpha.slice(0).col(t), theta, known_params, known_tv_params);
-      arma::uvec nonzero = arma::find(H.diag() > (std::numeric_limits<double>::epsilon() * H.n_cols * H.diag().max()));
-      arma::mat Linv(nonzero.n_elem, nonzero.n_elem);
-      double constant = precompute_dmvnorm(H, Linv, nonzero);
-      
-      arma::mat H_a = approx_model.H.slice(0);
-      arma::uvec nonzero_a = arma::find(H_a.diag() > (std::numeric_limits<double>::epsilon() * H_a.n_cols * H_a.diag().max()));
-      arma::mat Linv_a(nonzero_a.n_elem, nonzero_a.n_elem);
-      double constant_a = precompute_dmvnorm(H_a, Linv_a, nonzero_a);
-      
+      const dmvnorm_factor& H = invariant_H(alpha.slice(0).col(t));
       for (unsigned int i = 0; i < alpha.n_slices; i++) {
-        weights(i) = fast_dmvnorm(y.col(t), Z_fn(t, alpha.slice(i).col(t), 
-          theta, known_params, known_tv_params), Linv, nonzero, constant) -
-            fast_dmvnorm(y.col(t), approx_model.D.col(t) + 
-            approx_model.Z.slice(t * approx_model.Ztv) * alpha.slice(i).col(t),  
-            Linv_a, nonzero_a, constant_a);
+        weights(i) = H.logpdf(y.col(t), Z_fn(t, alpha.slice(i).col(t), 
+          theta, known_params, known_tv_params)) -
+            H_a.logpdf(y.col(t), approx_model.D.col(t) + 
+              approx_model.Z.slice(t * approx_model.Ztv) * alpha.slice(i).col(t));
       }
     }
   }
   arma::vec weights_t(alpha.n_slices, arma::fill::zeros);
   if(t > 0) {
+    dmvnorm_factor RR_a(approx_model.RR.slice((t - 1) * approx_model.Rtv), false, 
+      arma::regspace<arma::uvec>(0, m - 1));
     for (unsigned int i = 0; i < alpha.n_slices; i++) {
       
-      arma::vec mean = T_fn(t - 1, alpha_prev.col(i), theta, known_params, known_tv_params);
-      arma::mat cov = R_fn(t - 1, alpha_prev.col(i), theta, known_params, known_tv_params);
-      cov = cov * cov.t();
       arma::vec approx_mean = approx_model.C.col(t - 1) + 
         approx_model.T.slice((t - 1) * approx_model.Ttv) * alpha_prev.col(i);
       
-      weights_t(i) +=  dmvnorm(alpha.slice(i).col(t), approx_mean, 
-        approx_model.RR.slice((t - 1) * approx_model.Rtv), false, true) -
-          dmvnorm(alpha.slice(i).col(t), mean, cov, false, true);
+      weights_t(i) = RR_a.logpdf(alpha.slice(i).col(t), approx_mean) -
+        log_state_density(t - 1, alpha_prev.col(i), alpha.slice(i).col(t));
       weights_t(i) = log1pexp(weights_t(i));
     }
   }
@@ -995,21 +1247,17 @@ arma::vec nlg_ssm::scaling_factors(const mgg_ssm& approx_model,
   for(unsigned int t = 0; t < n; t++) { 
     arma::uvec na_y = arma::find_nonfinite(y.col(t));
     if (na_y.n_elem < p) {
-      weights(t) =  dmvnorm(y.col(t), Z_fn(t, mode_estimate.col(t), theta, known_params, known_tv_params),
-        H_fn(t, mode_estimate.col(t), theta, known_params, known_tv_params), true, true) -
+      weights(t) =  log_obs_density(t, mode_estimate.col(t)) -
           dmvnorm(y.col(t), approx_model.D.col(t) + approx_model.Z.slice(t * approx_model.Ztv) * mode_estimate.col(t),
             approx_model.H.slice(t * approx_model.Htv), true, true);
     }
   }
   
   for (unsigned int t = 1; t < n; t++) {
-    arma::vec mean = T_fn(t-1, mode_estimate.col(t-1), theta, known_params, known_tv_params);
-    arma::mat cov = R_fn(t-1, mode_estimate.col(t-1), theta, known_params, known_tv_params);
-    cov = cov * cov.t();
     arma::vec approx_mean = approx_model.C.col(t-1) +
       approx_model.T.slice((t-1) * approx_model.Ttv) * mode_estimate.col(t-1);
     
-    weights(t) += dmvnorm(mode_estimate.col(t), mean, cov, false, true) -
+    weights(t) += log_state_density(t - 1, mode_estimate.col(t - 1), mode_estimate.col(t)) -
       dmvnorm(mode_estimate.col(t), approx_mean, approx_model.RR.slice((t-1) * approx_model.Rtv), false, true);
     
   }
@@ -1029,27 +1277,52 @@ arma::vec nlg_ssm::log_obs_density(const unsigned int t,
   
   arma::uvec na_y = arma::find_nonfinite(y.col(t));
   if (na_y.n_elem < p) {
-    for (unsigned int i = 0; i < alpha.n_slices; i++) {
-      weights(i) = dmvnorm(y.col(t), Z_fn(t, alpha.slice(i).col(t), theta, known_params, known_tv_params), 
-        H_fn(t, alpha.slice(i).col(t), theta, known_params, known_tv_params), true, true);
+    if (!H_fixed || na_y.n_elem > 0) {
+      for (unsigned int i = 0; i < alpha.n_slices; i++) {
+        weights(i) = dmvnorm(y.col(t), Z_fn(t, alpha.slice(i).col(t), theta, known_params, known_tv_params), 
+          H_fn(t, alpha.slice(i).col(t), theta, known_params, known_tv_params), true, true);
+      }
+    } else {
+      const dmvnorm_factor& H = invariant_H(alpha.slice(0).col(t));
+      for (unsigned int i = 0; i < alpha.n_slices; i++) {
+        weights(i) = H.logpdf(y.col(t), 
+          Z_fn(t, alpha.slice(i).col(t), theta, known_params, known_tv_params));
+      }
     }
   }
   return weights;
 }
 
 double nlg_ssm::log_obs_density(const unsigned int t, 
-  const arma::vec& alpha) const {
+  const arma::vec& alpha, const unsigned int t_offset) const {
   
   double weight = 0.0;
+  unsigned int time = t + t_offset;
   
   arma::uvec na_y = arma::find_nonfinite(y.col(t));
-  if (na_y.n_elem < p) {
-    weight = dmvnorm(y.col(t), Z_fn(t, alpha, theta, known_params, known_tv_params), 
-      H_fn(t, alpha, theta, known_params, known_tv_params), true, true);
+  if (na_y.n_elem == 0 && H_fixed) {
+    weight = invariant_H(alpha).logpdf(y.col(t), 
+      Z_fn(time, alpha, theta, known_params, known_tv_params));
+  } else if (na_y.n_elem < p) {
+    weight = dmvnorm(y.col(t), Z_fn(time, alpha, theta, known_params, known_tv_params), 
+      H_fn(time, alpha, theta, known_params, known_tv_params), true, true);
   }
   return weight;
 }
 
+// log-density of alpha_next given alpha at time t
+double nlg_ssm::log_state_density(const unsigned int t, 
+  const arma::vec& alpha, const arma::vec& alpha_next) const {
+  
+  arma::vec mean = T_fn(t, alpha, theta, known_params, known_tv_params);
+  if (RR_fixed) {
+    return invariant_RR(alpha).logpdf(alpha_next, mean);
+  }
+  arma::mat cov = R_fn(t, alpha, theta, known_params, known_tv_params);
+  cov = cov * cov.t();
+  return dmvnorm(alpha_next, mean, cov, false, true);
+}
+
 // apart from using mgg_ssm, identical with ung_ssm::psi_filter
 double nlg_ssm::psi_filter(const mgg_ssm& approx_model,
   const double approx_loglik,
@@ -1225,18 +1498,98 @@ double nlg_ssm::bsf_filter(const unsigned int nsim, arma::cube& alpha,
 }
 
 
+// bootstrap filter for new observations y given particles alpha (m x nsim)
+// from the predictive distribution of the first state, see ung_ssm::bsf_update
+double nlg_ssm::bsf_update(const unsigned int nsim, arma::mat& alpha, 
+  const unsigned int t_offset) {
+  // the particles are written back to alpha only if the whole batch is 
+  // filtered successfully
+  arma::mat particles = alpha;
+  
+  std::normal_distribution<> normal(0.0, 1.0);
+  if (particles.n_cols == 0) {
+    arma::vec a1 = a1_fn(theta, known_params);
+    arma::mat L_P1 = psd_chol(P1_fn(theta, known_params));
+    particles.set_size(m, nsim);
+    for (unsigned int i = 0; i < nsim; i++) {
+      arma::vec um(m);
+      for(unsigned int j = 0; j < m; j++) {
+        um(j) = normal(engine);
+      }
+      particles.col(i) = a1 + L_P1 * um;
+    }
+  }
+  if (particles.n_rows != m || particles.n_cols != nsim) {
+    stop_error("Dimensions of the particle matrix do not match the model.");
+  }
+  
+  std::uniform_real_distribution<> unif(0.0, 1.0);
+  arma::vec normalized_weights(nsim);
+  arma::vec weights(nsim);
+  double loglik = 0.0;
+  
+  for (unsigned int t = 0; t < n; t++) {
+    
+    if (arma::uvec(arma::find_nonfinite(y.col(t))).n_elem < p) {
+      for (unsigned int i = 0; i < nsim; i++) {
+        weights(i) = log_obs_density(t, particles.col(i), t_offset);
+      }
+      double max_weight = weights.max();
+      weights = arma::exp(weights - max_weight);
+      double sum_weights = arma::accu(weights);
+      if(sum_weights > 0.0){
+        normalized_weights = weights / sum_weights;
+      } else {
+        return -std::numeric_limits<double>::infinity();
+      }
+      loglik += max_weight + std::log(sum_weights / nsim);
+    } else {
+      normalized_weights.fill(1.0 / nsim);
+    }
+    
+    arma::vec r(nsim);
+    for (unsigned int i = 0; i < nsim; i++) {
+      r(i) = unif(engine);
+    }
+    arma::uvec indices = stratified_sample(normalized_weights, r, nsim);
+    arma::mat alphatmp = particles.cols(indices);
+    
+    for (unsigned int i = 0; i < nsim; i++) {
+      arma::vec uk(k);
+      for(unsigned int j = 0; j < k; j++) {
+        uk(j) = normal(engine);
+      }
+      particles.col(i) = T_fn(t + t_offset, alphatmp.col(i), theta, known_params, 
+        known_tv_params) + 
+        R_fn(t + t_offset, alphatmp.col(i), theta, known_params, known_tv_params) * uk;
+    }
+  }
+  alpha = particles;
+  return loglik;
+}
+
 // EKF-based particle filter (van der Merwe et al)
 
+// the linearisations of the particles are computed in parallel using n_threads
 double nlg_ssm::ekf_filter(const unsigned int nsim, arma::cube& alpha,
-  arma::mat& weights, arma::umat& indices) {
+  arma::mat& weights, arma::umat& indices, const unsigned int n_threads) {
   arma::vec a1 = a1_fn(theta, known_params);
   arma::mat P1 = P1_fn(theta, known_params);
   
+  // the cached factorisations are only read in the parallel loops below
+  if (H_fixed) invariant_H(a1);
+  arma::mat RR0;
+  if (RR_fixed) {
+    invariant_RR(a1);
+    arma::mat R0 = R_fn(0, a1, theta, known_params, known_tv_params);
+    RR0 = R0 * R0.t();
+  }
+  const arma::uvec all_states = arma::regspace<arma::uvec>(0, m - 1);
+  
   arma::vec att1(m);
   arma::mat Ptt1(m, m);
   ekf_update_step(0, y.col(0), a1, P1, att1, Ptt1);
   
-  arma::uvec nonzero = arma::find(Ptt1.diag() > 0);
   arma::mat L = psd_chol(Ptt1);
   std::normal_distribution<> normal(0.0, 1.0);
   for (unsigned int i = 0; i < nsim; i++) {
@@ -1256,9 +1609,11 @@ double nlg_ssm::ekf_filter(const unsigned int nsim, arma::cube& alpha,
   arma::uvec na_y = arma::find_nonfinite(y.col(0));
   if (na_y.n_elem < p) { 
     weights.col(0) = log_obs_density(0, alpha);
+    dmvnorm_factor prior(P1, false, all_states);
+    dmvnorm_factor proposal(L, true, all_states);
     for (unsigned int i = 0; i < nsim; i++) {
-      weights(i, 0) +=  dmvnorm(alpha.slice(i).col(0), a1, P1, false, true) -
-        dmvnorm(alpha.slice(i).col(0), att1, L, true, true);
+      weights(i, 0) += prior.logpdf(alpha.slice(i).col(0), a1) -
+        proposal.logpdf(alpha.slice(i).col(0), att1);
     }
     
     
@@ -1276,6 +1631,17 @@ double nlg_ssm::ekf_filter(const unsigned int nsim, arma::cube& alpha,
     weights.col(0).ones();
     normalized_weights.fill(1.0 / nsim);
   }
+  
+  // workspace of the proposals: resampled particles, means T(alpha_t) of 
+  // the transition, EKF updated means and Cholesky factors of covariances
+  arma::mat alphatmp(m, nsim);
+  arma::mat at(m, nsim);
+  arma::mat att(m, nsim);
+  arma::cube Ptt(m, m, nsim);
+  // factorisations of the transition covariances when they vary
+  std::vector<dmvnorm_factor> RR_factors(RR_fixed ? 0 : nsim);
+  arma::uvec failed(nsim);
+  
   for (unsigned int t = 0; t < n; t++) {
     
     arma::vec r(nsim);
@@ -1284,25 +1650,47 @@ double nlg_ssm::ekf_filter(const unsigned int nsim, arma::cube& alpha,
     }
     
     indices.col(t) = stratified_sample(normalized_weights, r, nsim);
-    
-    arma::mat att(m, nsim);
-    arma::cube Ptt(m, m, nsim);
-    arma::mat alphatmp(m, nsim);
     for (unsigned int i = 0; i < nsim; i++) {
       alphatmp.col(i) = alpha.slice(indices(i, t)).col(t);
-      arma::mat Rt = R_fn(t,  alphatmp.col(i), theta, known_params, known_tv_params);
-      arma::mat Pt = Rt * Rt.t();
-      arma::vec at = T_fn(t, alphatmp.col(i), theta, known_params, known_tv_params);
-      arma::vec tmp(m);
-      if (t < (n - 1)) {
-        ekf_update_step(t + 1, y.col(t + 1), at, Pt, tmp, Ptt.slice(i));
-        att.col(i) = tmp;
-        Ptt.slice(i) = psd_chol(Ptt.slice(i));
-      } else {
-        att.col(i) = at;
-        Ptt.slice(i) = Pt;  
+    }
+    
+    bool weighted = t < (n - 1) && 
+      arma::uvec(arma::find_nonfinite(y.col(t + 1))).n_elem < p;
+    
+    failed.zeros();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads) if(n_threads > 1)
+#endif
+    for (unsigned int i = 0; i < nsim; i++) {
+      try {
+        at.col(i) = T_fn(t, alphatmp.col(i), theta, known_params, known_tv_params);
+        arma::mat Pt;
+        if (RR_fixed) {
+          Pt = RR0;
+        } else {
+          arma::mat Rt = R_fn(t, alphatmp.col(i), theta, known_params, known_tv_params);
+          Pt = Rt * Rt.t();
+          if (weighted) {
+            RR_factors[i] = dmvnorm_factor(Pt, false, all_states);
+          }
+        }
+        if (t < (n - 1)) {
+          arma::vec atti(m);
+          arma::mat Ptti(m, m);
+          ekf_update_step(t + 1, y.col(t + 1), at.col(i), Pt, atti, Ptti);
+          att.col(i) = atti;
+          Ptt.slice(i) = psd_chol(Ptti);
+        } else {
+          att.col(i) = at.col(i);
+          Ptt.slice(i) = psd_chol(Pt);
+        }
+      } catch (const std::exception& e) {
+        failed(i) = 1;
       }
     }
+    if (arma::any(failed)) {
+      stop_error("Computation of the EKF proposal failed.");
+    }
     
     for (unsigned int i = 0; i < nsim; i++) {
       arma::vec um(m);
@@ -1311,14 +1699,24 @@ double nlg_ssm::ekf_filter(const unsigned int nsim, arma::cube& alpha,
       }
       alpha.slice(i).col(t + 1) = att.col(i) + Ptt.slice(i) * um;
     } 
-    if (t < (n - 1) && arma::uvec(arma::find_nonfinite(y.col(t + 1))).n_elem < p) {
-      weights.col(t + 1) = log_obs_density(t + 1, alpha);
+    if (weighted) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads) if(n_threads > 1)
+#endif
       for (unsigned int i = 0; i < nsim; i++) {
-        arma::mat Rt = R_fn(t,  alphatmp.col(i), theta, known_params, known_tv_params);
-        arma::mat RR = Rt * Rt.t();
-        arma::vec mean = T_fn(t, alphatmp.col(i), theta, known_params, known_tv_params);
-        weights(i, t + 1) +=  dmvnorm(alpha.slice(i).col(t + 1), mean, RR, false, true) -
-          dmvnorm(alpha.slice(i).col(t + 1), att.col(i), Ptt.slice(i), true, true);
+        try {
+          arma::vec x = alpha.slice(i).col(t + 1);
+          double log_transition = RR_fixed ? 
+            invariant_RR(alphatmp.col(i)).logpdf(x, at.col(i)) : 
+            RR_factors[i].logpdf(x, at.col(i));
+          weights(i, t + 1) = log_obs_density(t + 1, x) + log_transition - 
+            chol_logpdf(x, att.col(i), Ptt.slice(i));
+        } catch (const std::exception& e) {
+          failed(i) = 1;
+        }
+      }
+      if (arma::any(failed)) {
+        stop_error("Computation of the particle weights failed.");
       }
       double max_weight = weights.col(t + 1).max();
       weights.col(t + 1) = arma::exp(weights.col(t + 1) - max_weight);
@@ -1344,21 +1742,24 @@ void nlg_ssm::ekf_update_step(const unsigned int t, const arma::vec y,
   arma::uvec na_y = arma::find_nonfinite(y);
   
   if (na_y.n_elem < p) {
-    arma::mat Zg = Z_gn(t, at, theta, known_params, known_tv_params);
+    arma::mat Zg;
+    arma::vec Zt = Z_linear(t, at, Zg);
     Zg.rows(na_y).zeros();
     arma::mat HHt = H_fn(t, at, theta, known_params, known_tv_params);
     HHt = HHt * HHt.t();
     HHt.submat(na_y, na_y) = arma::eye(na_y.n_elem, na_y.n_elem);
     
-    arma::mat Ft = Zg * Pt * Zg.t() + HHt;
+    arma::mat ZP = Zg * Pt;
+    arma::mat Ft = ZP * Zg.t() + HHt;
     
     arma::mat cholF = arma::chol(Ft);
     
-    arma::vec vt = y - Z_fn(t, at, theta, known_params, known_tv_params);
+    arma::vec vt = y - Zt;
     vt.rows(na_y).zeros();
     
-    arma::mat inv_cholF = arma::inv(arma::trimatu(cholF));
-    arma::mat Kt = Pt * Zg.t() * inv_cholF * inv_cholF.t();
+    // K = P Z' F^-1 with F = U'U, using triangular solves instead of inverse
+    arma::mat Kt = arma::solve(arma::trimatu(cholF), 
+      arma::solve(arma::trimatl(cholF.t()), ZP)).t();
     att = at + Kt * vt;
     //Ptt = Pt - Kt * Ft * Kt.t();
     // Switched to numerically better form
@@ -1374,25 +1775,69 @@ double nlg_ssm::log_signal_pdf(const arma::mat& alpha) const {
   
   double ll = dmvnorm(alpha.col(0), a1_fn(theta, known_params), 
     P1_fn(theta, known_params), false, true);
-  arma::uvec na_y = arma::find_nonfinite(y.col(0));
-  if (na_y.n_elem < p) { 
-    ll += dmvnorm(y.col(0), Z_fn(0, alpha.col(0), theta, known_params, known_tv_params), 
-      H_fn(0, alpha.col(0), theta, known_params, known_tv_params), true, true);
-  }
+  ll += log_obs_density(0, alpha.col(0));
   
   for (unsigned int t = 0; t < (n - 1); t++) {
-    
-    arma::vec mean = T_fn(t, alpha.col(t), theta, known_params, known_tv_params);
-    arma::mat cov = R_fn(t, alpha.col(t), theta, known_params, known_tv_params);
-    cov = cov * cov.t();
-    ll += dmvnorm(alpha.col(t+1), mean, cov, false, true);
-    arma::uvec na_y = arma::find_nonfinite(y.col(t + 1));
-    if (na_y.n_elem < p) {
-      ll += dmvnorm(y.col(t + 1), Z_fn(t + 1, alpha.col(t + 1), theta, known_params, known_tv_params), 
-        H_fn(t + 1, alpha.col(t + 1), theta, known_params, known_tv_params), true, true);
-    }
+    ll += log_state_density(t, alpha.col(t), alpha.col(t + 1));
+    ll += log_obs_density(t + 1, alpha.col(t + 1));
   }
   return ll;
   
 }
 
+double nlg_ssm::log_signal_pdf(const arma::mat& alpha, arma::mat& Z_values, 
+  arma::mat& T_values, arma::cube& H, arma::cube& R, 
+  const unsigned int n_threads) const {
+  
+  // the cached factorisations are shared by the threads, 
+  // so they are updated before the parallel region
+  const dmvnorm_factor* H_inv = H_fixed ? &invariant_H(alpha.col(0)) : nullptr;
+  const dmvnorm_factor* RR_inv = RR_fixed ? &invariant_RR(alpha.col(0)) : nullptr;
+  // time-invariant H and R are stored at the first state as in approximate, 
+  // but the densities use their values at alpha_t if they depend on the states
+  if (Htv == 0) {
+    H.slice(0) = H_fn(0, alpha.col(0), theta, known_params, known_tv_params);
+  }
+  if (Rtv == 0) {
+    R.slice(0) = R_fn(0, alpha.col(0), theta, known_params, known_tv_params);
+  }
+  
+  // the terms are summed afterwards so that the result does not 
+  // depend on the number of threads
+  arma::vec ll_t(n, arma::fill::zeros);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads) if(n_threads > 1)
+#endif
+  for (unsigned int t = 0; t < n; t++) {
+    Z_values.col(t) = Z_fn(t, alpha.col(t), theta, known_params, known_tv_params);
+    T_values.col(t) = T_fn(t, alpha.col(t), theta, known_params, known_tv_params);
+    if (Htv == 1) {
+      H.slice(t) = H_fn(t, alpha.col(t), theta, known_params, known_tv_params);
+    }
+    if (Rtv == 1) {
+      R.slice(t) = R_fn(t, alpha.col(t), theta, known_params, known_tv_params);
+    }
+    arma::uvec na_y = arma::find_nonfinite(y.col(t));
+    if (na_y.n_elem == 0 && H_fixed) {
+      ll_t(t) = H_inv->logpdf(y.col(t), Z_values.col(t));
+    } else if (na_y.n_elem < p) {
+      ll_t(t) = dmvnorm(y.col(t), Z_values.col(t), (Htv == 1 || H_fixed) ? 
+        arma::mat(H.slice(t * Htv)) : 
+        H_fn(t, alpha.col(t), theta, known_params, known_tv_params), true, true);
+    }
+    if (t < (n - 1)) {
+      if (RR_fixed) {
+        ll_t(t) += RR_inv->logpdf(alpha.col(t + 1), T_values.col(t));
+      } else {
+        arma::mat Rt = Rtv == 1 ? arma::mat(R.slice(t)) : 
+          R_fn(t, alpha.col(t), theta, known_params, known_tv_params);
+        ll_t(t) += dmvnorm(alpha.col(t + 1), T_values.col(t), 
+          Rt * Rt.t(), false, true);
+      }
+    }
+  }
+  
+  return dmvnorm(alpha.col(0), a1_fn(theta, known_params), 
+    P1_fn(theta, known_params), false, true) + arma::accu(ll_t);
+}
+
@@ -6,6 +6,7 @@
 #include <sitmo.h>
 #include "bssm.h"
 #include "mgg_ssm.h"
+#include "dmvnorm.h"
 
 
 // typedef for a pointer of nonlinear function of model equation returning vec (T, Z)
@@ -33,24 +34,26 @@ public:
     const arma::mat& known_tv_params, const unsigned int m, const unsigned int k,
     const arma::uvec& time_varying, const unsigned int seed);
   
-  // find the approximating Gaussian model
+  // find the approximating Gaussian model, the model functions are 
+  // evaluated in parallel over time points using n_threads
   mgg_ssm approximate(arma::mat& mode_estimate, 
     const unsigned int max_iter, const double conv_tol, 
-    const unsigned int iekf_iter) const;
+    const unsigned int iekf_iter, const unsigned int n_threads = 1) const;
   // update the approximating Gaussian model
   arma::mat approximate(mgg_ssm& approx_model, const unsigned int max_iter, 
-    const double conv_tol) const;
+    const double conv_tol, const unsigned int n_threads = 1) const;
   
-  Rcpp::List predict_interval(const arma::vec& probs, const arma::mat& thetasim,
+  // as in ugg_ssm, using the extended Kalman filter
+  void predict_interval(const arma::vec& probs, const arma::mat& thetasim,
     const arma::mat& alpha_last, const arma::cube& P_last, 
-    const arma::uvec& counts, const unsigned int predict_type);
-  
-  arma::cube predict_sample(const arma::mat& thetasim, const arma::mat& alpha, 
     const arma::uvec& counts, const unsigned int predict_type, 
-    const unsigned int nsim);
+    arma::cube& intv, arma::cube& mean_pred, arma::cube& sd_pred,
+    const unsigned int n_threads = 1);
   
+  // simulate future paths of the states or observations from the model
   arma::cube sample_model(const arma::vec& a1_sim, 
-    const unsigned int predict_type, const unsigned int nsim);
+    const unsigned int predict_type, const unsigned int nsim, 
+    sitmo::prng_engine& draw_engine) const;
   
   double ekf(arma::mat& at, arma::mat& att, arma::cube& Pt, 
     arma::cube& Ptt, const unsigned int iekf_iter) const;
@@ -60,21 +63,45 @@ public:
   double ekf_smoother(arma::mat& att, arma::cube& Ptt, const unsigned int iekf_iter) const;
   double ekf_fast_smoother(arma::mat& at, const unsigned int iekf_iter) const;
   
+  // square-root unscented Kalman filter, the sigma points are evaluated 
+  // in parallel using n_threads
   double ukf(arma::mat& at, arma::mat& att, arma::cube& Pt, arma::cube& Ptt, 
-    const double alpha = 1.0, const double beta = 0.0, const double kappa = 2.0) const;
+    const double alpha = 1.0, const double beta = 0.0, const double kappa = 2.0,
+    const unsigned int n_threads = 1) const;
+  double ukf_loglik(const double alpha = 1.0, const double beta = 0.0, 
+    const double kappa = 2.0, const unsigned int n_threads = 1) const;
+  
+  // ensemble Kalman filter with n_ens members, using either perturbed 
+  // observations or the deterministic square-root (ETKF) analysis step. 
+  // If alpha has n slices, the filtered ensembles (m x n_ens) are stored 
+  // there, or the ensembles of the ensemble Kalman smoother if smooth is true.
+  // The smoother updates the ensembles of the previous lag time points at 
+  // each analysis step, so the full smoother (lag >= n) costs O(n^2)
+  double enkf(const unsigned int n_ens, const bool square_root, 
+    sitmo::prng_engine& eng, arma::cube& alpha, const bool smooth = false, 
+    const unsigned int n_threads = 1, 
+    const unsigned int lag = std::numeric_limits<unsigned int>::max()) const;
+  // EnKF log-likelihood with the random numbers fixed by seed, 
+  // so that it is a deterministic function of theta
+  double enkf_loglik(const unsigned int n_ens, const bool square_root, 
+    const unsigned int n_threads = 1) const;
   
     // bootstrap filter  
   double bsf_filter(const unsigned int nsim, arma::cube& alpha, 
     arma::mat& weights, arma::umat& indices);
+  // bootstrap filter continuing from the particles alpha of a previous call, 
+  // the functions of the model are evaluated at times t_offset, t_offset + 1, ...
+  double bsf_update(const unsigned int nsim, arma::mat& alpha, 
+    const unsigned int t_offset = 0);
   
   // psi-particle filter
   double psi_filter(const mgg_ssm& approx_model, const double approx_loglik,
     const unsigned int nsim, arma::cube& alpha, arma::mat& weights,
     arma::umat& indices);
   
-  // extended Kalman particle filter
+  // extended Kalman particle filter, proposals are computed using n_threads
   double ekf_filter(const unsigned int nsim, arma::cube& alpha,
-    arma::mat& weights, arma::umat& indices);
+    arma::mat& weights, arma::umat& indices, const unsigned int n_threads = 1);
   
   // compute logarithms of _unnormalized_ importance weights g(y_t | alpha_t) / ~g(~y_t | alpha_t)
   arma::vec log_weights(const mgg_ssm& approx_model, 
@@ -86,14 +113,27 @@ public:
   
   // compute logarithms of _unnormalized_ densities g(y_t | alpha_t)
   arma::vec log_obs_density(const unsigned int t, const arma::cube& alpha) const;
-  // compute logarithms of _unnormalized_ densities g(y_t | alpha_t)
-  double log_obs_density(const unsigned int t, const arma::vec& alpha) const;
+  // compute logarithms of _unnormalized_ densities g(y_t | alpha_t), 
+  // with the functions of the model evaluated at time t + t_offset
+  double log_obs_density(const unsigned int t, const arma::vec& alpha, 
+    const unsigned int t_offset = 0) const;
+  // log-density of alpha_t+1 given alpha_t
+  double log_state_density(const unsigned int t, const arma::vec& alpha, 
+    const arma::vec& alpha_next) const;
   
   void ekf_update_step(const unsigned int t, const arma::vec y, 
     const arma::vec& at, const arma::mat& Pt, arma::vec& att, arma::mat& Ptt) const;
     
   double log_signal_pdf(const arma::mat& alpha) const;
   
+  // values of Z_fn (T_fn) at alpha together with the Jacobian Zg (Tg), from 
+  // Z_gn (T_gn) or, if missing, forward differences which reuse the value
+  arma::vec Z_linear(const unsigned int t, const arma::vec& alpha, arma::mat& Zg) const;
+  arma::vec T_linear(const unsigned int t, const arma::vec& alpha, arma::mat& Tg) const;
+  // Jacobians of Z_fn and T_fn at alpha
+  arma::mat Z_jacobian(const unsigned int t, const arma::vec& alpha) const;
+  arma::mat T_jacobian(const unsigned int t, const arma::vec& alpha) const;
+  
   arma::mat y;
   // nonlinear functions of 
   // y_t = Z(alpha_t, theta,t) + H(theta,t)*eps_t, 
@@ -103,7 +143,7 @@ public:
   nmat_fnPtr H_fn;
   nvec_fnPtr T_fn;
   nmat_fnPtr R_fn;
-  //and the derivatives
+  //and the derivatives, null pointers if they are to be computed numerically
   nmat_fnPtr Z_gn;
   nmat_fnPtr T_gn;
   //initial value
@@ -128,11 +168,36 @@ public:
   const unsigned int Tgtv;
   const unsigned int Htv;
   const unsigned int Rtv;
+  // do H and R depend on the states, the optional fifth and sixth elements 
+  // of time_varying, which default to state dependent
+  const unsigned int Hsv;
+  const unsigned int Rsv;
   
   unsigned int seed;
   sitmo::prng_engine engine;
   const double zero_tol;
-  
+  // number of iterations used in the latest call of approximate
+  mutable unsigned int approx_iter;
+  
+private:
+  // H and R depend only on theta
+  const bool H_fixed;
+  const bool RR_fixed;
+  // factorisations of H and R R' when these depend only on theta 
+  // (H_fixed, RR_fixed), computed at alpha when theta has changed
+  const dmvnorm_factor& invariant_H(const arma::vec& alpha) const;
+  const dmvnorm_factor& invariant_RR(const arma::vec& alpha) const;
+  // log_signal_pdf which also stores the values of Z_fn and T_fn and the 
+  // matrices H and R evaluated at alpha, so that approximate can reuse them 
+  // in the linearisation at alpha
+  double log_signal_pdf(const arma::mat& alpha, arma::mat& Z_values, 
+    arma::mat& T_values, arma::cube& H, arma::cube& R, 
+    const unsigned int n_threads = 1) const;
+  // the cached factorisations and the values of theta they correspond to
+  mutable dmvnorm_factor H_factor;
+  mutable dmvnorm_factor RR_factor;
+  mutable arma::vec H_factor_theta;
+  mutable arma::vec RR_factor_theta;
 };
 
 
@@ -0,0 +1,98 @@
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "predict_sample.h"
+#include "ugg_ssm.h"
+#include "ugg_bsm.h"
+#include "ugg_ar1.h"
+#include "ung_ssm.h"
+#include "ung_bsm.h"
+#include "ung_svm.h"
+#include "ung_ar1.h"
+#include "nlg_ssm.h"
+
+namespace {
+
+// plug in the parameters of the current posterior sample
+template <class T>
+void set_parameters(T& model, const arma::vec& theta) {
+  model.update_model(theta);
+}
+void set_parameters(nlg_ssm& model, const arma::vec& theta) {
+  model.theta = theta;
+}
+
+// number of rows of the predictions
+template <class T>
+unsigned int predict_dim(const T& model, const unsigned int predict_type) {
+  return (predict_type == 3) ? model.m : 1;
+}
+unsigned int predict_dim(const nlg_ssm& model, const unsigned int predict_type) {
+  return (predict_type == 3) ? model.m : model.p;
+}
+
+}
+
+template arma::cube predict_sample(ugg_ssm model, const arma::mat& theta, 
+  const arma::mat& alpha, const arma::uvec& counts, 
+  const unsigned int predict_type, const unsigned int nsim, 
+  const unsigned int n_threads);
+template arma::cube predict_sample(ugg_bsm model, const arma::mat& theta, 
+  const arma::mat& alpha, const arma::uvec& counts, 
+  const unsigned int predict_type, const unsigned int nsim, 
+  const unsigned int n_threads);
+template arma::cube predict_sample(ugg_ar1 model, const arma::mat& theta, 
+  const arma::mat& alpha, const arma::uvec& counts, 
+  const unsigned int predict_type, const unsigned int nsim, 
+  const unsigned int n_threads);
+template arma::cube predict_sample(ung_ssm model, const arma::mat& theta, 
+  const arma::mat& alpha, const arma::uvec& counts, 
+  const unsigned int predict_type, const unsigned int nsim, 
+  const unsigned int n_threads);
+template arma::cube predict_sample(ung_bsm model, const arma::mat& theta, 
+  const arma::mat& alpha, const arma::uvec& counts, 
+  const unsigned int predict_type, const unsigned int nsim, 
+  const unsigned int n_threads);
+template arma::cube predict_sample(ung_svm model, const arma::mat& theta, 
+  const arma::mat& alpha, const arma::uvec& counts, 
+  const unsigned int predict_type, const unsigned int nsim, 
+  const unsigned int n_threads);
+template arma::cube predict_sample(ung_ar1 model, const arma::mat& theta, 
+  const arma::mat& alpha, const arma::uvec& counts, 
+  const unsigned int predict_type, const unsigned int nsim, 
+  const unsigned int n_threads);
+template arma::cube predict_sample(nlg_ssm model, const arma::mat& theta, 
+  const arma::mat& alpha, const arma::uvec& counts, 
+  const unsigned int predict_type, const unsigned int nsim, 
+  const unsigned int n_threads);
+
+template <class T>
+arma::cube predict_sample(T model, const arma::mat& theta, const arma::mat& alpha, 
+  const arma::uvec& counts, const unsigned int predict_type, 
+  const unsigned int nsim, const unsigned int n_threads) {
+  
+  // index of the first copy of each posterior sample in the output, 
+  // so that the samples do not need to be expanded
+  arma::uvec offsets = arma::cumsum(counts) - counts;
+  unsigned int n_samples = arma::accu(counts);
+  arma::cube sample(predict_dim(model, predict_type), model.n, nsim * n_samples);
+  
+  // each copy uses its own RNG stream keyed by the common seed and the 
+  // index of the copy, so the samples do not depend on the number of threads
+  std::uniform_int_distribution<> unif(0, std::numeric_limits<int>::max());
+  const unsigned int base_seed = unif(model.engine);
+  
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads) if(n_threads > 1) firstprivate(model)
+#endif
+  for (unsigned int j = 0; j < counts.n_elem; j++) {
+    set_parameters(model, theta.col(j));
+    for (unsigned int c = 0; c < counts(j); c++) {
+      unsigned int i = offsets(j) + c;
+      sitmo::prng_engine draw_engine(base_seed + i);
+      sample.slices(i * nsim, (i + 1) * nsim - 1) = 
+        model.sample_model(alpha.col(j), predict_type, nsim, draw_engine);
+    }
+  }
+  return sample;
+}
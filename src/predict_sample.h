@@ -0,0 +1,14 @@
+#ifndef PREDICT_SAMPLE_H
+#define PREDICT_SAMPLE_H
+
+#include "bssm.h"
+
+// sample from the posterior predictive distribution given the posterior 
+// samples of theta and the states at the first time point of the model, 
+// with counts(j) copies of the jth sample and nsim simulations per copy
+template <class T>
+arma::cube predict_sample(T model, const arma::mat& theta, const arma::mat& alpha, 
+  const arma::uvec& counts, const unsigned int predict_type, 
+  const unsigned int nsim, const unsigned int n_threads);
+
+#endif
@@ -0,0 +1,68 @@
+#include "profiler.h"
+
+mcmc_profiler::mcmc_profiler(const bool enabled) : enabled(enabled), 
+  time(arma::vec(5, arma::fill::zeros)), calls(arma::uvec(5, arma::fill::zeros)),
+  n_approx(0), approx_iter(0), n_ess(0), sum_ess(0.0), n_resampling(0.0), 
+  n_rejected(0) {
+}
+
+void mcmc_profiler::stop(const phase_type phase) {
+  
+  if (enabled) {
+    time(phase) += std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start_time).count();
+    calls(phase)++;
+  }
+}
+
+void mcmc_profiler::add_approx_iter(const unsigned int iter) {
+  
+  if (enabled) {
+    n_approx++;
+    approx_iter += iter;
+  }
+}
+
+void mcmc_profiler::add_filter(const arma::mat& weights) {
+  
+  if (enabled) {
+    // weights are not necessarily normalized, ESS = (sum w)^2 / sum w^2
+    for (unsigned int t = 0; t < weights.n_cols; t++) {
+      double sum_w = arma::accu(weights.col(t));
+      // the filters stop at the first time point where all weights are zero, 
+      // leaving the remaining columns unfilled
+      if (!(sum_w > 0 && std::isfinite(sum_w))) break;
+      // the filters resample after weighting at each of the time points 
+      // 0, ..., n - 1, also when the observation is missing
+      if (t + 1 < weights.n_cols) n_resampling++;
+      // time points with missing observations have unit weights
+      if (arma::all(weights.col(t) == 1.0)) continue;
+      sum_ess += sum_w * sum_w / arma::accu(arma::square(weights.col(t)));
+      n_ess++;
+    }
+  }
+}
+
+#ifndef BSSM_STANDALONE
+Rcpp::List mcmc_profiler::append(Rcpp::List out) const {
+  
+  if (!enabled) return out;
+  
+  Rcpp::CharacterVector phases = Rcpp::CharacterVector::create("approximation", 
+    "filtering", "smoothing", "storage", "is_correction");
+  Rcpp::NumericVector time_(time.begin(), time.end());
+  time_.names() = phases;
+  Rcpp::IntegerVector calls_(calls.begin(), calls.end());
+  calls_.names() = phases;
+  
+  out.push_back(Rcpp::List::create(
+    Rcpp::Named("time") = time_,
+    Rcpp::Named("calls") = calls_,
+    Rcpp::Named("approx_iter") = n_approx > 0 ? 
+      static_cast<double>(approx_iter) / n_approx : NA_REAL,
+    Rcpp::Named("mean_ess") = n_ess > 0 ? sum_ess / n_ess : NA_REAL,
+    Rcpp::Named("n_resampling") = n_resampling,
+    Rcpp::Named("n_rejected_inf") = n_rejected), "profile");
+  return out;
+}
+#endif
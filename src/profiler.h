@@ -0,0 +1,58 @@
+// optional timing and counters for the hot paths of the MCMC algorithms
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include "bssm.h"
+
+class mcmc_profiler {
+  
+public:
+  
+  enum phase_type {
+    approximation = 0, filtering, smoothing, storage, is_correction
+  };
+  
+  mcmc_profiler(const bool enabled = false);
+  
+  // start the timer
+  void start() {
+    if (enabled) start_time = std::chrono::steady_clock::now();
+  }
+  // stop the timer and add the elapsed time to the given phase
+  void stop(const phase_type phase);
+  
+  // number of iterations used in the Gaussian approximation
+  void add_approx_iter(const unsigned int iter);
+  // ESS of the particle filter weights and the number of resampling steps
+  void add_filter(const arma::mat& weights);
+  // proposal rejected due to -Inf log-prior
+  void add_rejection() {
+    if (enabled) n_rejected++;
+  }
+  // proposal rejected due to -Inf (or NaN) log-likelihood estimate
+  void add_loglik(const double loglik) {
+    if (enabled && !(loglik > -std::numeric_limits<double>::infinity())) n_rejected++;
+  }
+  
+#ifndef BSSM_STANDALONE
+  // append the summary of the counters to the output list
+  Rcpp::List append(Rcpp::List out) const;
+#endif
+  
+  bool enabled;
+  
+private:
+  std::chrono::steady_clock::time_point start_time;
+  arma::vec time;
+  arma::uvec calls;
+  unsigned int n_approx;
+  unsigned int approx_iter;
+  unsigned int n_ess;
+  double sum_ess;
+  double n_resampling;
+  unsigned int n_rejected;
+};
+
+#endif
@@ -9,6 +9,7 @@
 
 #include "filter_smoother.h"
 #include "summary.h"
+#include "hooks.h"
 
 sde_amcmc::sde_amcmc(const unsigned int n_iter, 
   const unsigned int n_burnin, const unsigned int n_thin, const unsigned int n, 
@@ -47,9 +48,9 @@ void sde_amcmc::expand() {
   posterior_storage.set_size(n_stored);
   posterior_storage = expanded_posterior;
   
-  arma::cube expanded_alpha = rep_cube(alpha_storage, count_storage);
+  // the states are simulated separately for each copy in IS correction, 
+  // so there is no need to copy the approximate ones
   alpha_storage.set_size(alpha_storage.n_rows, alpha_storage.n_cols, n_stored);
-  alpha_storage = expanded_alpha;
   
   arma::vec expanded_weight = rep_vec(weight_storage, count_storage);
   weight_storage.set_size(n_stored);
@@ -80,7 +81,7 @@ void sde_amcmc::approx_mcmc(sde_ssm model, const bool end_ram,
   // compute the log[p(theta)]
   double logprior = model.log_prior_pdf(model.theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    stop_error("Initial prior probability is not finite.");
   }
   
   arma::cube alpha(m, n + 1, nsim_states);
@@ -88,7 +89,7 @@ void sde_amcmc::approx_mcmc(sde_ssm model, const bool end_ram,
   arma::umat indices(nsim_states, n);
   double loglik = model.bsf_filter(nsim_states, L, alpha, weights, indices);
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    stop_error("Initial log-likelihood is not finite.");
   
   double acceptance_prob = 0.0;
   bool new_value = true;
@@ -99,7 +100,7 @@ void sde_amcmc::approx_mcmc(sde_ssm model, const bool end_ram,
   
   for (unsigned int i = 1; i <= n_iter; i++) {
     if (i % 4 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -117,7 +118,11 @@ void sde_amcmc::approx_mcmc(sde_ssm model, const bool end_ram,
       // update parameters
       model.theta = theta_prop;
       
+      profiler.start();
       double loglik_prop = model.bsf_filter(nsim_states, L, alpha, weights, indices);
+      profiler.stop(mcmc_profiler::filtering);
+      profiler.add_filter(weights);
+      profiler.add_loglik(loglik_prop);
       
       //compute the acceptance probability
       // use explicit min(...) as we need this value later
@@ -135,8 +140,12 @@ void sde_amcmc::approx_mcmc(sde_ssm model, const bool end_ram,
         theta = theta_prop;
         new_value = true;
       }
-    } else acceptance_prob = 0.0;
+    } else {
+      acceptance_prob = 0.0;
+      profiler.add_rejection();
+    }
     
+    profiler.start();
     if (i > n_burnin && n_values % n_thin == 0) {
       //new block
       if (new_value) {
@@ -150,6 +159,7 @@ void sde_amcmc::approx_mcmc(sde_ssm model, const bool end_ram,
         count_storage(n_stored - 1)++;
       }
     }
+    profiler.stop(mcmc_profiler::storage);
     
     if (!end_ram || i <= n_burnin) {
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
@@ -164,6 +174,7 @@ void sde_amcmc::is_correction_bsf(sde_ssm model, const unsigned int nsim_states,
   const unsigned int L_c, const unsigned int L_f, 
   const unsigned int is_type, const unsigned int n_threads) {
   
+  profiler.start();
   arma::cube Valpha(1, 1, model.n + 1, arma::fill::zeros);
   double sum_w = 0.0;
   
@@ -253,4 +264,5 @@ if (output_type == 2) {
   Vt += Valpha / theta_storage.n_cols; // Var[E(alpha)] + E[Var(alpha)]
 }
 posterior_storage = prior_storage + approx_loglik_storage + arma::log(weight_storage);
+profiler.stop(mcmc_profiler::is_correction);
 }
@@ -1,6 +1,7 @@
 #include "sde_ssm.h"
 #include "milstein_functions.h"
 #include "sample.h"
+#include "hooks.h"
 
 sde_ssm::sde_ssm(const arma::vec& y, const arma::vec& theta, 
   const double x0, bool positive, const unsigned int seed,
@@ -73,3 +74,56 @@ double sde_ssm::bsf_filter(const unsigned int nsim, const unsigned int L,
   }
   return loglik;
 }
+
+double sde_ssm::bsf_update(const unsigned int nsim, const unsigned int L, 
+  arma::vec& alpha) {
+  // the particles are written back to alpha only if the whole batch is 
+  // filtered successfully
+  arma::vec particles = alpha;
+  
+  if (particles.n_elem == 0) {
+    particles.set_size(nsim);
+    for (unsigned int i = 0; i < nsim; i++) {
+      particles(i) = milstein(x0, L, 1, theta, drift, diffusion, ddiffusion,
+        positive, coarse_engine);
+    }
+  }
+  if (particles.n_elem != nsim) {
+    stop_error("Number of particles does not match nsim.");
+  }
+  
+  std::uniform_real_distribution<> unif(0.0, 1.0);
+  arma::vec normalized_weights(nsim);
+  double loglik = 0.0;
+  
+  for (unsigned int t = 0; t < n; t++) {
+    
+    if (arma::is_finite(y(t))) {
+      arma::vec weights = log_obs_density(y(t), particles, theta);
+      double max_weight = weights.max();
+      weights = arma::exp(weights - max_weight);
+      double sum_weights = arma::accu(weights);
+      if(sum_weights > 0.0){
+        normalized_weights = weights / sum_weights;
+      } else {
+        return -std::numeric_limits<double>::infinity();
+      }
+      loglik += max_weight + std::log(sum_weights / nsim);
+    } else {
+      normalized_weights.fill(1.0 / nsim);
+    }
+    
+    arma::vec r(nsim);
+    for (unsigned int i = 0; i < nsim; i++) {
+      r(i) = unif(engine);
+    }
+    arma::uvec indices = stratified_sample(normalized_weights, r, nsim);
+    arma::vec alphatmp = particles.elem(indices);
+    for (unsigned int i = 0; i < nsim; i++) {
+      particles(i) = milstein(alphatmp(i), L, 1, theta, 
+        drift, diffusion, ddiffusion, positive, coarse_engine);
+    }
+  }
+  alpha = particles;
+  return loglik;
+}
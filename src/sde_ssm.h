@@ -23,6 +23,10 @@ public:
   // bootstrap filter  
   double bsf_filter(const unsigned int nsim, const unsigned int L, 
     arma::cube& alpha, arma::mat& weights, arma::umat& indices);
+  // bootstrap filter continuing from the particles alpha of a previous call, 
+  // if alpha is empty the particles are simulated starting from x0
+  double bsf_update(const unsigned int nsim, const unsigned int L, 
+    arma::vec& alpha);
   
   arma::vec y;
   // Parameter vector used in _all_ functions
@@ -0,0 +1,164 @@
+#include "structured_T.h"
+
+namespace {
+
+unsigned int find_root(std::vector<unsigned int>& parent, unsigned int i) {
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+// join the states i and j for which A(i, j) is non-zero
+void join_states(const arma::mat& A, std::vector<unsigned int>& parent) {
+  for (unsigned int j = 0; j < A.n_cols; j++) {
+    for (unsigned int i = 0; i < A.n_rows; i++) {
+      if (i != j && A(i, j) != 0) {
+        parent[find_root(parent, i)] = find_root(parent, j);
+      }
+    }
+  }
+}
+
+}
+
+// Sparse storage is used only when it pays off: for small m the dense
+// products are faster regardless of the number of zeros
+T_structure::T_structure(const arma::cube& T, const arma::cube& RR, 
+  const arma::mat& P1) : sparse(false) {
+
+  const unsigned int m = T.n_rows;
+  if (m >= 10) {
+    // stop at the first dense slice, usually the first one of dense T
+    sparse = true;
+    for (unsigned int t = 0; t < T.n_slices && sparse; t++) {
+      sparse = arma::accu(T.slice(t) != 0) <= 0.2 * m * m;
+    }
+  }
+  if (sparse) {
+    T_sp.reserve(T.n_slices);
+    Tt_sp.reserve(T.n_slices);
+    for (unsigned int t = 0; t < T.n_slices; t++) {
+      T_sp.push_back(arma::sp_mat(T.slice(t)));
+      Tt_sp.push_back(arma::sp_mat(T.slice(t).t()));
+    }
+  }
+
+  // independent blocks of states as connected components
+  std::vector<unsigned int> parent(m);
+  for (unsigned int i = 0; i < m; i++) {
+    parent[i] = i;
+  }
+  for (unsigned int t = 0; t < T.n_slices; t++) {
+    join_states(T.slice(t), parent);
+  }
+  for (unsigned int t = 0; t < RR.n_slices; t++) {
+    join_states(RR.slice(t), parent);
+  }
+  join_states(P1, parent);
+
+  block_id.set_size(m);
+  std::vector<unsigned int> root_id(m, m);
+  unsigned int n_blocks = 0;
+  for (unsigned int i = 0; i < m; i++) {
+    unsigned int root = find_root(parent, i);
+    if (root_id[root] == m) {
+      root_id[root] = n_blocks++;
+    }
+    block_id(i) = root_id[root];
+  }
+  for (unsigned int b = 0; b < n_blocks; b++) {
+    blocks.push_back(arma::find(block_id == b));
+  }
+  if (n_blocks > 1) {
+    T_blocks.resize(T.n_slices);
+    for (unsigned int t = 0; t < T.n_slices; t++) {
+      for (unsigned int b = 0; b < n_blocks; b++) {
+        T_blocks[t].push_back(T.slice(t).submat(blocks[b], blocks[b]));
+      }
+    }
+  }
+}
+
+structured_T::structured_T(const arma::cube& T, const T_structure& structure) :
+  T(T), Ttv(T.n_slices > 1), sparse(structure.sparse), 
+  T_sp(structure.T_sp), Tt_sp(structure.Tt_sp), blocks(structure.blocks), 
+  block_id(structure.block_id), T_blocks(structure.T_blocks) {
+}
+
+arma::mat structured_T::mult(const unsigned int t, const arma::mat& X) const {
+  if (sparse) {
+    return T_sp[t * Ttv] * X;
+  }
+  if (blocks.size() > 1) {
+    arma::mat TX(X.n_rows, X.n_cols);
+    for (unsigned int b = 0; b < blocks.size(); b++) {
+      TX.rows(blocks[b]) = T_blocks[t * Ttv][b] * X.rows(blocks[b]);
+    }
+    return TX;
+  }
+  return T.slice(t * Ttv) * X;
+}
+
+arma::mat structured_T::mult_t(const unsigned int t, const arma::mat& X) const {
+  if (sparse) {
+    return Tt_sp[t * Ttv] * X;
+  }
+  if (blocks.size() > 1) {
+    arma::mat TX(X.n_rows, X.n_cols);
+    for (unsigned int b = 0; b < blocks.size(); b++) {
+      TX.rows(blocks[b]) = T_blocks[t * Ttv][b].t() * X.rows(blocks[b]);
+    }
+    return TX;
+  }
+  return T.slice(t * Ttv).t() * X;
+}
+
+// as P is symmetric, T P T' = T (T P)'
+arma::mat structured_T::sandwich(const unsigned int t, const arma::mat& P) const {
+  arma::mat PT = mult(t, P).t();
+  return mult(t, PT);
+}
+
+arma::mat structured_T::sandwich_t(const unsigned int t, const arma::mat& P) const {
+  arma::mat PT = mult_t(t, P).t();
+  return mult_t(t, PT);
+}
+
+// T (I - K Z') = T - (T K) Z', which avoids the m x m x m product
+arma::mat structured_T::L(const unsigned int t, const arma::vec& K,
+  const arma::vec& Z) const {
+  return T.slice(t * Ttv) - mult(t, K) * Z.t();
+}
+
+arma::mat structured_T::predict(const unsigned int t, const arma::mat& P,
+  const arma::mat& RR, const bool blockdiag) const {
+
+  if (!blockdiag) {
+    return arma::symmatu(sandwich(t, P) + RR);
+  }
+  arma::mat Pnew(P.n_rows, P.n_cols, arma::fill::zeros);
+  for (unsigned int b = 0; b < blocks.size(); b++) {
+    const arma::mat& Tb = T_blocks[t * Ttv][b];
+    Pnew.submat(blocks[b], blocks[b]) =
+      Tb * P.submat(blocks[b], blocks[b]) * Tb.t() + RR.submat(blocks[b], blocks[b]);
+  }
+  return arma::symmatu(Pnew);
+}
+
+bool structured_T::block_diagonal(const arma::mat& P) const {
+  if (blocks.size() < 2) return false;
+  for (unsigned int j = 0; j < P.n_cols; j++) {
+    for (unsigned int i = 0; i < P.n_rows; i++) {
+      if (block_id(i) != block_id(j) && P(i, j) != 0) return false;
+    }
+  }
+  return true;
+}
+
+bool structured_T::within_block(const arma::vec& Z) const {
+  arma::uvec nonzero = arma::find(Z);
+  return nonzero.n_elem == 0 ||
+    arma::all(block_id.elem(nonzero) == block_id(nonzero(0)));
+}
@@ -0,0 +1,78 @@
+// transition matrices T_t of linear-Gaussian models in a form which exploits
+// their structure in the Kalman filter and smoother recursions
+
+#ifndef STRUCTURED_T_H
+#define STRUCTURED_T_H
+
+#include "bssm.h"
+
+// When most of the elements of T_t are zero (e.g. the shift structure of
+// seasonal components of BSM), the matrices are stored also in sparse form,
+// and the products cost O(nnz(T) m) instead of O(m^3).
+//
+// In addition the states are split into independent blocks, i.e. connected
+// components of the non-zero patterns of T_t, RR_t, and P1, so that these
+// matrices are block-diagonal (up to permutation). Products with dense T are
+// then computed block by block, and the prediction step of block-diagonal
+// covariance matrix only touches the diagonal blocks.
+//
+// Both are kept by the model in T_structure, which is recomputed only when 
+// T, RR, or P1 change, and structured_T is a view of T and its structure, 
+// so it must not outlive the model.
+class T_structure {
+
+public:
+
+  T_structure() : sparse(false) {}
+  T_structure(const arma::cube& T, const arma::cube& RR, const arma::mat& P1);
+
+  bool sparse;
+  std::vector<arma::sp_mat> T_sp;
+  std::vector<arma::sp_mat> Tt_sp;
+  // state indices of the blocks, block of each state, and the diagonal
+  // blocks of each T_t (only when there are multiple blocks)
+  std::vector<arma::uvec> blocks;
+  arma::uvec block_id;
+  std::vector<std::vector<arma::mat> > T_blocks;
+};
+
+class structured_T {
+
+public:
+
+  structured_T(const arma::cube& T, const T_structure& structure);
+
+  // T_t * X and T_t' * X
+  arma::mat mult(const unsigned int t, const arma::mat& X) const;
+  arma::mat mult_t(const unsigned int t, const arma::mat& X) const;
+  // T_t * P * T_t' and T_t' * P * T_t for symmetric P
+  arma::mat sandwich(const unsigned int t, const arma::mat& P) const;
+  arma::mat sandwich_t(const unsigned int t, const arma::mat& P) const;
+  // T_t * (I - K Z'), i.e. L_t of the smoothing recursions
+  arma::mat L(const unsigned int t, const arma::vec& K, const arma::vec& Z) const;
+
+  // covariance T_t * P * T_t' + RR_t of the predicted state, if blockdiag is
+  // true P is assumed to be block-diagonal and only the blocks are computed
+  arma::mat predict(const unsigned int t, const arma::mat& P,
+    const arma::mat& RR, const bool blockdiag) const;
+  // is P block-diagonal with respect to the state blocks
+  bool block_diagonal(const arma::mat& P) const;
+  // does Z load on at most one block, in which case the update step
+  // keeps the block-diagonal structure of the covariance matrix
+  bool within_block(const arma::vec& Z) const;
+
+  bool is_sparse() const { return sparse; }
+  unsigned int n_blocks() const { return blocks.size(); }
+
+private:
+  const arma::cube& T;
+  const unsigned int Ttv;
+  const bool sparse;
+  const std::vector<arma::sp_mat>& T_sp;
+  const std::vector<arma::sp_mat>& Tt_sp;
+  const std::vector<arma::uvec>& blocks;
+  const arma::uvec& block_id;
+  const std::vector<std::vector<arma::mat> >& T_blocks;
+};
+
+#endif
@@ -0,0 +1,49 @@
+#include "tempering.h"
+
+tempering::tempering(const unsigned int n_temps, const double max_temp) :
+  beta(arma::vec(n_temps)), log_max_temp(std::log(max_temp)),
+  log_spacing(arma::vec(n_temps - 1)),
+  swap_prob(arma::vec(n_temps - 1)), n_rounds(0) {
+
+  log_spacing.fill(log_max_temp / (n_temps - 1));
+  swap_prob.fill(arma::datum::nan);
+  update_beta();
+}
+
+void tempering::update_beta() {
+
+  beta(0) = 1.0;
+  for (unsigned int i = 1; i < beta.n_elem; i++) {
+    beta(i) = beta(i - 1) * std::exp(-log_spacing(i - 1));
+  }
+}
+
+arma::uvec tempering::swap(const arma::vec& loglik, sitmo::prng_engine& engine) {
+
+  std::uniform_real_distribution<> unif(0.0, 1.0);
+
+  arma::uvec accepted(log_spacing.n_elem);
+  unsigned int n_accepted = 0;
+  for (unsigned int i = n_rounds % 2; i < log_spacing.n_elem; i += 2) {
+    double log_alpha = (beta(i) - beta(i + 1)) * (loglik(i + 1) - loglik(i));
+    swap_prob(i) = std::isnan(log_alpha) ? 0.0 : std::min(1.0, std::exp(log_alpha));
+    if (unif(engine) < swap_prob(i)) {
+      accepted(n_accepted) = i;
+      n_accepted++;
+    }
+  }
+  n_rounds++;
+  return accepted.head(n_accepted);
+}
+
+void tempering::adapt(const unsigned int iter, const double gamma) {
+
+  // wait until all pairs have been proposed at least once
+  if (swap_prob.has_nan()) return;
+
+  // pairs with higher than average acceptance are moved further apart
+  double step = std::min(1.0, std::pow(iter, -gamma));
+  log_spacing %= arma::exp(step * (swap_prob - arma::mean(swap_prob)));
+  log_spacing *= log_max_temp / arma::accu(log_spacing);
+  update_beta();
+}
@@ -0,0 +1,39 @@
+// temperature ladder and swap moves of parallel tempering
+
+#ifndef TEMPERING_H
+#define TEMPERING_H
+
+#include <sitmo.h>
+#include "bssm.h"
+
+class tempering {
+
+public:
+
+  // geometric ladder from temperature 1 (the cold chain) to max_temp
+  tempering(const unsigned int n_temps, const double max_temp);
+
+  // propose swaps between adjacent replicas given their log-likelihoods,
+  // alternating between even and odd pairs on consecutive calls,
+  // returns the lower indices of the accepted pairs
+  arma::uvec swap(const arma::vec& loglik, sitmo::prng_engine& engine);
+  // adapt the spacing of the log-temperatures towards equal swap acceptance
+  // rates, keeping the first and last temperatures fixed
+  void adapt(const unsigned int iter, const double gamma);
+
+  // inverse temperatures
+  arma::vec beta;
+
+private:
+
+  const double log_max_temp;
+  // differences of the adjacent log-temperatures
+  arma::vec log_spacing;
+  // latest swap acceptance probabilities of each adjacent pair
+  arma::vec swap_prob;
+  unsigned int n_rounds;
+
+  void update_beta();
+};
+
+#endif
@@ -1,11 +1,13 @@
 #include "ugg_ar1.h"
 
+#ifndef BSSM_STANDALONE
 // from Rcpp::List
 ugg_ar1::ugg_ar1(const Rcpp::List& model, const unsigned int seed) :
   ugg_ssm(model, seed), 
   mu_est(Rcpp::as<bool>(model["mu_est"])), 
   sd_y_est(Rcpp::as<bool>(model["sd_y_est"])) {
 }
+#endif
 
 void ugg_ar1::update_model(const arma::vec& new_theta) {
   
@@ -19,6 +21,7 @@ void ugg_ar1::update_model(const arma::vec& new_theta) {
   P1(0, 0) = std::pow(new_theta(1), 2) / (1.0 - std::pow(new_theta(0), 2));
   
   compute_RR();
+  compute_T_structure();
   
   if(sd_y_est) {
     H(0) = new_theta(2 + mu_est);
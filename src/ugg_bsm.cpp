@@ -2,6 +2,7 @@
 
 #include "ugg_bsm.h"
 
+#ifndef BSSM_STANDALONE
 // Construct bsm model from Rcpp::List
 ugg_bsm::ugg_bsm(const Rcpp::List& model, const unsigned int seed) :
   ugg_ssm(model, seed),
@@ -14,6 +15,7 @@ ugg_bsm::ugg_bsm(const Rcpp::List& model, const unsigned int seed) :
   seasonal_est(seasonal && fixed(3) == 0) {
   
 }
+#endif
 
 // update the model given theta
 // standard deviation parameters sigma are sampled in a transformed space
@@ -38,6 +40,7 @@ void ugg_bsm::update_model(const arma::vec& new_theta) {
       R(1 + slope, 1 + slope, 0) =
         std::exp(new_theta(y_est + level_est + slope_est));
     }
+    // RR stays diagonal, so the structure of T does not change
     compute_RR();
   }
   if(xreg.n_cols > 0) {
@@ -1,11 +1,12 @@
 #include "ugg_ssm.h"
 #include "interval.h"
-#include "rep_mat.h"
 #include "sample.h"
 #include "distr_consts.h"
 #include "conditional_dist.h"
 #include "psd_chol.h"
+#include "hooks.h"
 
+#ifndef BSSM_STANDALONE
 // General constructor of ugg_ssm object from Rcpp::List
 // with parameter indices
 ugg_ssm::ugg_ssm(const Rcpp::List& model,
@@ -33,7 +34,9 @@ ugg_ssm::ugg_ssm(const Rcpp::List& model,
   }
   compute_HH();
   compute_RR();
+  compute_T_structure();
 }
+#endif
 
 // General constructor of ugg_ssm object
 // with parameter indices
@@ -61,6 +64,7 @@ ugg_ssm::ugg_ssm(const arma::vec& y, const arma::mat& Z, const arma::vec& H,
   }
   compute_HH();
   compute_RR();
+  compute_T_structure();
 }
 
 void ugg_ssm::update_model(const arma::vec& new_theta) {
@@ -85,6 +89,9 @@ void ugg_ssm::update_model(const arma::vec& new_theta) {
   if (R_ind.n_elem  > 0) {
     compute_RR();
   }
+  if (T_ind.n_elem > 0 || R_ind.n_elem > 0) {
+    compute_T_structure();
+  }
   if(xreg.n_cols > 0) {
     beta = new_theta.subvec(new_theta.n_elem - xreg.n_cols, new_theta.n_elem - 1);
     compute_xbeta();
@@ -128,11 +135,32 @@ void ugg_ssm::compute_RR(){
   }
 }
 
+// covariance (I - K Z') P (I - K Z')' + K HH K' of the updated state, 
+// computed with rank-one updates in O(m^2) instead of dense matrix products
+static arma::mat joseph_update(const arma::mat& P, const arma::vec& K, 
+  const arma::vec& Z, const double HH) {
+  arma::mat A = P - K * (P * Z).t();
+  return A - (A * Z) * K.t() + HH * K * K.t();
+}
+
+// (I - Z K') N (I - K Z') for symmetric N, used with N = T' N T in the 
+// backward recursion N_t-1 = L_t' N_t L_t
+static arma::mat L_sandwich(const arma::mat& N, const arma::vec& K, 
+  const arma::vec& Z) {
+  arma::mat B = N - Z * (N * K).t();
+  return B - (B * K) * Z.t();
+}
+
 double ugg_ssm::log_likelihood() const {
   
-  double logLik = 0;
   arma::vec at = a1;
   arma::mat Pt = P1;
+  return log_likelihood(at, Pt);
+}
+
+double ugg_ssm::log_likelihood(arma::vec& at, arma::mat& Pt) const {
+  
+  double logLik = 0;
   
   arma::vec y_tmp = y;
   if(xreg.n_cols > 0) {
@@ -140,18 +168,21 @@ double ugg_ssm::log_likelihood() const {
   }
   
   const double LOG2PI = std::log(2.0 * M_PI);
+  const structured_T Ts(T, T_struct);
+  bool blockdiag = Ts.block_diagonal(Pt);
   
   for (unsigned int t = 0; t < n; t++) {
     double F = arma::as_scalar(Z.col(t * Ztv).t() * Pt * Z.col(t * Ztv) + HH(t * Htv));
     if (arma::is_finite(y_tmp(t)) && F > zero_tol) {
       double v = arma::as_scalar(y_tmp(t) - D(t * Dtv) - Z.col(t * Ztv).t() * at);
       arma::vec K = Pt * Z.col(t * Ztv) / F;
-      at = C.col(t * Ctv) + T.slice(t * Ttv) * (at + K * v);
-      Pt = arma::symmatu(T.slice(t * Ttv) * (Pt - K * K.t() * F) * T.slice(t * Ttv).t() + RR.slice(t * Rtv));
+      at = C.col(t * Ctv) + Ts.mult(t, at + K * v);
+      blockdiag = blockdiag && Ts.within_block(Z.col(t * Ztv));
+      Pt = Ts.predict(t, Pt - K * K.t() * F, RR.slice(t * Rtv), blockdiag);
       logLik -= 0.5 * (LOG2PI + std::log(F) + v * v/F);
     } else {
-      at = C.col(t * Ctv) + T.slice(t * Ttv) * at;
-      Pt = arma::symmatu(T.slice(t * Ttv) * Pt * T.slice(t * Ttv).t() + RR.slice(t * Rtv));
+      at = C.col(t * Ctv) + Ts.mult(t, at);
+      Pt = Ts.predict(t, Pt, RR.slice(t * Rtv), blockdiag);
     }
   }
   
@@ -159,15 +190,8 @@ double ugg_ssm::log_likelihood() const {
 }
 
 
-arma::cube ugg_ssm::simulate_states(const unsigned int nsim, const bool use_antithetic) {
-  
-  arma::vec y_tmp = y;
-  
-  arma::mat L_P1 = psd_chol(P1);
-  
-  arma::cube asim(m, n + 1, nsim);
-  
-  std::normal_distribution<> normal(0.0, 1.0);
+arma::cube ugg_ssm::simulate_states(const unsigned int nsim, const bool use_antithetic,
+  const unsigned int n_threads, const unsigned int block_size) {
   
   if (nsim > 1) {
     arma::vec Ft(n);
@@ -175,96 +199,145 @@ arma::cube ugg_ssm::simulate_states(const unsigned int nsim, const bool use_anti
     arma::cube Lt(m, m, n);
     
     arma::mat alphahat = fast_precomputing_smoother(Ft, Kt, Lt);
-    
-    
-    unsigned int nsim2;
-    if(use_antithetic) {
-      nsim2 = std::floor(nsim / 2.0);
-    } else {
-      nsim2 = nsim;
+    return simulate_states(nsim, use_antithetic, alphahat, Ft, Kt, Lt, n_threads,
+      block_size);
+  }
+  
+  arma::mat L_P1 = psd_chol(P1);
+  arma::cube asim(m, n + 1, 1);
+  
+  arma::vec y_tmp = y;
+  std::normal_distribution<> normal(0.0, 1.0);
+  // for _single simulation_ this version is faster:
+  //  xbeta, C, D, and a1 set to zero when simulating yplus and aplus
+  // (see:
+  //  Marek Jarociński 2015: "A note on implementing the Durbin and Koopman simulation
+  //  smoother")
+  
+  arma::vec um(m);
+  for(unsigned int j = 0; j < m; j++) {
+    um(j) = normal(engine);
+  }
+  asim.slice(0).col(0) = L_P1 * um;
+  for (unsigned int t = 0; t < n; t++) {
+    if (arma::is_finite(y(t))) {
+      y(t) -= arma::as_scalar(Z.col(t * Ztv).t() * asim.slice(0).col(t)) +
+        H(t * Htv) * normal(engine);
     }
-    for(unsigned int i = 0; i < nsim2; i++) {
-      arma::mat aplus(m, n + 1);
-      
-      arma::vec um(m);
-      for(unsigned int j = 0; j < m; j++) {
-        um(j) = normal(engine);
-      }
-      aplus.col(0) = a1 + L_P1 * um;
-      for (unsigned int t = 0; t < n; t++) {
-        if (arma::is_finite(y(t))) {
-          y(t) = xbeta(t) + D(t * Dtv) +
-            arma::as_scalar(Z.col(t * Ztv).t() * aplus.col(t)) +
-            H(t * Htv) * normal(engine);
-        }
-        arma::vec uk(k);
-        for(unsigned int j = 0; j < k; j++) {
-          uk(j) = normal(engine);
-        }
-        aplus.col(t + 1) = C.col(t * Ctv) + T.slice(t * Ttv) * aplus.col(t) + R.slice(t * Rtv) * uk;
-      }
-      
-      asim.slice(i) = -fast_smoother(Ft, Kt, Lt) + aplus;
-      if (use_antithetic){
-        asim.slice(i + nsim2) = alphahat - asim.slice(i);
-      }
-      asim.slice(i) += alphahat;
+    arma::vec uk(k);
+    for(unsigned int j = 0; j < k; j++) {
+      uk(j) = normal(engine);
     }
-    if ((2 * nsim2) < nsim) {
-      
-      arma::mat aplus(m, n + 1);
-      
-      arma::vec um(m);
-      for(unsigned int j = 0; j < m; j++) {
-        um(j) = normal(engine);
-      }
-      aplus.col(0) = a1 + L_P1 * um;
-      for (unsigned int t = 0; t < n; t++) {
-        if (arma::is_finite(y(t))) {
-          y(t) = xbeta(t) + D(t * Dtv) +
-            arma::as_scalar(Z.col(t * Ztv).t() * aplus.col(t)) +
-            H(t * Htv) * normal(engine);
-        }
-        arma::vec uk(k);
-        for(unsigned int j = 0; j < k; j++) {
-          uk(j) = normal(engine);
+    asim.slice(0).col(t + 1) = T.slice(t * Ttv) * asim.slice(0).col(t) +
+      R.slice(t * Rtv) * uk;
+  }
+  asim.slice(0) += fast_smoother();
+  y = y_tmp;
+  
+  return asim;
+}
+
+// simulation smoother using precomputed smoothed states alphahat and 
+// Ft, Kt, and Lt (from fast_precomputing_smoother) of the current model
+arma::cube ugg_ssm::simulate_states(const unsigned int nsim, const bool use_antithetic,
+  const arma::mat& alphahat, const arma::vec& Ft, const arma::mat& Kt, 
+  const arma::cube& Lt, const unsigned int n_threads, 
+  const unsigned int block_size) {
+  
+  if (block_size == 0) {
+    stop_error("Block size of the simulation smoother must be positive.");
+  }
+  arma::mat L_P1 = psd_chol(P1);
+  
+  arma::cube asim(m, n + 1, nsim);
+  
+  unsigned int nsim2;
+  if(use_antithetic) {
+    nsim2 = std::floor(nsim / 2.0);
+  } else {
+    nsim2 = nsim;
+  }
+  // number of independent draws, with odd nsim the last antithetic 
+  // draw is replaced by an independent one
+  unsigned int n_draws = nsim - (use_antithetic ? nsim2 : 0);
+  
+  // each draw uses its own RNG stream keyed by the common seed and the draw 
+  // index, so the draws do not depend on the number of threads used
+  std::uniform_int_distribution<> unif(0, std::numeric_limits<int>::max());
+  const unsigned int base_seed = unif(engine);
+  
+  // draws are processed in blocks so that the recursions of the smoother 
+  // are matrix-matrix products over m x block_size matrices
+  unsigned int n_blocks = std::ceil(n_draws / static_cast<double>(block_size));
+  
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads) if(n_threads > 1)
+#endif
+  for(unsigned int b = 0; b < n_blocks; b++) {
+    unsigned int first = b * block_size;
+    unsigned int nb = std::min(block_size, n_draws - first);
+    
+    arma::cube aplus(m, nb, n + 1);
+    arma::mat yplus = arma::repmat(y, 1, nb);
+    simulate_unconditional(base_seed + first, L_P1, aplus, yplus);
+    arma::cube adiff = aplus - fast_smoother_block(yplus, Ft, Kt, Lt);
+    
+    for(unsigned int j = 0; j < nb; j++) {
+      unsigned int i = first + j;
+      // the m x 1 x (n + 1) tube of draw j as m x (n + 1) matrix
+      arma::mat adiff_i = adiff.subcube(0, j, 0, m - 1, j, n);
+      if (i < nsim2) {
+        asim.slice(i) = alphahat + adiff_i;
+        if (use_antithetic){
+          asim.slice(i + nsim2) = alphahat - adiff_i;
         }
-        aplus.col(t + 1) = C.col(t * Ctv) + T.slice(t * Ttv) * aplus.col(t) +
-          R.slice(t * Rtv) * uk;
+      } else {
+        asim.slice(nsim - 1) = alphahat + adiff_i;
       }
-      asim.slice(nsim - 1) = alphahat - fast_smoother(Ft, Kt, Lt) + aplus;
     }
-    
-  } else {
-    // for _single simulation_ this version is faster:
-    //  xbeta, C, D, and a1 set to zero when simulating yplus and aplus
-    // (see:
-    //  Marek Jarociński 2015: "A note on implementing the Durbin and Koopman simulation
-    //  smoother")
-    
-    arma::vec um(m);
-    for(unsigned int j = 0; j < m; j++) {
-      um(j) = normal(engine);
+  }
+  
+  return asim;
+}
+
+// simulate states and observations from the unconditional model for a block 
+// of draws stored as m x nb x (n + 1) cube. Draw j uses its own RNG with seed 
+// first_seed + j, and yplus is only overwritten at the observed time points
+void ugg_ssm::simulate_unconditional(const unsigned int first_seed, 
+  const arma::mat& L_P1, arma::cube& aplus, arma::mat& yplus) const {
+  
+  unsigned int nb = yplus.n_cols;
+  
+  arma::mat um(m, nb);
+  arma::mat eps(n, nb, arma::fill::zeros);
+  arma::cube uk(k, nb, n);
+  for (unsigned int j = 0; j < nb; j++) {
+    sitmo::prng_engine draw_engine(first_seed + j);
+    std::normal_distribution<> normal(0.0, 1.0);
+    for(unsigned int i = 0; i < m; i++) {
+      um(i, j) = normal(draw_engine);
     }
-    asim.slice(0).col(0) = L_P1 * um;
     for (unsigned int t = 0; t < n; t++) {
       if (arma::is_finite(y(t))) {
-        y(t) -= arma::as_scalar(Z.col(t * Ztv).t() * asim.slice(0).col(t)) +
-          H(t * Htv) * normal(engine);
+        eps(t, j) = normal(draw_engine);
       }
-      arma::vec uk(k);
-      for(unsigned int j = 0; j < k; j++) {
-        uk(j) = normal(engine);
+      for(unsigned int i = 0; i < k; i++) {
+        uk(i, j, t) = normal(draw_engine);
       }
-      asim.slice(0).col(t + 1) = T.slice(t * Ttv) * asim.slice(0).col(t) +
-        R.slice(t * Rtv) * uk;
     }
-    asim.slice(0) += fast_smoother();
   }
   
-  y = y_tmp;
-  
-  return asim;
+  const structured_T Ts(T, T_struct);
+  aplus.slice(0) = L_P1 * um;
+  aplus.slice(0).each_col() += a1;
+  for (unsigned int t = 0; t < n; t++) {
+    if (arma::is_finite(y(t))) {
+      yplus.row(t) = Z.col(t * Ztv).t() * aplus.slice(t) + H(t * Htv) * eps.row(t) + 
+        xbeta(t) + D(t * Dtv);
+    }
+    aplus.slice(t + 1) = Ts.mult(t, aplus.slice(t)) + R.slice(t * Rtv) * uk.slice(t);
+    aplus.slice(t + 1).each_col() += C.col(t * Ctv);
+  }
 }
 
 /* Fast state smoothing, only returns smoothed estimates of states
@@ -285,41 +358,44 @@ arma::mat ugg_ssm::fast_smoother() const {
   if(xreg.n_cols > 0) {
     y_tmp -= xbeta;
   }
+  const structured_T Ts(T, T_struct);
+  bool blockdiag = Ts.block_diagonal(P1);
   
   for (unsigned int t = 0; t < n; t++) {
     Ft(t) = arma::as_scalar(Z.col(t * Ztv).t() * Pt * Z.col(t * Ztv) + HH(t * Htv));
     if (arma::is_finite(y_tmp(t)) && Ft(t) > zero_tol) {
       Kt.col(t) = Pt * Z.col(t * Ztv) / Ft(t);
       vt(t) = arma::as_scalar(y_tmp(t) - D(t * Dtv) - Z.col(t * Ztv).t() * at.col(t));
-      at.col(t + 1) = C.col(t * Ctv) + T.slice(t * Ttv) * (at.col(t) + Kt.col(t) * vt(t));
+      at.col(t + 1) = C.col(t * Ctv) + Ts.mult(t, at.col(t) + Kt.col(t) * vt(t));
       //Pt = arma::symmatu(T.slice(t * Ttv) * (Pt - Kt.col(t) * Kt.col(t).t() * Ft(t)) * T.slice(t * Ttv).t() + RR.slice(t * Rtv));
       // Switched to numerically better form
-      arma::mat tmp = arma::eye(m, m) - Kt.col(t) * Z.col(t * Ztv).t();
-      Pt = arma::symmatu(T.slice(t * Ttv) * (tmp * Pt * tmp.t() + Kt.col(t) * HH(t * Htv) * Kt.col(t).t()) * T.slice(t * Ttv).t() + RR.slice(t * Rtv));
+      blockdiag = blockdiag && Ts.within_block(Z.col(t * Ztv));
+      Pt = Ts.predict(t, joseph_update(Pt, Kt.col(t), Z.col(t * Ztv), HH(t * Htv)), 
+        RR.slice(t * Rtv), blockdiag);
     } else {
-      at.col(t + 1) = C.col(t * Ctv) + T.slice(t * Ttv) * at.col(t);
-      Pt = arma::symmatu(T.slice(t * Ttv) * Pt * T.slice(t * Ttv).t() + RR.slice(t * Rtv));
+      at.col(t + 1) = C.col(t * Ctv) + Ts.mult(t, at.col(t));
+      Pt = Ts.predict(t, Pt, RR.slice(t * Rtv), blockdiag);
     }
   }
   arma::mat rt(m, n);
   rt.col(n - 1).zeros();
   for (int t = (n - 1); t > 0; t--) {
     if (arma::is_finite(y_tmp(t)) && Ft(t) > zero_tol){
-      arma::mat L = T.slice(t * Ttv) * (arma::eye(m, m) - Kt.col(t) * Z.col(t * Ztv).t());
+      arma::mat L = Ts.L(t, Kt.col(t), Z.col(t * Ztv));
       rt.col(t - 1) = Z.col(t * Ztv) / Ft(t) * vt(t) + L.t() * rt.col(t);
     } else {
-      rt.col(t - 1) = T.slice(t * Ttv).t() * rt.col(t);
+      rt.col(t - 1) = Ts.mult_t(t, rt.col(t));
     }
   }
   if (arma::is_finite(y(0)) && Ft(0) > zero_tol){
-    arma::mat L = T.slice(0) * (arma::eye(m, m) - Kt.col(0) * Z.col(0).t());
+    arma::mat L = Ts.L(0, Kt.col(0), Z.col(0));
     at.col(0) = a1 + P1 * (Z.col(0) / Ft(0) * vt(0) + L.t() * rt.col(0));
   } else {
-    at.col(0) = a1 + P1 * T.slice(0).t() * rt.col(0);
+    at.col(0) = a1 + P1 * Ts.mult_t(0, rt.col(0));
   }
   
   for (unsigned int t = 0; t < (n - 1); t++) {
-    at.col(t + 1) = C.col(t * Ctv) + T.slice(t * Ttv) * at.col(t) + RR.slice(t * Rtv) * rt.col(t);
+    at.col(t + 1) = C.col(t * Ctv) + Ts.mult(t, at.col(t)) + RR.slice(t * Rtv) * rt.col(t);
   }
   
   return at;
@@ -334,6 +410,14 @@ arma::mat ugg_ssm::fast_smoother() const {
  */
 arma::mat ugg_ssm::fast_smoother(const arma::vec& Ft, const arma::mat& Kt,
   const arma::cube& Lt) const {
+  return fast_smoother(y, Ft, Kt, Lt);
+}
+
+/* Fast state smoothing of observations y_sim (with same missingness pattern 
+ * as y) using precomputed Ft, Kt and Lt. Used in simulation smoother.
+ */
+arma::mat ugg_ssm::fast_smoother(const arma::vec& y_sim, const arma::vec& Ft, 
+  const arma::mat& Kt, const arma::cube& Lt) const {
   
   arma::mat at(m, n + 1);
   arma::mat Pt(m, m);
@@ -343,17 +427,18 @@ arma::mat ugg_ssm::fast_smoother(const arma::vec& Ft, const arma::mat& Kt,
   at.col(0) = a1;
   Pt = P1;
   
-  arma::vec y_tmp = y;
+  arma::vec y_tmp = y_sim;
   if (xreg.n_cols > 0) {
     y_tmp -= xbeta;
   }
+  const structured_T Ts(T, T_struct);
   
   for (unsigned int t = 0; t < n; t++) {
     if (arma::is_finite(y_tmp(t)) && Ft(t) > zero_tol) {
       vt(t) = arma::as_scalar(y_tmp(t) - D(t * Dtv) - Z.col(t * Ztv).t() * at.col(t));
-      at.col(t + 1) = C.col(t * Ctv) + T.slice(t * Ttv) * (at.col(t) + Kt.col(t) * vt(t));
+      at.col(t + 1) = C.col(t * Ctv) + Ts.mult(t, at.col(t) + Kt.col(t) * vt(t));
     } else {
-      at.col(t + 1) = C.col(t * Ctv) + T.slice(t * Ttv) * at.col(t);
+      at.col(t + 1) = C.col(t * Ctv) + Ts.mult(t, at.col(t));
     }
   }
   
@@ -364,18 +449,73 @@ arma::mat ugg_ssm::fast_smoother(const arma::vec& Ft, const arma::mat& Kt,
     if (arma::is_finite(y_tmp(t)) && Ft(t) > zero_tol){
       rt.col(t - 1) = Z.col(t * Ztv) / Ft(t) * vt(t) + Lt.slice(t).t() * rt.col(t);
     } else {
-      rt.col(t - 1) = T.slice(t * Ttv).t() * rt.col(t);
+      rt.col(t - 1) = Ts.mult_t(t, rt.col(t));
     }
   }
-  if (arma::is_finite(y(0)) && Ft(0) > zero_tol){
-    arma::mat L = T.slice(0) * (arma::eye(m, m) - Kt.col(0) * Z.col(0).t());
+  if (arma::is_finite(y_tmp(0)) && Ft(0) > zero_tol){
+    arma::mat L = Ts.L(0, Kt.col(0), Z.col(0));
     at.col(0) = a1 + P1 * (Z.col(0) / Ft(0) * vt(0) + L.t() * rt.col(0));
   } else {
-    at.col(0) = a1 + P1 * T.slice(0).t() * rt.col(0);
+    at.col(0) = a1 + P1 * Ts.mult_t(0, rt.col(0));
+  }
+  
+  for (unsigned int t = 0; t < (n - 1); t++) {
+    at.col(t + 1) = C.col(t * Ctv) + Ts.mult(t, at.col(t)) + RR.slice(t * Rtv) * rt.col(t);
+  }
+  
+  return at;
+}
+
+/* Fast state smoothing of a block of simulated observations (columns of y_sim, 
+ * with same missingness pattern as y) using precomputed Ft, Kt and Lt. 
+ * Returns m x nb x (n + 1) cube so that the recursions operate on m x nb matrices.
+ */
+arma::cube ugg_ssm::fast_smoother_block(const arma::mat& y_sim, const arma::vec& Ft, 
+  const arma::mat& Kt, const arma::cube& Lt) const {
+  
+  unsigned int nb = y_sim.n_cols;
+  arma::cube at(m, nb, n + 1);
+  arma::mat vt(n, nb);
+  
+  at.slice(0).each_col() = a1;
+  
+  arma::mat y_tmp = y_sim;
+  if (xreg.n_cols > 0) {
+    y_tmp.each_col() -= xbeta;
+  }
+  const structured_T Ts(T, T_struct);
+  
+  for (unsigned int t = 0; t < n; t++) {
+    if (arma::is_finite(y(t)) && Ft(t) > zero_tol) {
+      vt.row(t) = y_tmp.row(t) - D(t * Dtv) - Z.col(t * Ztv).t() * at.slice(t);
+      at.slice(t + 1) = Ts.mult(t, at.slice(t) + Kt.col(t) * vt.row(t));
+    } else {
+      at.slice(t + 1) = Ts.mult(t, at.slice(t));
+    }
+    at.slice(t + 1).each_col() += C.col(t * Ctv);
+  }
+  
+  arma::cube rt(m, nb, n);
+  rt.slice(n - 1).zeros();
+  
+  for (int t = (n - 1); t > 0; t--) {
+    if (arma::is_finite(y(t)) && Ft(t) > zero_tol){
+      rt.slice(t - 1) = Z.col(t * Ztv) / Ft(t) * vt.row(t) + Lt.slice(t).t() * rt.slice(t);
+    } else {
+      rt.slice(t - 1) = Ts.mult_t(t, rt.slice(t));
+    }
+  }
+  if (arma::is_finite(y(0)) && Ft(0) > zero_tol){
+    arma::mat L = Ts.L(0, Kt.col(0), Z.col(0));
+    at.slice(0) = P1 * (Z.col(0) / Ft(0) * vt.row(0) + L.t() * rt.slice(0));
+  } else {
+    at.slice(0) = P1 * Ts.mult_t(0, rt.slice(0));
   }
+  at.slice(0).each_col() += a1;
   
   for (unsigned int t = 0; t < (n - 1); t++) {
-    at.col(t + 1) = C.col(t * Ctv) + T.slice(t * Ttv) * at.col(t) + RR.slice(t * Rtv) * rt.col(t);
+    at.slice(t + 1) = Ts.mult(t, at.slice(t)) + RR.slice(t * Rtv) * rt.slice(t);
+    at.slice(t + 1).each_col() += C.col(t * Ctv);
   }
   
   return at;
@@ -383,6 +523,16 @@ arma::mat ugg_ssm::fast_smoother(const arma::vec& Ft, const arma::mat& Kt,
 
 arma::mat ugg_ssm::fast_precomputing_smoother(arma::vec& Ft, arma::mat& Kt,
   arma::cube& Lt) const {
+  double loglik;
+  return fast_precomputing_smoother(Ft, Kt, Lt, loglik);
+}
+
+/* Fast state smoothing which returns also Ft, Kt, Lt, and the log-likelihood 
+ * computed during the forward pass, so that the approximating model does not 
+ * need separate call to log_likelihood.
+ */
+arma::mat ugg_ssm::fast_precomputing_smoother(arma::vec& Ft, arma::mat& Kt,
+  arma::cube& Lt, double& loglik) const {
   
   arma::mat at(m, n + 1);
   arma::mat Pt(m, m);
@@ -395,19 +545,27 @@ arma::mat ugg_ssm::fast_precomputing_smoother(arma::vec& Ft, arma::mat& Kt,
   if (xreg.n_cols > 0) {
     y_tmp -= xbeta;
   }
+  
+  const double LOG2PI = std::log(2.0 * M_PI);
+  loglik = 0.0;
+  const structured_T Ts(T, T_struct);
+  bool blockdiag = Ts.block_diagonal(P1);
+  
   for (unsigned int t = 0; t < n; t++) {
     Ft(t) = arma::as_scalar(Z.col(t * Ztv).t() * Pt * Z.col(t * Ztv) + HH(t * Htv));
     if (arma::is_finite(y_tmp(t)) && Ft(t) > zero_tol) {
       Kt.col(t) = Pt * Z.col(t * Ztv) / Ft(t);
       vt(t) = arma::as_scalar(y_tmp(t) - D(t * Dtv) - Z.col(t * Ztv).t() * at.col(t));
-      at.col(t + 1) = C.col(t * Ctv) + T.slice(t * Ttv) * (at.col(t) + Kt.col(t) * vt(t));
+      at.col(t + 1) = C.col(t * Ctv) + Ts.mult(t, at.col(t) + Kt.col(t) * vt(t));
+      loglik -= 0.5 * (LOG2PI + std::log(Ft(t)) + vt(t) * vt(t) / Ft(t));
       //Pt = arma::symmatu(T.slice(t * Ttv) * (Pt - Kt.col(t) * Kt.col(t).t() * Ft(t)) * T.slice(t * Ttv).t() + RR.slice(t * Rtv));
       // Switched to numerically better form
-      arma::mat tmp = arma::eye(m, m) - Kt.col(t) * Z.col(t * Ztv).t();
-      Pt = arma::symmatu(T.slice(t * Ttv) * (tmp * Pt * tmp.t() + Kt.col(t) * HH(t * Htv) * Kt.col(t).t()) * T.slice(t * Ttv).t() + RR.slice(t * Rtv));
+      blockdiag = blockdiag && Ts.within_block(Z.col(t * Ztv));
+      Pt = Ts.predict(t, joseph_update(Pt, Kt.col(t), Z.col(t * Ztv), HH(t * Htv)), 
+        RR.slice(t * Rtv), blockdiag);
     } else {
-      at.col(t + 1) = C.col(t * Ctv) + T.slice(t * Ttv) * at.col(t);
-      Pt = arma::symmatu(T.slice(t * Ttv) * Pt * T.slice(t * Ttv).t() + RR.slice(t * Rtv));
+      at.col(t + 1) = C.col(t * Ctv) + Ts.mult(t, at.col(t));
+      Pt = Ts.predict(t, Pt, RR.slice(t * Rtv), blockdiag);
     }
   }
   
@@ -416,20 +574,20 @@ arma::mat ugg_ssm::fast_precomputing_smoother(arma::vec& Ft, arma::mat& Kt,
   
   for (int t = (n - 1); t > 0; t--) {
     if (arma::is_finite(y_tmp(t)) && Ft(t) > zero_tol){
-      Lt.slice(t) = T.slice(t * Ttv) * (arma::eye(m, m) - Kt.col(t) * Z.col(t * Ztv).t());
+      Lt.slice(t) = Ts.L(t, Kt.col(t), Z.col(t * Ztv));
       rt.col(t - 1) = Z.col(t * Ztv) / Ft(t) * vt(t) + Lt.slice(t).t() * rt.col(t);
     } else {
-      rt.col(t - 1) = T.slice(t * Ttv).t() * rt.col(t);
+      rt.col(t - 1) = Ts.mult_t(t, rt.col(t));
     }
   }
   if (arma::is_finite(y_tmp(0)) && Ft(0) > zero_tol){
-    arma::mat L = T.slice(0) * (arma::eye(m, m) - Kt.col(0) * Z.col(0).t());
+    arma::mat L = Ts.L(0, Kt.col(0), Z.col(0));
     at.col(0) = a1 + P1 * (Z.col(0) / Ft(0) * vt(0) + L.t() * rt.col(0));
   } else {
-    at.col(0) = a1 + P1 * T.slice(0).t() * rt.col(0);
+    at.col(0) = a1 + P1 * Ts.mult_t(0, rt.col(0));
   }
   for (unsigned int t = 0; t < (n - 1); t++) {
-    at.col(t + 1) = C.col(t * Ctv) + T.slice(t * Ttv) * at.col(t) + RR.slice(t * Rtv) * rt.col(t);
+    at.col(t + 1) = C.col(t * Ctv) + Ts.mult(t, at.col(t)) + RR.slice(t * Rtv) * rt.col(t);
   }
   
   return at;
@@ -449,6 +607,8 @@ void ugg_ssm::smoother_ccov(arma::mat& at, arma::cube& Pt, arma::cube& ccov) con
   if(xreg.n_cols > 0) {
     y_tmp -= xbeta;
   }
+  const structured_T Ts(T, T_struct);
+  bool blockdiag = Ts.block_diagonal(P1);
   
   for (unsigned int t = 0; t < n; t++) {
     Ft(t) = arma::as_scalar(Z.col(t * Ztv).t() * Pt.slice(t) * Z.col(t * Ztv) +
@@ -456,16 +616,16 @@ void ugg_ssm::smoother_ccov(arma::mat& at, arma::cube& Pt, arma::cube& ccov) con
     if (arma::is_finite(y_tmp(t)) && Ft(t) > zero_tol) {
       Kt.col(t) = Pt.slice(t) * Z.col(t * Ztv) / Ft(t);
       vt(t) = arma::as_scalar(y_tmp(t) - D(t * Dtv) - Z.col(t * Ztv).t() * at.col(t));
-      at.col(t + 1) = C.col(t * Ctv) + T.slice(t * Ttv) * (at.col(t) + Kt.col(t) * vt(t));
+      at.col(t + 1) = C.col(t * Ctv) + Ts.mult(t, at.col(t) + Kt.col(t) * vt(t));
       //Pt.slice(t + 1) = arma::symmatu(T.slice(t * Ttv) * (Pt.slice(t) -
       //  Kt.col(t) * Kt.col(t).t() * Ft(t)) * T.slice(t * Ttv).t() + RR.slice(t * Rtv));
       // Switched to numerically better form
-      arma::mat tmp = arma::eye(m, m) - Kt.col(t) * Z.col(t * Ztv).t();
-      Pt.slice(t + 1) = arma::symmatu(T.slice(t * Ttv) * (tmp * Pt.slice(t) * tmp.t() + Kt.col(t) * HH(t * Htv) * Kt.col(t).t()) * T.slice(t * Ttv).t() + RR.slice(t * Rtv));
+      blockdiag = blockdiag && Ts.within_block(Z.col(t * Ztv));
+      Pt.slice(t + 1) = Ts.predict(t, joseph_update(Pt.slice(t), Kt.col(t), 
+        Z.col(t * Ztv), HH(t * Htv)), RR.slice(t * Rtv), blockdiag);
     } else {
-      at.col(t + 1) = C.col(t * Ctv) + T.slice(t * Ttv) * at.col(t);
-      Pt.slice(t + 1) = arma::symmatu(T.slice(t * Ttv) * Pt.slice(t) * T.slice(t * Ttv).t() +
-        RR.slice(t * Rtv));
+      at.col(t + 1) = C.col(t * Ctv) + Ts.mult(t, at.col(t));
+      Pt.slice(t + 1) = Ts.predict(t, Pt.slice(t), RR.slice(t * Rtv), blockdiag);
     }
     ccov.slice(t) = Pt.slice(t+1); //store for smoothing;
   }
@@ -476,15 +636,16 @@ void ugg_ssm::smoother_ccov(arma::mat& at, arma::cube& Pt, arma::cube& ccov) con
   
   for (int t = (n - 1); t >= 0; t--) {
     if (arma::is_finite(y_tmp(t)) && Ft(t) > zero_tol){
-      arma::mat L = T.slice(t * Ttv) * (arma::eye(m, m) - Kt.col(t) * Z.col(t * Ztv).t());
+      arma::mat L = Ts.L(t, Kt.col(t), Z.col(t * Ztv));
       //P[t+1] stored to ccov_t
       ccov.slice(t) = Pt.slice(t) * L.t() * (arma::eye(m, m) - Nt * ccov.slice(t));
       rt = Z.col(t * Ztv) / Ft(t) * vt(t) + L.t() * rt;
-      Nt = arma::symmatu(Z.col(t * Ztv) * Z.col(t * Ztv).t() / Ft(t) + L.t() * Nt * L);
+      Nt = arma::symmatu(Z.col(t * Ztv) * Z.col(t * Ztv).t() / Ft(t) + 
+        L_sandwich(Ts.sandwich_t(t, Nt), Kt.col(t), Z.col(t * Ztv)));
     } else {
-      ccov.slice(t) = Pt.slice(t) * T.slice(t * Ttv).t() * (arma::eye(m, m) - Nt * ccov.slice(t));
-      rt = T.slice(t * Ttv).t() * rt;
-      Nt = arma::symmatu(T.slice(t * Ttv).t() * Nt * T.slice(t * Ttv));
+      ccov.slice(t) = Ts.mult(t, Pt.slice(t)).t() * (arma::eye(m, m) - Nt * ccov.slice(t));
+      rt = Ts.mult_t(t, rt);
+      Nt = arma::symmatu(Ts.sandwich_t(t, Nt));
       //P[t+1] stored to ccov_t //CHECK THIS
     }
     at.col(t) += Pt.slice(t) * rt;
@@ -507,6 +668,8 @@ double ugg_ssm::filter(arma::mat& at, arma::mat& att, arma::cube& Pt,
   }
   
   const double LOG2PI = std::log(2.0 * M_PI);
+  const structured_T Ts(T, T_struct);
+  bool blockdiag = Ts.block_diagonal(P1);
   
   for (unsigned int t = 0; t < n; t++) {
     double F = arma::as_scalar(Z.col(t * Ztv).t() * Pt.slice(t) * Z.col(t * Ztv) + HH(t * Htv));
@@ -514,18 +677,18 @@ double ugg_ssm::filter(arma::mat& at, arma::mat& att, arma::cube& Pt,
       double v = arma::as_scalar(y_tmp(t) - D(t * Dtv) - Z.col(t * Ztv).t() * at.col(t));
       arma::vec K = Pt.slice(t) * Z.col(t * Ztv) / F;
       att.col(t) = at.col(t) + K * v;
-      at.col(t + 1) = C.col(t * Ctv) + T.slice(t * Ttv) * (att.col(t));
+      at.col(t + 1) = C.col(t * Ctv) + Ts.mult(t, att.col(t));
       // Ptt.slice(t) = Pt.slice(t) - K * K.t() * F;
       // Switched to numerically better form
-      arma::mat tmp = arma::eye(m, m) - K * Z.col(t * Ztv).t();
-      Ptt.slice(t) = tmp * Pt.slice(t) * tmp.t() + K * HH(t * Htv) * K.t();
-      Pt.slice(t + 1) = arma::symmatu(T.slice(t * Ttv) * Ptt.slice(t) * T.slice(t * Ttv).t() + RR.slice(t * Rtv));
+      Ptt.slice(t) = joseph_update(Pt.slice(t), K, Z.col(t * Ztv), HH(t * Htv));
+      blockdiag = blockdiag && Ts.within_block(Z.col(t * Ztv));
+      Pt.slice(t + 1) = Ts.predict(t, Ptt.slice(t), RR.slice(t * Rtv), blockdiag);
       logLik -= 0.5 * (LOG2PI + std::log(F) + v * v/F);
     } else {
       att.col(t) = at.col(t);
-      at.col(t + 1) = C.col(t * Ctv) + T.slice(t * Ttv) * att.col(t);
+      at.col(t + 1) = C.col(t * Ctv) + Ts.mult(t, att.col(t));
       Ptt.slice(t) = Pt.slice(t);
-      Pt.slice(t + 1) = arma::symmatu(T.slice(t * Ttv) * Ptt.slice(t) * T.slice(t * Ttv).t() + RR.slice(t * Rtv));
+      Pt.slice(t + 1) = Ts.predict(t, Ptt.slice(t), RR.slice(t * Rtv), blockdiag);
     }
   }
   return logLik;
@@ -543,6 +706,8 @@ void ugg_ssm::smoother(arma::mat& at, arma::cube& Pt) const {
   if (xreg.n_cols > 0) {
     y_tmp -= xbeta;
   }
+  const structured_T Ts(T, T_struct);
+  bool blockdiag = Ts.block_diagonal(P1);
   
   for (unsigned int t = 0; t < n; t++) {
     Ft(t) = arma::as_scalar(Z.col(t * Ztv).t() * Pt.slice(t) * Z.col(t * Ztv) +
@@ -550,16 +715,16 @@ void ugg_ssm::smoother(arma::mat& at, arma::cube& Pt) const {
     if (arma::is_finite(y_tmp(t)) && Ft(t) > zero_tol) {
       Kt.col(t) = Pt.slice(t) * Z.col(t * Ztv) / Ft(t);
       vt(t) = arma::as_scalar(y_tmp(t) - D(t * Dtv) - Z.col(t * Ztv).t() * at.col(t));
-      at.col(t + 1) = C.col(t * Ctv) + T.slice(t * Ttv) * (at.col(t) + Kt.col(t) * vt(t));
+      at.col(t + 1) = C.col(t * Ctv) + Ts.mult(t, at.col(t) + Kt.col(t) * vt(t));
       //Pt.slice(t + 1) = arma::symmatu(T.slice(t * Ttv) * (Pt.slice(t) -
       //  Kt.col(t) * Kt.col(t).t() * Ft(t)) * T.slice(t * Ttv).t() + RR.slice(t * Rtv));
       // Switched to numerically better form
-      arma::mat tmp = arma::eye(m, m) - Kt.col(t) * Z.col(t * Ztv).t();
-      Pt.slice(t + 1) = arma::symmatu(T.slice(t * Ttv) * (tmp * Pt.slice(t) * tmp.t() + Kt.col(t) * HH(t * Htv) * Kt.col(t).t()) * T.slice(t * Ttv).t() + RR.slice(t * Rtv));
+      blockdiag = blockdiag && Ts.within_block(Z.col(t * Ztv));
+      Pt.slice(t + 1) = Ts.predict(t, joseph_update(Pt.slice(t), Kt.col(t), 
+        Z.col(t * Ztv), HH(t * Htv)), RR.slice(t * Rtv), blockdiag);
     } else {
-      at.col(t + 1) = C.col(t * Ctv) + T.slice(t * Ttv) * at.col(t);
-      Pt.slice(t + 1) = arma::symmatu(T.slice(t * Ttv) * Pt.slice(t) * T.slice(t * Ttv).t() +
-        RR.slice(t * Rtv));
+      at.col(t + 1) = C.col(t * Ctv) + Ts.mult(t, at.col(t));
+      Pt.slice(t + 1) = Ts.predict(t, Pt.slice(t), RR.slice(t * Rtv), blockdiag);
     }
   }
   
@@ -568,20 +733,23 @@ void ugg_ssm::smoother(arma::mat& at, arma::cube& Pt) const {
   
   for (int t = (n - 1); t >= 0; t--) {
     if (arma::is_finite(y_tmp(t)) && Ft(t) > zero_tol){
-      arma::mat L = T.slice(t * Ttv) * (arma::eye(m, m) - Kt.col(t) * Z.col(t * Ztv).t());
+      arma::mat L = Ts.L(t, Kt.col(t), Z.col(t * Ztv));
       rt = Z.col(t * Ztv) / Ft(t) * vt(t) + L.t() * rt;
-      Nt = arma::symmatu(Z.col(t * Ztv) * Z.col(t * Ztv).t() / Ft(t) + L.t() * Nt * L);
+      Nt = arma::symmatu(Z.col(t * Ztv) * Z.col(t * Ztv).t() / Ft(t) + 
+        L_sandwich(Ts.sandwich_t(t, Nt), Kt.col(t), Z.col(t * Ztv)));
     } else {
-      rt = T.slice(t * Ttv).t() * rt;
-      Nt = arma::symmatu(T.slice(t * Ttv).t() * Nt * T.slice(t * Ttv));
+      rt = Ts.mult_t(t, rt);
+      Nt = arma::symmatu(Ts.sandwich_t(t, Nt));
     }
     at.col(t) += Pt.slice(t) * rt;
     Pt.slice(t) -= arma::symmatu(Pt.slice(t) * Nt * Pt.slice(t));
   }
 }
 
-Rcpp::List ugg_ssm::predict_interval(const arma::vec& probs, const arma::mat& theta_posterior,
-  const arma::mat& alpha, const arma::uvec& counts, const unsigned int predict_type) {
+void ugg_ssm::predict_interval(const arma::vec& probs, const arma::mat& theta_posterior,
+  const arma::mat& alpha, const arma::uvec& counts, const unsigned int predict_type,
+  arma::cube& intv, arma::cube& mean_pred, arma::cube& sd_pred,
+  const unsigned int n_threads) {
   
   update_model(theta_posterior.col(0));
   a1 = alpha.col(0);
@@ -595,18 +763,18 @@ Rcpp::List ugg_ssm::predict_interval(const arma::vec& probs, const arma::mat& th
   unsigned int n_samples = theta_posterior.n_cols;
   if (predict_type < 3) {
     
-    arma::mat mean_pred(n, n_samples);
-    arma::mat var_pred(n, n_samples);
+    arma::mat mean_t(n, n_samples);
+    arma::mat var_t(n, n_samples);
     
     for(unsigned int t = 0; t < n; t++) {
-      mean_pred(t, 0) = arma::as_scalar(xbeta(t) +
+      mean_t(t, 0) = arma::as_scalar(xbeta(t) +
         Z.col(Ztv * t).t() * at.col(t));
-      var_pred(t, 0) = arma::as_scalar(Z.col(Ztv * t).t() * Pt.slice(t) * Z.col(Ztv * t));
+      var_t(t, 0) = arma::as_scalar(Z.col(Ztv * t).t() * Pt.slice(t) * Z.col(Ztv * t));
     }
     
     if (predict_type == 1) {
       for(unsigned int t = 0; t < n; t++) {
-        var_pred(t, 0) += HH(Htv * t);
+        var_t(t, 0) += HH(Htv * t);
       }
     }
     
@@ -617,34 +785,32 @@ Rcpp::List ugg_ssm::predict_interval(const arma::vec& probs, const arma::mat& th
       filter(at, att, Pt, Ptt);
       
       for(unsigned int t = 0; t < n; t++) {
-        mean_pred(t, i) = arma::as_scalar(xbeta(t) +
+        mean_t(t, i) = arma::as_scalar(xbeta(t) +
           Z.col(Ztv * t).t() * at.col(t));
-        var_pred(t, i) = arma::as_scalar(Z.col(Ztv * t).t() * Pt.slice(t) * Z.col(Ztv * t));
+        var_t(t, i) = arma::as_scalar(Z.col(Ztv * t).t() * Pt.slice(t) * Z.col(Ztv * t));
       }
       if (predict_type == 1) {
         for(unsigned int t = 0; t < n; t++) {
-          var_pred(t, i) += HH(Htv * t);
+          var_t(t, i) += HH(Htv * t);
         }
       }
       
     }
     
-    arma::mat expanded_sd = rep_mat(arma::sqrt(var_pred), counts);
-    arma::inplace_trans(expanded_sd);
-    arma::mat expanded_mean = rep_mat(mean_pred, counts);
-    arma::inplace_trans(expanded_mean);
-    arma::mat intv = intervals(expanded_mean, expanded_sd, probs, n);
-    
-    return Rcpp::List::create(Rcpp::Named("intervals") = intv,
-      Rcpp::Named("mean_pred") = expanded_mean,
-      Rcpp::Named("sd_pred") = expanded_sd);
+    sd_pred.set_size(n_samples, n, 1);
+    sd_pred.slice(0) = arma::sqrt(var_t).t();
+    mean_pred.set_size(n_samples, n, 1);
+    mean_pred.slice(0) = mean_t.t();
+    intv.set_size(n, probs.n_elem, 1);
+    intv.slice(0) = intervals(mean_pred.slice(0), sd_pred.slice(0), 
+      counts, probs, n, n_threads);
   } else {
-    arma::cube mean_pred(n, n_samples, m);
-    arma::cube var_pred(n, n_samples, m);
+    arma::cube mean_t(n, n_samples, m);
+    arma::cube var_t(n, n_samples, m);
     
     for(unsigned int t = 0; t < n; t++) {
-      mean_pred.tube(t, 0) = at.col(t);
-      var_pred.tube(t, 0) = Pt.slice(t).diag();
+      mean_t.tube(t, 0) = at.col(t);
+      var_t.tube(t, 0) = Pt.slice(t).diag();
     }
     
     for (unsigned int i = 1; i < n_samples; i++) {
@@ -654,63 +820,37 @@ Rcpp::List ugg_ssm::predict_interval(const arma::vec& probs, const arma::mat& th
       filter(at, att, Pt, Ptt);
       
       for(unsigned int t = 0; t < n; t++) {
-        mean_pred.tube(t, i) = at.col(t);
-        var_pred.tube(t, i) = Pt.slice(t).diag();
+        mean_t.tube(t, i) = at.col(t);
+        var_t.tube(t, i) = Pt.slice(t).diag();
       }
     }
     
-    arma::cube intv(n, probs.n_elem, m);
-    arma::cube expanded_sd(arma::accu(counts), n, m);
-    arma::cube expanded_mean(arma::accu(counts), n, m);
+    intv.set_size(n, probs.n_elem, m);
+    sd_pred.set_size(n_samples, n, m);
+    mean_pred.set_size(n_samples, n, m);
     for (unsigned int i = 0; i < m; i++) {
-      arma::mat tmp1 = rep_mat(arma::sqrt(var_pred.slice(i)), counts);
-      expanded_sd.slice(i) = tmp1.t();
-      arma::mat tmp2 = rep_mat(mean_pred.slice(i), counts);
-      expanded_mean.slice(i) = tmp2.t();
-      intv.slice(i) = intervals(expanded_mean.slice(i), expanded_sd.slice(i),
-        probs, n);
+      sd_pred.slice(i) = arma::sqrt(var_t.slice(i)).t();
+      mean_pred.slice(i) = mean_t.slice(i).t();
+      intv.slice(i) = intervals(mean_pred.slice(i), sd_pred.slice(i),
+        counts, probs, n, n_threads);
     }
-    
-    
-    return Rcpp::List::create(Rcpp::Named("intervals") = intv,
-      Rcpp::Named("mean_pred") = expanded_mean,
-      Rcpp::Named("sd_pred") = expanded_sd);
   }
 }
-arma::cube ugg_ssm::predict_sample(const arma::mat& theta_posterior,
-  const arma::mat& alpha, const arma::uvec& counts, const unsigned int predict_type, 
-  const unsigned int nsim) {
-  
-  unsigned int d = 1;
-  if (predict_type == 3) d = m;
-  
-  arma::mat expanded_theta = rep_mat(theta_posterior, counts);
-  arma::mat expanded_alpha = rep_mat(alpha, counts);
-  unsigned int n_samples = expanded_theta.n_cols;
-  arma::cube sample(d, n, nsim * n_samples);
-  
-  for (unsigned int i = 0; i < n_samples; i++) {
-    update_model(expanded_theta.col(i));
-    a1 = expanded_alpha.col(i);
-    sample.slices(i * nsim, (i + 1) * nsim - 1) = sample_model(predict_type, nsim);
-  }
-  
-  return sample;
-}
-
-
-arma::mat ugg_ssm::sample_model(const unsigned int predict_type, const unsigned int nsim) {
+// simulate nsim future paths starting from a1_sim using the given RNG
+arma::cube ugg_ssm::sample_model(const arma::vec& a1_sim, 
+  const unsigned int predict_type, const unsigned int nsim, 
+  sitmo::prng_engine& draw_engine) const {
   
   arma::cube alpha(m, n, nsim);
   
   std::normal_distribution<> normal(0.0, 1.0);
   for (unsigned int i = 0; i < nsim; i++) {
-    alpha.slice(i).col(0) = a1;
+    alpha.slice(i).col(0) = a1_sim;
     
     for (unsigned int t = 0; t < (n - 1); t++) {
       arma::vec uk(k);
       for(unsigned int j = 0; j < k; j++) {
-        uk(j) = normal(engine);
+        uk(j) = normal(draw_engine);
       }
       alpha.slice(i).col(t + 1) = C.col(t * Ctv) + 
         T.slice(t * Ttv) * alpha.slice(i).col(t) + R.slice(t * Rtv) * uk;
@@ -724,7 +864,7 @@ arma::mat ugg_ssm::sample_model(const unsigned int predict_type, const unsigned
         y(0, t, i) = xbeta(t) + D(t * Dtv) +
           arma::as_scalar(Z.col(t * Ztv).t() * alpha.slice(i).col(t));
         if(predict_type == 1)
-          y(0, t, i) += H(t * Htv) * normal(engine);
+          y(0, t, i) += H(t * Htv) * normal(draw_engine);
       }
     }
     return y;
@@ -751,6 +891,9 @@ double ugg_ssm::bsf_filter(const unsigned int nsim, arma::cube& alpha,
   std::uniform_real_distribution<> unif(0.0, 1.0);
   arma::vec normalized_weights(nsim);
   double loglik = 0.0;
+  // normalizing constants of the observation densities, computed once 
+  // instead of at every time point
+  arma::vec H_const = -0.5 * std::log(2.0 * M_PI) - arma::log(H);
   
   if(arma::is_finite(y(0))) {
     
@@ -767,7 +910,7 @@ double ugg_ssm::bsf_filter(const unsigned int nsim, arma::cube& alpha,
     } else {
       return -std::numeric_limits<double>::infinity();
     }
-    loglik = max_weight + std::log(sum_weights / nsim) + norm_log_const(H(0));
+    loglik = max_weight + std::log(sum_weights / nsim) + H_const(0);
   } else {
     weights.col(0).ones();
     normalized_weights.fill(1.0 / nsim);
@@ -812,7 +955,7 @@ double ugg_ssm::bsf_filter(const unsigned int nsim, arma::cube& alpha,
         return -std::numeric_limits<double>::infinity();
       }
       loglik += max_weight + std::log(sum_weights / nsim) +
-        norm_log_const(H(Htv * (t + 1)));
+        H_const(Htv * (t + 1));
     } else {
       weights.col(t + 1).ones();
       normalized_weights.fill(1.0/nsim);
@@ -4,11 +4,13 @@
 
 #include <sitmo.h>
 #include "bssm.h"
+#include "structured_T.h"
 
 class ugg_ssm {
   
 public:
   
+#ifndef BSSM_STANDALONE
   // constructor from Rcpp::List
   ugg_ssm(const Rcpp::List& model, 
     const unsigned int seed = 1, 
@@ -16,6 +18,7 @@ public:
     const arma::uvec& H_ind_ = arma::uvec(), 
     const arma::uvec& T_ind_ = arma::uvec(), 
     const arma::uvec& R_ind_ = arma::uvec());
+#endif
   
   // constructor from armadillo objects
   ugg_ssm(const arma::vec& y, const arma::mat& Z, const arma::vec& H, 
@@ -39,13 +42,26 @@ public:
   
   // compute the log-likelihood
   double log_likelihood() const;
+  // log-likelihood given the predictive distribution N(at, Pt) of the first 
+  // state, at and Pt are updated to the prediction of the state after y(n - 1)
+  double log_likelihood(arma::vec& at, arma::mat& Pt) const;
   
+  // simulation smoother, multiple draws are run in parallel using n_threads, 
+  // in blocks of block_size draws (values between 32 and 256 work well)
+  arma::cube simulate_states(const unsigned int nsim_states, 
+    const bool use_antithetic = true, const unsigned int n_threads = 1,
+    const unsigned int block_size = 64);
+  // simulation smoother using precomputed output of fast_precomputing_smoother
   arma::cube simulate_states(const unsigned int nsim_states, 
-    const bool use_antithetic = true);
+    const bool use_antithetic, const arma::mat& alphahat, const arma::vec& Ft, 
+    const arma::mat& Kt, const arma::cube& Lt, const unsigned int n_threads = 1,
+    const unsigned int block_size = 64);
   
   // compute the covariance matrices
   void compute_RR();
   void compute_HH() { HH = square(H); }
+  // compute the sparse form of T and the independent blocks of states
+  void compute_T_structure() { T_struct = T_structure(T, RR, P1); }
   // compute the regression part
   void compute_xbeta() { xbeta = xreg * beta; }
   
@@ -54,9 +70,18 @@ public:
   // fast smoothing using precomputed matrices
   arma::mat fast_smoother(const arma::vec& Ft, const arma::mat& Kt,
     const arma::cube& Lt) const;
+  // fast smoothing of simulated observations using precomputed matrices
+  arma::mat fast_smoother(const arma::vec& y_sim, const arma::vec& Ft, 
+    const arma::mat& Kt, const arma::cube& Lt) const;
+  // fast smoothing of a block of simulated observations, returns m x nb x (n + 1)
+  arma::cube fast_smoother_block(const arma::mat& y_sim, const arma::vec& Ft, 
+    const arma::mat& Kt, const arma::cube& Lt) const;
   // fast smoothing which returns also Ft, Kt, and Lt
   arma::mat fast_precomputing_smoother(arma::vec& Ft, arma::mat& Kt, 
     arma::cube& Lt) const;
+  // as above but computes also the log-likelihood
+  arma::mat fast_precomputing_smoother(arma::vec& Ft, arma::mat& Kt, 
+    arma::cube& Lt, double& loglik) const;
   // smoothing which also returns covariances cov(alpha_t, alpha_t-1)
   void smoother_ccov(arma::mat& at, arma::cube& Pt, arma::cube& ccov) const;
   double filter(arma::mat& at, arma::mat& att, arma::cube& Pt,
@@ -67,12 +92,14 @@ public:
   // simulation smoothing usin twisted smc
   void psi_filter(const unsigned int nsim, arma::cube& alpha);
  
-  Rcpp::List predict_interval(const arma::vec& probs, const arma::mat& theta,
-    const arma::mat& alpha, const arma::uvec& counts, const unsigned int predict_type);
-  arma::cube predict_sample(const arma::mat& theta,
-    const arma::mat& alpha, const arma::uvec& counts, const unsigned int predict_type
-    , const unsigned int nsim);
-  arma::mat sample_model(const unsigned int predict_type, const unsigned int nsim);
+  // means, standard deviations and quantiles of the predictive distribution, 
+  // with a single slice unless the states are predicted (predict_type 3)
+  void predict_interval(const arma::vec& probs, const arma::mat& theta,
+    const arma::mat& alpha, const arma::uvec& counts, const unsigned int predict_type,
+    arma::cube& intv, arma::cube& mean_pred, arma::cube& sd_pred,
+    const unsigned int n_threads = 1);
+  arma::cube sample_model(const arma::vec& a1_sim, const unsigned int predict_type, 
+    const unsigned int nsim, sitmo::prng_engine& draw_engine) const;
   
   arma::vec y;
   arma::mat Z;
@@ -100,6 +127,9 @@ public:
   arma::vec HH;
   arma::cube RR;
   arma::vec xbeta;
+  // structure of T used in the Kalman recursions, which must be recomputed 
+  // with compute_T_structure whenever T, RR or P1 are modified
+  T_structure T_struct;
   sitmo::prng_engine engine;
   const double zero_tol;
   
@@ -108,6 +138,10 @@ public:
   const arma::mat prior_parameters;
 
 private:
+  // simulate block of unconditional states and observations for simulation smoother
+  void simulate_unconditional(const unsigned int first_seed, 
+    const arma::mat& L_P1, arma::cube& aplus, arma::mat& yplus) const;
+  
   arma::uvec Z_ind;
   arma::uvec H_ind;
   arma::uvec T_ind;
@@ -14,6 +14,8 @@
 #include "distr_consts.h"
 #include "filter_smoother.h"
 #include "summary.h"
+#include "hooks.h"
+#include "tempering.h"
 
 ung_amcmc::ung_amcmc(const unsigned int n_iter, 
   const unsigned int n_burnin, const unsigned int n_thin, const unsigned int n, 
@@ -44,11 +46,15 @@ void ung_amcmc::trim_storage() {
     y_storage.resize(y_storage.n_rows, n_stored);
     H_storage.resize(H_storage.n_rows, n_stored);
   }
+  approx_index = arma::linspace<arma::uvec>(0, n_stored - 1, n_stored);
 }
 
 void ung_amcmc::expand() {
   //trim extras first just in case
   trim_storage();
+  // the approximating models are shared by the copies of each draw, 
+  // so only their indices are expanded
+  approx_index = rep_uvec(approx_index, count_storage);
   n_stored = arma::accu(count_storage);
   
   arma::mat expanded_theta = rep_mat(theta_storage, count_storage);
@@ -67,33 +73,65 @@ void ung_amcmc::expand() {
   prior_storage.set_size(n_stored);
   prior_storage = expanded_prior;
   
-  count_storage.resize(n_stored);
-  count_storage.ones();
-  
   arma::vec expanded_approx_loglik = rep_vec(approx_loglik_storage, count_storage);
   approx_loglik_storage.set_size(n_stored);
   approx_loglik_storage = expanded_approx_loglik;
   
+  count_storage.resize(n_stored);
+  count_storage.ones();
+  
   if (output_type == 1) {
-    arma::cube expanded_alpha = rep_cube(alpha_storage, count_storage);
+    // the states are simulated separately for each copy in IS correction, 
+    // so there is no need to copy the approximate ones
     alpha_storage.set_size(alpha_storage.n_rows, alpha_storage.n_cols, n_stored);
-    alpha_storage = expanded_alpha;
   }
+}
+
+namespace {
+// Starting point of the mode search of the local approximation at theta. 
+// It must be a function of theta only, as otherwise the approximate 
+// likelihood (and thus the stationary distribution of the chain corrected 
+// by the IS weights) would depend on the history of the chain. 
+// Uses the first-order predictor mode(theta0) + D (theta - theta0) 
+// around the initial theta0, where the derivative D of the mode with 
+// respect to theta is computed once by finite differences.
+template <class T>
+class mode_predictor {
   
-  if (store_modes) {
-  arma::mat expanded_scales = rep_mat(scales_storage, count_storage);
-  scales_storage.set_size(scales_storage.n_rows, n_stored);
-  scales_storage = expanded_scales;
-  
-  arma::mat expanded_y = rep_mat(y_storage, count_storage);
-  y_storage.set_size(y_storage.n_rows, n_stored);
-  y_storage = expanded_y;
+public:
   
-  arma::mat expanded_H = rep_mat(H_storage, count_storage);
-  H_storage.set_size(H_storage.n_rows, n_stored);
-  H_storage = expanded_H;
+  mode_predictor(T model, ugg_ssm approx_model, const arma::vec& mode,
+    const unsigned int max_iter, const double conv_tol) :
+    theta0(model.theta), mode0(mode), 
+    D(arma::mat(mode.n_elem, model.theta.n_elem, arma::fill::zeros)) {
+    
+    // without iterations there is no mode search to start
+    for (unsigned int j = 0; max_iter > 0 && j < theta0.n_elem; j++) {
+      arma::vec theta = theta0;
+      double h = 1e-3 * std::max(1.0, std::abs(theta0(j)));
+      theta(j) += h;
+      model.update_model(theta);
+      arma::vec mode_j = mode0;
+      model.approximate(approx_model, mode_j, max_iter, conv_tol);
+      if (mode_j.is_finite()) {
+        D.col(j) = (mode_j - mode0) / h;
+      }
+    }
+  }
   
+  arma::vec predict(const arma::vec& theta) const {
+    arma::vec mode = mode0 + D * (theta - theta0);
+    if (!mode.is_finite()) {
+      mode = mode0;
+    }
+    return mode;
   }
+  
+private:
+  const arma::vec theta0;
+  const arma::vec mode0;
+  arma::mat D;
+};
 }
 
 // run approximate MCMC for
@@ -120,7 +158,7 @@ void ung_amcmc::approx_mcmc(T model, const bool end_ram, const bool local_approx
   // compute the log[p(theta)]
   double logprior = model.log_prior_pdf(theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    stop_error("Initial prior probability is not finite.");
   }
   // construct the approximate Gaussian model
   arma::vec mode_estimate = initial_mode;
@@ -138,13 +176,16 @@ void ung_amcmc::approx_mcmc(T model, const bool end_ram, const bool local_approx
   // log-likelihood approximation
   double approx_loglik = gaussian_loglik + const_term + sum_scales;
   if (!std::isfinite(approx_loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    stop_error("Initial log-likelihood is not finite.");
   double acceptance_prob = 0.0;
   std::normal_distribution<> normal(0.0, 1.0);
   std::uniform_real_distribution<> unif(0.0, 1.0);
   arma::vec scales_prop = scales;
   arma::vec approx_y = approx_model.y;
   arma::vec approx_H = approx_model.H;
+  // starting points of the mode search are predicted from theta
+  const mode_predictor<T> predictor(model, approx_model, mode_estimate, 
+    local_approx ? max_iter : 0, conv_tol);
   
   bool new_value = true;
   unsigned int n_values = 0;
@@ -152,7 +193,7 @@ void ung_amcmc::approx_mcmc(T model, const bool end_ram, const bool local_approx
   for (unsigned int i = 1; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -170,13 +211,15 @@ void ung_amcmc::approx_mcmc(T model, const bool end_ram, const bool local_approx
       // update parameters
       model.update_model(theta_prop);
       
+      profiler.start();
       if (local_approx) {
         // construct the approximate Gaussian model
-        mode_estimate = initial_mode;
-        model.approximate(approx_model, mode_estimate, max_iter, conv_tol);
+        // starting from the mode predicted from theta_prop
+        mode_estimate = predictor.predict(theta_prop);
+        gaussian_loglik = model.approximate(approx_model, mode_estimate, max_iter, conv_tol);
         
       } else {
-        model.approximate(approx_model, mode_estimate, 0, conv_tol);
+        gaussian_loglik = model.approximate(approx_model, mode_estimate, 0, conv_tol);
         
       }
       // compute unnormalized mode-based correction terms
@@ -185,9 +228,8 @@ void ung_amcmc::approx_mcmc(T model, const bool end_ram, const bool local_approx
       sum_scales = arma::accu(scales_prop);
       // compute the constant term (not really a constant in all cases, bad name!)
       const_term = compute_const_term(model, approx_model);
-      // compute the log-likelihood of the approximate model
-      // we could (should) extract this from fast_smoother used in approximation
-      gaussian_loglik = approx_model.log_likelihood();
+      profiler.stop(mcmc_profiler::approximation);
+      profiler.add_approx_iter(model.approx_iter);
       double approx_loglik_prop = gaussian_loglik + const_term + sum_scales;
       
       acceptance_prob = std::min(1.0, std::exp(approx_loglik_prop - approx_loglik +
@@ -206,8 +248,12 @@ void ung_amcmc::approx_mcmc(T model, const bool end_ram, const bool local_approx
         approx_H = approx_model.H;
         new_value = true;
       }
-    } else acceptance_prob = 0.0;
+    } else {
+      acceptance_prob = 0.0;
+      profiler.add_rejection();
+    }
     
+    profiler.start();
     if (i > n_burnin && n_values % n_thin == 0) {
       //new block
       if (new_value) {
@@ -226,6 +272,7 @@ void ung_amcmc::approx_mcmc(T model, const bool end_ram, const bool local_approx
         count_storage(n_stored - 1)++;
       }
     }
+    profiler.stop(mcmc_profiler::storage);
     
     
     if (!end_ram || i <= n_burnin) {
@@ -237,6 +284,220 @@ void ung_amcmc::approx_mcmc(T model, const bool end_ram, const bool local_approx
   acceptance_rate /= (n_iter - n_burnin);
 }
 
+namespace {
+// state of a single replica in parallel tempering, 
+// exchanged between the replicas in swap moves
+struct approx_state {
+  arma::vec theta;
+  double logprior;
+  double approx_loglik;
+  arma::vec scales;
+  arma::vec approx_y;
+  arma::vec approx_H;
+};
+}
+
+// run approximate MCMC with parallel tempering
+// Replica r targets p(theta) ^p(y | theta)^beta_r, where ^p(y | theta) is the 
+// approximate likelihood of approx_mcmc and beta_0 = 1 for the cold chain. 
+// The replicas are updated in parallel, each with its own copy of the model, 
+// approximating model, random number stream and adaptive proposal, 
+// after which swaps between adjacent replicas are proposed. 
+// Only the cold chain is stored.
+template void ung_amcmc::approx_pt_mcmc(ung_ssm model, const bool end_ram,
+  const bool local_approx, const arma::vec& initial_mode,
+  const unsigned int max_iter, const double conv_tol, const unsigned int n_temps, 
+  const double max_temp, const unsigned int n_threads);
+template void ung_amcmc::approx_pt_mcmc(ung_bsm model, const bool end_ram,
+  const bool local_approx, const arma::vec& initial_mode,
+  const unsigned int max_iter, const double conv_tol, const unsigned int n_temps, 
+  const double max_temp, const unsigned int n_threads);
+template void ung_amcmc::approx_pt_mcmc(ung_svm model, const bool end_ram,
+  const bool local_approx, const arma::vec& initial_mode,
+  const unsigned int max_iter, const double conv_tol, const unsigned int n_temps, 
+  const double max_temp, const unsigned int n_threads);
+template void ung_amcmc::approx_pt_mcmc(ung_ar1 model, const bool end_ram,
+  const bool local_approx, const arma::vec& initial_mode,
+  const unsigned int max_iter, const double conv_tol, const unsigned int n_temps, 
+  const double max_temp, const unsigned int n_threads);
+
+template<class T>
+void ung_amcmc::approx_pt_mcmc(T model, const bool end_ram, const bool local_approx,
+  const arma::vec& initial_mode, const unsigned int max_iter, const double conv_tol, 
+  const unsigned int n_temps, const double max_temp, const unsigned int n_threads) {
+  
+  if (n_temps < 2) {
+    stop_error("Parallel tempering needs at least two temperatures.");
+  }
+  tempering ladder(n_temps, max_temp);
+  
+  // all replicas start from the initial theta
+  approx_state initial;
+  initial.theta = model.theta;
+  initial.logprior = model.log_prior_pdf(initial.theta);
+  if (!arma::is_finite(initial.logprior)) {
+    stop_error("Initial prior probability is not finite.");
+  }
+  arma::vec mode_estimate = initial_mode;
+  ugg_ssm approx_model = model.approximate(mode_estimate, max_iter, conv_tol);
+  initial.scales = model.scaling_factors(approx_model, mode_estimate);
+  initial.approx_loglik = approx_model.log_likelihood() + 
+    compute_const_term(model, approx_model) + arma::accu(initial.scales);
+  if (!std::isfinite(initial.approx_loglik))
+    stop_error("Initial log-likelihood is not finite.");
+  initial.approx_y = approx_model.y;
+  initial.approx_H = approx_model.H;
+  // starting points of the mode search are predicted from theta
+  const mode_predictor<T> predictor(model, approx_model, mode_estimate, 
+    local_approx ? max_iter : 0, conv_tol);
+  
+  std::vector<approx_state> state(n_temps, initial);
+  std::vector<T> models(n_temps, model);
+  std::vector<ugg_ssm> approx_models(n_temps, approx_model);
+  std::vector<arma::vec> mode_estimates(n_temps, mode_estimate);
+  
+  // each replica uses its own RNG stream keyed by the common seed, 
+  // so the results do not depend on the number of threads used
+  std::uniform_int_distribution<> unif_seed(0, std::numeric_limits<int>::max());
+  const unsigned int base_seed = unif_seed(model.engine);
+  std::vector<sitmo::prng_engine> engines;
+  engines.reserve(n_temps);
+  for (unsigned int r = 0; r < n_temps; r++) {
+    engines.emplace_back(base_seed + r);
+  }
+  
+  std::vector<arma::mat> S_r(n_temps, S);
+  std::vector<arma::vec> u(n_temps, arma::vec(n_par));
+  arma::vec acceptance_prob(n_temps);
+  arma::uvec accepted(n_temps);
+  arma::uvec prior_finite(n_temps);
+  arma::vec approx_loglik(n_temps);
+  
+  bool new_value = true;
+  unsigned int n_values = 0;
+  
+  for (unsigned int i = 1; i <= n_iter; i++) {
+    
+    if (i % 16 == 0) {
+      check_interrupt();
+    }
+    
+    profiler.start();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads) if(n_threads > 1)
+#endif
+    for (unsigned int r = 0; r < n_temps; r++) {
+      
+      std::normal_distribution<> normal(0.0, 1.0);
+      std::uniform_real_distribution<> unif(0.0, 1.0);
+      
+      for(unsigned int j = 0; j < n_par; j++) {
+        u[r](j) = normal(engines[r]);
+      }
+      arma::vec theta_prop = state[r].theta + S_r[r] * u[r];
+      double logprior_prop = models[r].log_prior_pdf(theta_prop);
+      accepted(r) = 0;
+      prior_finite(r) = logprior_prop > -std::numeric_limits<double>::infinity() && 
+        !std::isnan(logprior_prop);
+      
+      if (prior_finite(r)) {
+        models[r].update_model(theta_prop);
+        double gaussian_loglik;
+        if (local_approx) {
+          mode_estimates[r] = predictor.predict(theta_prop);
+          gaussian_loglik = models[r].approximate(approx_models[r], 
+            mode_estimates[r], max_iter, conv_tol);
+        } else {
+          gaussian_loglik = models[r].approximate(approx_models[r], 
+            mode_estimates[r], 0, conv_tol);
+        }
+        arma::vec scales_prop = 
+          models[r].scaling_factors(approx_models[r], mode_estimates[r]);
+        double approx_loglik_prop = gaussian_loglik + 
+          compute_const_term(models[r], approx_models[r]) + arma::accu(scales_prop);
+        
+        acceptance_prob(r) = std::min(1.0, 
+          std::exp(ladder.beta(r) * (approx_loglik_prop - state[r].approx_loglik) +
+          logprior_prop - state[r].logprior + 
+          models[r].log_proposal_ratio(theta_prop, state[r].theta)));
+        
+        if (unif(engines[r]) < acceptance_prob(r)) {
+          accepted(r) = 1;
+          state[r].approx_loglik = approx_loglik_prop;
+          state[r].logprior = logprior_prop;
+          state[r].theta = theta_prop;
+          state[r].scales = scales_prop;
+          state[r].approx_y = approx_models[r].y;
+          state[r].approx_H = approx_models[r].H;
+        }
+      } else {
+        acceptance_prob(r) = 0.0;
+      }
+      if (!end_ram || i <= n_burnin) {
+        ramcmc::adapt_S(S_r[r], u[r], acceptance_prob(r), target_acceptance, i, gamma);
+      }
+    }
+    profiler.stop(mcmc_profiler::approximation);
+    
+    // counters of the cold chain
+    if (prior_finite(0)) {
+      profiler.add_approx_iter(models[0].approx_iter);
+    } else {
+      profiler.add_rejection();
+    }
+    if (accepted(0)) {
+      if (i > n_burnin) {
+        acceptance_rate++;
+        n_values++;
+      }
+      new_value = true;
+    }
+    
+    // exchange the states of the accepted pairs
+    for (unsigned int r = 0; r < n_temps; r++) {
+      approx_loglik(r) = state[r].approx_loglik;
+    }
+    arma::uvec swapped = ladder.swap(approx_loglik, model.engine);
+    for (unsigned int r : swapped) {
+      std::swap(state[r], state[r + 1]);
+      if (r == 0) {
+        if (i > n_burnin && !accepted(0)) {
+          n_values++;
+        }
+        new_value = true;
+      }
+    }
+    if (!end_ram || i <= n_burnin) {
+      ladder.adapt(i, gamma);
+    }
+    
+    profiler.start();
+    if (i > n_burnin && n_values % n_thin == 0) {
+      //new block
+      if (new_value) {
+        approx_loglik_storage(n_stored) = state[0].approx_loglik;
+        theta_storage.col(n_stored) = state[0].theta;
+        if (store_modes) {
+          y_storage.col(n_stored) = state[0].approx_y;
+          H_storage.col(n_stored) = state[0].approx_H;
+          scales_storage.col(n_stored) = state[0].scales;
+        }
+        prior_storage(n_stored) = state[0].logprior;
+        count_storage(n_stored) = 1;
+        n_stored++;
+        new_value = false;
+      } else {
+        count_storage(n_stored - 1)++;
+      }
+    }
+    profiler.stop(mcmc_profiler::storage);
+  }
+  
+  S = S_r[0];
+  trim_storage();
+  acceptance_rate /= (n_iter - n_burnin);
+}
+
 // approximate MCMC
 
 template void ung_amcmc::is_correction_psi(ung_ssm model, const unsigned int nsim_states, 
@@ -252,6 +513,7 @@ template <class T>
 void ung_amcmc::is_correction_psi(T model, const unsigned int nsim_states, 
   const unsigned int is_type, const unsigned int n_threads) {
   
+  profiler.start();
   arma::cube Valpha(model.m, model.m, model.n + 1, arma::fill::zeros);
   double sum_w = 0.0;
   
@@ -278,9 +540,10 @@ void ung_amcmc::is_correction_psi(T model, const unsigned int nsim_states,
     approx_model.C = model.C;
     approx_model.RR = model.RR;
     approx_model.xbeta = model.xbeta;
-    approx_model.y = y_storage.col(i);
-    approx_model.H = H_storage.col(i);
+    approx_model.y = y_storage.col(approx_index(i));
+    approx_model.H = H_storage.col(approx_index(i));
     approx_model.compute_HH();
+    approx_model.compute_T_structure();
     
     unsigned int nsim = nsim_states;
     if (is_type == 1) {
@@ -291,8 +554,8 @@ void ung_amcmc::is_correction_psi(T model, const unsigned int nsim_states,
     arma::mat weights_i(nsim, model.n + 1);
     arma::umat indices(nsim, model.n);
     
-    double loglik = model.psi_filter(approx_model, 0, scales_storage.col(i),
-      nsim, alpha_i, weights_i, indices);
+    double loglik = model.psi_filter(approx_model, 0, 
+      scales_storage.col(approx_index(i)), nsim, alpha_i, weights_i, indices);
     
     weight_storage(i) = std::exp(loglik);
     if (output_type != 3) {
@@ -337,9 +600,10 @@ for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
   approx_model.C = model.C;
   approx_model.RR = model.RR;
   approx_model.xbeta = model.xbeta;
-  approx_model.y = y_storage.col(i);
-  approx_model.H = H_storage.col(i);
+  approx_model.y = y_storage.col(approx_index(i));
+  approx_model.H = H_storage.col(approx_index(i));
   approx_model.compute_HH();
+  approx_model.compute_T_structure();
   
   unsigned int nsim = nsim_states;
   if (is_type == 1) {
@@ -349,8 +613,8 @@ for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
   arma::cube alpha_i(model.m, model.n + 1, nsim);
   arma::mat weights_i(nsim, model.n + 1);
   arma::umat indices(nsim, model.n);
-  double loglik = model.psi_filter(approx_model, 0, scales_storage.col(i),
-    nsim, alpha_i, weights_i, indices);
+  double loglik = model.psi_filter(approx_model, 0, 
+    scales_storage.col(approx_index(i)), nsim, alpha_i, weights_i, indices);
   
   weight_storage(i) = std::exp(loglik);
   if (output_type != 3) {
@@ -382,6 +646,7 @@ if (output_type == 2) {
 }
 posterior_storage = prior_storage + approx_loglik_storage + 
   arma::log(weight_storage);
+  profiler.stop(mcmc_profiler::is_correction);
 }
 
 template void ung_amcmc::is_correction_bsf(ung_ssm model, 
@@ -401,6 +666,7 @@ template <class T>
 void ung_amcmc::is_correction_bsf(T model, const unsigned int nsim_states, 
   const unsigned int is_type, const unsigned int n_threads) {
   
+  profiler.start();
   arma::cube Valpha(model.m, model.m, model.n + 1, arma::fill::zeros);
   double sum_w = 0.0;
   
@@ -496,6 +762,7 @@ if (output_type == 2) {
   Vt += Valpha / theta_storage.n_cols; // Var[E(alpha)] + E[Var(alpha)]
 }
 posterior_storage = prior_storage + arma::log(weight_storage);
+profiler.stop(mcmc_profiler::is_correction);
 }
 
 template void ung_amcmc::is_correction_spdk(ung_ssm model, unsigned int nsim_states, 
@@ -511,6 +778,7 @@ template <class T>
 void ung_amcmc::is_correction_spdk(T model, const unsigned int nsim_states, 
   const unsigned int is_type, const unsigned int n_threads) {
   
+  profiler.start();
   arma::cube Valpha(model.m, model.m, model.n + 1, arma::fill::zeros);
   double sum_w = 0.0;
   
@@ -537,9 +805,10 @@ void ung_amcmc::is_correction_spdk(T model, const unsigned int nsim_states,
     approx_model.C = model.C;
     approx_model.RR = model.RR;
     approx_model.xbeta = model.xbeta;
-    approx_model.y = y_storage.col(i);
-    approx_model.H = H_storage.col(i);
+    approx_model.y = y_storage.col(approx_index(i));
+    approx_model.H = H_storage.col(approx_index(i));
     approx_model.compute_HH();
+    approx_model.compute_T_structure();
     
     unsigned int nsim = nsim_states;
     if (is_type == 1) {
@@ -548,7 +817,7 @@ void ung_amcmc::is_correction_spdk(T model, const unsigned int nsim_states,
     
     arma::cube alpha_i = approx_model.simulate_states(nsim, true);
     arma::vec weights_i = model.importance_weights(approx_model, alpha_i);
-    weights_i = arma::exp(weights_i - arma::accu(scales_storage.col(i)));
+    weights_i = arma::exp(weights_i - arma::accu(scales_storage.col(approx_index(i))));
     weight_storage(i) = arma::mean(weights_i);
     if (output_type != 3) {
       if (output_type == 1) {
@@ -591,9 +860,10 @@ for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
   approx_model.C = model.C;
   approx_model.RR = model.RR;
   approx_model.xbeta = model.xbeta;
-  approx_model.y = y_storage.col(i);
-  approx_model.H = H_storage.col(i);
+  approx_model.y = y_storage.col(approx_index(i));
+  approx_model.H = H_storage.col(approx_index(i));
   approx_model.compute_HH();
+  approx_model.compute_T_structure();
   
   unsigned int nsim = nsim_states;
   if (is_type == 1) {
@@ -602,7 +872,7 @@ for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
   
   arma::cube alpha_i = approx_model.simulate_states(nsim, true);
   arma::vec weights_i = model.importance_weights(approx_model, alpha_i);
-  weights_i = arma::exp(weights_i - arma::accu(scales_storage.col(i)));
+  weights_i = arma::exp(weights_i - arma::accu(scales_storage.col(approx_index(i))));
   if (output_type != 3) {
     if (output_type == 1) {
       std::discrete_distribution<unsigned int> sample(weights_i.begin(), weights_i.end());
@@ -629,6 +899,7 @@ if (output_type == 2) {
 }
 posterior_storage = prior_storage + approx_loglik_storage + 
   arma::log(weight_storage);
+  profiler.stop(mcmc_profiler::is_correction);
 }
 
 template void ung_amcmc::approx_state_posterior(ung_ssm model, const unsigned int n_threads);
@@ -639,6 +910,7 @@ template void ung_amcmc::approx_state_posterior(ung_ar1 model, const unsigned in
 template <class T>
 void ung_amcmc::approx_state_posterior(T model, const unsigned int n_threads) {
   
+  profiler.start();
 #ifdef _OPENMP
 #pragma omp parallel num_threads(n_threads) default(shared) firstprivate(model) 
 {
@@ -662,9 +934,10 @@ void ung_amcmc::approx_state_posterior(T model, const unsigned int n_threads) {
     approx_model.C = model.C;
     approx_model.RR = model.RR;
     approx_model.xbeta = model.xbeta;
-    approx_model.y = y_storage.col(i);
-    approx_model.H = H_storage.col(i);
+    approx_model.y = y_storage.col(approx_index(i));
+    approx_model.H = H_storage.col(approx_index(i));
     approx_model.compute_HH();
+    approx_model.compute_T_structure();
     alpha_storage.slice(i) = approx_model.simulate_states(1).slice(0).t();
   }
 }
@@ -685,12 +958,14 @@ for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
   approx_model.C = model.C;
   approx_model.RR = model.RR;
   approx_model.xbeta = model.xbeta;
-  approx_model.y = y_storage.col(i);
-  approx_model.H = H_storage.col(i);
+  approx_model.y = y_storage.col(approx_index(i));
+  approx_model.H = H_storage.col(approx_index(i));
   approx_model.compute_HH();
+  approx_model.compute_T_structure();
   alpha_storage.slice(i) = approx_model.simulate_states(1).slice(0).t();
 }
 #endif
 
+  profiler.stop(mcmc_profiler::smoothing);
 }
 
@@ -20,6 +20,12 @@ public:
   template<class T>
   void approx_mcmc(T model, const bool end_ram, const bool local_approx, 
     const arma::vec& initial_mode, const unsigned int max_iter, const double conv_tol);
+  // approximate mcmc with parallel tempering, n_temps replicas are updated 
+  // in parallel using n_threads and only the cold chain is stored
+  template<class T>
+  void approx_pt_mcmc(T model, const bool end_ram, const bool local_approx, 
+    const arma::vec& initial_mode, const unsigned int max_iter, const double conv_tol, 
+    const unsigned int n_temps, const double max_temp, const unsigned int n_threads);
   
   template <class T>
   void is_correction_psi(T model, const unsigned int nsim_states, 
@@ -48,6 +54,9 @@ private:
   arma::vec approx_loglik_storage;
   arma::vec prior_storage;
   const bool store_modes;
+  // column of y_storage, H_storage and scales_storage corresponding to 
+  // each draw, differs from 0, 1, ... only after expand()
+  arma::uvec approx_index;
 };
 
 
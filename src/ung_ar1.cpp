@@ -1,9 +1,11 @@
 #include "ung_ar1.h"
 
+#ifndef BSSM_STANDALONE
 // from Rcpp::List
 ung_ar1::ung_ar1(const Rcpp::List& model, const unsigned int seed) :
   ung_ssm(model, seed), mu_est(Rcpp::as<bool>(model["mu_est"])) {
 }
+#endif
 
 void ung_ar1::update_model(const arma::vec& new_theta) {
   
@@ -19,7 +21,7 @@ void ung_ar1::update_model(const arma::vec& new_theta) {
   compute_RR();
   
   if(phi_est) {
-    phi = new_theta(2 + mu_est);
+    set_phi(new_theta(2 + mu_est));
   }
   
   if(xreg.n_cols > 0) {
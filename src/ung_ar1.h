@@ -7,7 +7,9 @@ class ung_ar1: public ung_ssm {
   
 public:
   
+#ifndef BSSM_STANDALONE
   ung_ar1(const Rcpp::List& model, const unsigned int seed);
+#endif
   
   // update model given the parameters theta
   void update_model(const arma::vec& new_theta);
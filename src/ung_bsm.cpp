@@ -1,5 +1,6 @@
 #include "ung_bsm.h"
 
+#ifndef BSSM_STANDALONE
 // from Rcpp::List
 ung_bsm::ung_bsm(const Rcpp::List& model, const unsigned int seed) :
   ung_ssm(model, seed), slope(Rcpp::as<bool>(model["slope"])),
@@ -8,6 +9,7 @@ ung_bsm::ung_bsm(const Rcpp::List& model, const unsigned int seed) :
   fixed(Rcpp::as<arma::uvec>(model["fixed"])), level_est(fixed(0) == 0),
   slope_est(slope && fixed(1) == 0), seasonal_est(seasonal && fixed(2) == 0) {
 }
+#endif
 
 void ung_bsm::update_model(const arma::vec& new_theta) {
 
@@ -34,7 +36,7 @@ void ung_bsm::update_model(const arma::vec& new_theta) {
     compute_RR();
   }
   if(phi_est) {
-    phi = std::exp(new_theta(level_est + slope_est + seasonal_est + noise));
+    set_phi(std::exp(new_theta(level_est + slope_est + seasonal_est + noise)));
   }
 
   if(xreg.n_cols > 0) {
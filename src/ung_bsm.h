@@ -7,7 +7,9 @@ class ung_bsm: public ung_ssm {
 
 public:
 
+#ifndef BSSM_STANDALONE
   ung_bsm(const Rcpp::List& model, const unsigned int seed);
+#endif
 
   // update model given the parameters theta
   void update_model(const arma::vec& new_theta);
@@ -3,8 +3,40 @@
 #include "conditional_dist.h"
 #include "distr_consts.h"
 #include "sample.h"
-#include "rep_mat.h"
+#include "psd_chol.h"
+#include "hooks.h"
 
+// unnormalized log-density log[g(y | signal)] of a single observation,
+// distribution is a template parameter so that the switch is resolved at
+// compile time when called inside the loops over particles
+template <unsigned int distribution>
+inline double log_obs_pdf(const double y, const double signal, 
+  const double u, const double phi) {
+  switch(distribution) {
+  case 0:
+    return -0.5 * (signal + std::pow(y / phi, 2.0) * std::exp(-signal));
+  case 1:
+    return y * signal - u * std::exp(signal);
+  case 2:
+    return y * signal - u * std::log1p(std::exp(signal));
+  case 3:
+    return y * signal - (y + phi) * std::log(phi + u * std::exp(signal));
+  }
+  return 0.0;
+}
+
+// log[g(y | signal_i)] for a vector of signals (particles)
+template <unsigned int distribution>
+void log_obs_pdf(const double y, const arma::vec& signal, const double u, 
+  const double phi, arma::vec& out) {
+  const double* s = signal.memptr();
+  double* o = out.memptr();
+  for (unsigned int i = 0; i < signal.n_elem; i++) {
+    o[i] = log_obs_pdf<distribution>(y, s[i], u, phi);
+  }
+}
+
+#ifndef BSSM_STANDALONE
 // General constructor of ung_ssm object from Rcpp::List
 // with parameter indices
 ung_ssm::ung_ssm(const Rcpp::List& model, const unsigned int seed,
@@ -22,14 +54,41 @@ ung_ssm::ung_ssm(const Rcpp::List& model, const unsigned int seed,
   phi(model["phi"]),
   u(Rcpp::as<arma::vec>(model["u"])), distribution(model["distribution"]),
   phi_est(Rcpp::as<bool>(model["phi_est"])), max_iter(100), conv_tol(1.0e-8),
-  theta(Rcpp::as<arma::vec>(model["theta"])), 
+  theta(Rcpp::as<arma::vec>(model["theta"])), approx_iter(0),
   prior_distributions(Rcpp::as<arma::uvec>(model["prior_distributions"])), 
   prior_parameters(Rcpp::as<arma::mat>(model["prior_parameters"])),
-  Z_ind(Z_ind), T_ind(T_ind), R_ind(R_ind) {
+  Z_ind(Z_ind), T_ind(T_ind), R_ind(R_ind), obs_const(0.0) {
+  if(xreg.n_cols > 0) {
+    compute_xbeta();
+  }
+  compute_RR();
+  compute_obs_const();
+}
+#endif
+
+ung_ssm::ung_ssm(const arma::vec& y, const arma::mat& Z, const arma::cube& T, 
+  const arma::cube& R, const arma::vec& a1, const arma::mat& P1, 
+  const double phi, const arma::vec& u, const unsigned int distribution,
+  const arma::mat& xreg, const arma::vec& beta, const arma::vec& D, 
+  const arma::mat& C, const unsigned int seed, const bool phi_est,
+  const arma::vec& theta, const arma::uvec& prior_distributions,
+  const arma::mat& prior_parameters, const arma::uvec& Z_ind, 
+  const arma::uvec& T_ind, const arma::uvec& R_ind) :
+  y(y), Z(Z), T(T), R(R), a1(a1), P1(P1), xreg(xreg), beta(beta), D(D), C(C),
+  Ztv(Z.n_cols > 1), Ttv(T.n_slices > 1), Rtv(R.n_slices > 1), Dtv(D.n_elem > 1),
+  Ctv(C.n_cols > 1),
+  n(y.n_elem), m(a1.n_elem), k(R.n_cols), RR(arma::cube(m, m, Rtv * (n - 1) + 1)),
+  xbeta(arma::vec(n, arma::fill::zeros)), engine(seed), zero_tol(1e-8),
+  phi(phi), u(u), distribution(distribution), phi_est(phi_est), 
+  max_iter(100), conv_tol(1.0e-8), theta(theta), approx_iter(0),
+  prior_distributions(prior_distributions), prior_parameters(prior_parameters),
+  Z_ind(Z_ind), T_ind(T_ind), R_ind(R_ind), obs_const(0.0) {
+  
   if(xreg.n_cols > 0) {
     compute_xbeta();
   }
   compute_RR();
+  compute_obs_const();
 }
 
 void ung_ssm::compute_RR(){
@@ -57,7 +116,7 @@ void ung_ssm::update_model(const arma::vec& new_theta) {
   }
   
   if(phi_est) {
-    phi = new_theta(Z_ind.n_elem + T_ind.n_elem + R_ind.n_elem);
+    set_phi(new_theta(Z_ind.n_elem + T_ind.n_elem + R_ind.n_elem));
   }
   if(xreg.n_cols > 0) {
     beta = new_theta.subvec(new_theta.n_elem - xreg.n_cols, new_theta.n_elem - 1);
@@ -97,6 +156,46 @@ double ung_ssm::log_proposal_ratio(const arma::vec& new_theta, const arma::vec&
 }
 
 
+void ung_ssm::compute_obs_const() {
+  
+  arma::uvec finite_y(find_finite(y));
+  switch(distribution) {
+  case 0 :
+    obs_const = finite_y.n_elem * norm_log_const(phi);
+    break;
+  case 1 :
+    obs_const = poisson_log_const(y(finite_y), u(finite_y));
+    break;
+  case 2 :
+    obs_const = binomial_log_const(y(finite_y), u(finite_y));
+    break;
+  case 3 :
+    obs_const = negbin_log_const(y(finite_y), u(finite_y), phi);
+    break;
+  }
+}
+
+// Poisson and binomial constants do not depend on phi
+void ung_ssm::set_phi(const double new_phi) {
+  
+  if (new_phi != phi) {
+    phi = new_phi;
+    if (distribution == 0 || distribution == 3) {
+      compute_obs_const();
+    }
+  }
+}
+
+void ung_ssm::set_observations(const arma::vec& new_y, const arma::vec& new_u) {
+  
+  if (new_y.n_elem != n || new_u.n_elem != u.n_elem) {
+    stop_error("Dimensions of the new observations do not match the model.");
+  }
+  y = new_y;
+  u = new_u;
+  compute_obs_const();
+}
+
 // given the current guess of mode, compute new values of y and H of
 // approximate model
 /* distribution:
@@ -139,11 +238,9 @@ void ung_ssm::laplace_iter(const arma::vec& signal, arma::vec& approx_y,
 }
 
 // construct an approximating Gaussian model
-// Note the difference to previous versions, the convergence is assessed only
-// by checking the changes in mode, not the actual function values. This is
-// slightly faster and sufficient as the approximation doesn't need to be accurate.
-// Using function values would be safer though, as we could use line search etc
-// in case of potential divergence etc...
+// The mode is found using damped Newton iterations: each Laplace iteration
+// gives a full Newton step for the signal, which is halved until the
+// log-joint density log[p(signal) g(y | signal)] does not decrease.
 ugg_ssm ung_ssm::approximate(arma::vec& mode_estimate, const unsigned int max_iter,
   const double conv_tol) {
   
@@ -157,34 +254,32 @@ ugg_ssm ung_ssm::approximate(arma::vec& mode_estimate, const unsigned int max_it
   const unsigned int new_seed = unif(engine);
   ugg_ssm approx_model(approx_y, Z, approx_H, T, R, a1, P1, xreg, beta, D, C, new_seed);
   
-  unsigned int i = 0;
-  double diff = conv_tol + 1;
-  while(i < max_iter && diff > conv_tol) {
-    i++;
-    //Construct y and H for the Gaussian model
-    laplace_iter(mode_estimate, approx_model.y, approx_model.H);
-    approx_model.compute_HH();
-    // compute new guess of mode
-    arma::vec mode_estimate_new(n);
-    if (distribution == 0) {
-      mode_estimate_new = arma::vectorise(approx_model.fast_smoother().head_cols(n));
-    } else {
-      arma::mat alpha = approx_model.fast_smoother().head_cols(n);
-      for (unsigned int t = 0; t < n; t++) {
-        mode_estimate_new(t) = arma::as_scalar(Z.col(Ztv * t).t() * alpha.col(t));
-      }
-    }
-    diff = arma::mean(arma::square(mode_estimate_new - mode_estimate));
-    mode_estimate = mode_estimate_new;
+  if (max_iter > 0) {
+    approximate(approx_model, mode_estimate, max_iter, conv_tol);
   }
-  
   return approx_model;
 }
 
-//update previously obtained approximation
-void ung_ssm::approximate(ugg_ssm& approx_model, arma::vec& mode_estimate,
+//update previously obtained approximation, returns the log-likelihood of 
+// the approximating model
+double ung_ssm::approximate(ugg_ssm& approx_model, arma::vec& mode_estimate,
   const unsigned int max_iter, const double conv_tol) const {
   
+  arma::mat alphahat(m, n + 1);
+  arma::vec Ft(n);
+  arma::mat Kt(m, n);
+  arma::cube Lt(m, m, n);
+  return approximate(approx_model, mode_estimate, max_iter, conv_tol, 
+    alphahat, Ft, Kt, Lt);
+}
+
+// as above, but returns also the smoothed states and Ft, Kt, and Lt of the 
+// final approximating model which can be reused in simulation smoothing.
+// The log-likelihood is computed during the last smoothing pass 
+double ung_ssm::approximate(ugg_ssm& approx_model, arma::vec& mode_estimate,
+  const unsigned int max_iter, const double conv_tol, arma::mat& alphahat, 
+  arma::vec& Ft, arma::mat& Kt, arma::cube& Lt) const {
+  
   //update model
   approx_model.Z = Z;
   approx_model.T = T;
@@ -196,40 +291,178 @@ void ung_ssm::approximate(ugg_ssm& approx_model, arma::vec& mode_estimate,
   approx_model.C = C;
   approx_model.RR = RR;
   approx_model.xbeta = xbeta;
+  approx_model.compute_T_structure();
   
-  if(max_iter == 0 && mode_estimate.n_elem == n) {
-    if (distribution == 0) {
-      mode_estimate = arma::vectorise(approx_model.fast_smoother().head_cols(n));
-    } else {
-      arma::mat alpha = approx_model.fast_smoother().head_cols(n);
-      for (unsigned int t = 0; t < n; t++) {
-        mode_estimate(t) = arma::as_scalar(Z.col(Ztv * t).t() * alpha.col(t));
+  double loglik = 0.0;
+  approx_iter = 0;
+  if(max_iter == 0) {
+    alphahat = approx_model.fast_precomputing_smoother(Ft, Kt, Lt, loglik);
+    if (mode_estimate.n_elem == n) {
+      if (distribution == 0) {
+        mode_estimate = arma::vectorise(alphahat.head_cols(n));
+      } else {
+        for (unsigned int t = 0; t < n; t++) {
+          mode_estimate(t) = arma::as_scalar(Z.col(Ztv * t).t() * alphahat.col(t));
+        }
       }
     }
+    return loglik;
+  }
+  
+  // log-joint density at the starting point, the constant and the 
+  // quadratic form of the prior of the signal are reused below
+  double log_const;
+  double quad = signal_quadratic(mode_estimate, log_const, approx_model.T_struct);
+  double ll = log_const - 0.5 * quad + log_obs_sum(mode_estimate);
+  if (!mode_estimate.is_finite()) {
+    ll = -std::numeric_limits<double>::infinity();
   }
+  
+  const double LOG2PI = std::log(2.0 * M_PI);
   unsigned int i = 0;
   double diff = conv_tol + 1;
+  double diff_prev = std::numeric_limits<double>::infinity();
   while(i < max_iter && diff > conv_tol) {
     i++;
+    approx_iter = i;
     //Construct y and H for the Gaussian model
     laplace_iter(mode_estimate, approx_model.y, approx_model.H);
     approx_model.compute_HH();
-    // compute new guess of mode
+    // compute new guess of mode (full Newton step)
+    alphahat = approx_model.fast_precomputing_smoother(Ft, Kt, Lt, loglik);
     arma::vec mode_estimate_new(n);
     if (distribution == 0) {
-      mode_estimate_new = arma::vectorise(approx_model.fast_smoother().head_cols(n));
+      mode_estimate_new = arma::vectorise(alphahat.head_cols(n));
     } else {
-      arma::mat alpha = approx_model.fast_smoother().head_cols(n);
       for (unsigned int t = 0; t < n; t++) {
-        mode_estimate_new(t) = arma::as_scalar(Z.col(Ztv * t).t() * alpha.col(t));
+        mode_estimate_new(t) = arma::as_scalar(Z.col(Ztv * t).t() * alphahat.col(t));
       }
     }
     diff = arma::mean(arma::square(mode_estimate_new - mode_estimate));
+    
+    // The prior quadratic form at the smoothed signal is available from the 
+    // smoothing pass as v'F^-1 v - e'H^-1 e, where v are the prediction errors 
+    // and e the residuals of the approximating model, so the objective needs 
+    // no additional Kalman filter pass
+    double quad_new = -2.0 * loglik;
+    for (unsigned int t = 0; t < n; t++) {
+      double y_t = approx_model.y(t) - approx_model.D(t * approx_model.Dtv);
+      if (approx_model.xreg.n_cols > 0) {
+        y_t -= approx_model.xbeta(t);
+      }
+      if (arma::is_finite(y_t) && Ft(t) > approx_model.zero_tol) {
+        quad_new -= LOG2PI + std::log(Ft(t)) + 
+          std::pow(y_t - mode_estimate_new(t), 2) / approx_model.HH(t);
+      }
+    }
+    double ll_new = log_const - 0.5 * quad_new + log_obs_sum(mode_estimate_new);
+    bool damped = false;
+    if (!(ll_new >= ll)) {
+      // full step decreased the objective, backtrack towards current mode
+      // the quadratic form is quadratic along the step, so only the 
+      // quadratic form of the step itself needs one filter pass
+      arma::vec step = mode_estimate_new - mode_estimate;
+      double step_const;
+      double quad_step = signal_quadratic(step, step_const, approx_model.T_struct, false);
+      double quad_full = quad_new;
+      double step_size = 1.0;
+      unsigned int ii = 0;
+      while (!(ll_new >= ll) && ii < 10) {
+        step_size /= 2.0;
+        mode_estimate_new = mode_estimate + step_size * step;
+        quad_new = (1.0 - step_size) * quad + step_size * quad_full - 
+          step_size * (1.0 - step_size) * quad_step;
+        ll_new = log_const - 0.5 * quad_new + log_obs_sum(mode_estimate_new);
+        ii++;
+      }
+      if (!(ll_new >= ll)) {
+        // no improvement found, keep the current mode which matches 
+        // the current approximating model
+        break;
+      }
+      damped = true;
+    }
     mode_estimate = mode_estimate_new;
+    double rel_diff = std::abs(ll_new - ll) / std::abs(ll);
+    ll = ll_new;
+    quad = quad_new;
+    
+    // Newton iterations converge quadratically near the mode, so the next 
+    // change is predicted as diff^3 / diff_prev^2 (using squared differences);
+    // stop already if that or the relative change of the objective is small
+    if (!damped && i > 1 && diff < diff_prev &&
+      (std::pow(diff, 3) / std::pow(diff_prev, 2) < conv_tol || rel_diff < conv_tol)) {
+      break;
+    }
+    diff_prev = diff;
   }
+  return loglik;
+}
+
+
+// unnormalized log-joint density log[p(signal)] + log[g(y | signal)] 
+// used as an objective function in approximate
+double ung_ssm::log_joint_pdf(const arma::vec& signal) const {
   
+  if (!signal.is_finite()) {
+    return -std::numeric_limits<double>::infinity();
+  }
+  double log_const;
+  double quad = signal_quadratic(signal, log_const, T_structure(T, RR, P1));
+  return log_const - 0.5 * quad + log_obs_sum(signal);
 }
 
+// computed by Kalman filter with zero observation noise, so that 
+// log[p(signal)] = log_const - 0.5 * quadratic form
+double ung_ssm::signal_quadratic(const arma::vec& signal, double& log_const, 
+  const T_structure& T_struct, const bool centered) const {
+  
+  const double LOG2PI = std::log(2.0 * M_PI);
+  double quad = 0.0;
+  log_const = 0.0;
+  arma::vec at(m, arma::fill::zeros);
+  if (centered) {
+    at = a1;
+  }
+  arma::mat Pt = P1;
+  const structured_T Ts(T, T_struct);
+  for (unsigned int t = 0; t < n; t++) {
+    double F = arma::as_scalar(Z.col(t * Ztv).t() * Pt * Z.col(t * Ztv));
+    if (F > zero_tol) {
+      double v = signal(t) - arma::as_scalar(Z.col(t * Ztv).t() * at);
+      arma::vec K = Pt * Z.col(t * Ztv) / F;
+      at = Ts.mult(t, at + K * v);
+      Pt = arma::symmatu(Ts.sandwich(t, Pt - K * K.t() * F) + RR.slice(t * Rtv));
+      log_const -= 0.5 * (LOG2PI + std::log(F));
+      quad += v * v / F;
+    } else {
+      at = Ts.mult(t, at);
+      Pt = arma::symmatu(Ts.sandwich(t, Pt) + RR.slice(t * Rtv));
+    }
+    if (centered) {
+      at += C.col(t * Ctv);
+    }
+  }
+  return quad;
+}
+
+double ung_ssm::log_obs_sum(const arma::vec& signal) const {
+  
+  if (!signal.is_finite()) {
+    return -std::numeric_limits<double>::infinity();
+  }
+  double ll = 0.0;
+  for(unsigned int t = 0; t < n; t++) {
+    if (arma::is_finite(y(t))) {
+      if (distribution == 0) {
+        ll += log_obs_density(t, signal(t));
+      } else {
+        ll += log_obs_density(t, signal(t) + xbeta(t));
+      }
+    }
+  }
+  return ll;
+}
 
 // psi particle filter using Gaussian approximation //
 
@@ -349,40 +582,9 @@ arma::vec ung_ssm::log_weights(const ugg_ssm& approx_model,
   arma::vec weights(alpha.n_slices, arma::fill::zeros);
   
   if (arma::is_finite(y(t))) {
-    switch(distribution) {
-    case 0  :
-      for (unsigned int i = 0; i < alpha.n_slices; i++) {
-        double simsignal = alpha(0, t, i);
-        weights(i) = -0.5 * (simsignal + std::pow(y(t) / phi, 2.0) * std::exp(-simsignal)) +
-          0.5 * std::pow((approx_model.y(t) - simsignal) / approx_model.H(t), 2.0);
-      }
-      break;
-    case 1  :
-      for (unsigned int i = 0; i < alpha.n_slices; i++) {
-        double simsignal = arma::as_scalar(Z.col(t * Ztv).t() *
-          alpha.slice(i).col(t) + xbeta(t));
-        weights(i) = y(t) * simsignal  - u(t) * std::exp(simsignal) +
-          0.5 * std::pow((approx_model.y(t) - simsignal) / approx_model.H(t), 2.0);
-      }
-      break;
-    case 2  :
-      for (unsigned int i = 0; i < alpha.n_slices; i++) {
-        double simsignal = arma::as_scalar(Z.col(t * Ztv).t() *
-          alpha.slice(i).col(t) + xbeta(t));
-        weights(i) = y(t) * simsignal - u(t) * std::log1p(std::exp(simsignal)) +
-          0.5 * std::pow((approx_model.y(t) - simsignal) / approx_model.H(t), 2.0);
-      }
-      break;
-    case 3  :
-      for (unsigned int i = 0; i < alpha.n_slices; i++) {
-        double simsignal = arma::as_scalar(Z.col(t * Ztv).t() *
-          alpha.slice(i).col(t) + xbeta(t));
-        weights(i) = y(t) * simsignal - (y(t) + phi) *
-          std::log(phi + u(t) * std::exp(simsignal)) +
-          0.5 * std::pow((approx_model.y(t) - simsignal) / approx_model.H(t), 2.0);
-      }
-      break;
-    }
+    arma::vec simsignal = particle_signals(t, alpha);
+    weights = log_obs_density(t, simsignal) +
+      0.5 * arma::square((approx_model.y(t) - simsignal) / approx_model.H(t));
   }
   return weights;
 }
@@ -394,44 +596,15 @@ arma::vec ung_ssm::scaling_factors(const ugg_ssm& approx_model,
   
   arma::vec weights(n, arma::fill::zeros);
   
-  switch(distribution) {
-  case 0  :
-    for(unsigned int t = 0; t < n; t++) {
-      if (arma::is_finite(y(t))) {
-        weights(t) = -0.5 * (mode_estimate(t) + std::pow(y(t) / phi, 2.0) *
-          std::exp(-mode_estimate(t))) +
-          0.5 * std::pow((approx_model.y(t) - mode_estimate(t)) / approx_model.H(t), 2.0);
-      }
-    }
-    break;
-  case 1  :
-    for(unsigned int t = 0; t < n; t++) {
-      if (arma::is_finite(y(t))) {
-        weights(t) = y(t) * (mode_estimate(t) + xbeta(t)) -
-          u(t) * std::exp(mode_estimate(t) + xbeta(t)) +
-          0.5 * std::pow((approx_model.y(t) - (mode_estimate(t) + xbeta(t))) / approx_model.H(t), 2.0);
-      }
-    }
-    break;
-  case 2  :
-    for(unsigned int t = 0; t < n; t++) {
-      if (arma::is_finite(y(t))) {
-        weights(t) = y(t) * (mode_estimate(t) + xbeta(t)) -
-          u(t) * std::log1p(std::exp(mode_estimate(t) + xbeta(t))) +
-          0.5 * std::pow((approx_model.y(t) - (mode_estimate(t) + xbeta(t))) / approx_model.H(t), 2.0);
-      }
-    }
-    break;
-  case 3  :
-    for(unsigned int t = 0; t < n; t++) {
-      if (arma::is_finite(y(t))) {
-        weights(t) = y(t) * (mode_estimate(t) + xbeta(t)) -
-          (y(t) + phi) *
-          std::log(phi + u(t) * std::exp(mode_estimate(t) + xbeta(t))) +
-          0.5 * std::pow((approx_model.y(t) - (mode_estimate(t) + xbeta(t))) / approx_model.H(t), 2.0);
-      }
+  arma::vec signal = mode_estimate;
+  if (distribution != 0) {
+    signal += xbeta;
+  }
+  for(unsigned int t = 0; t < n; t++) {
+    if (arma::is_finite(y(t))) {
+      weights(t) = log_obs_density(t, signal(t)) +
+        0.5 * std::pow((approx_model.y(t) - signal(t)) / approx_model.H(t), 2.0);
     }
-    break;
   }
   
   return weights;
@@ -448,40 +621,74 @@ arma::vec ung_ssm::log_obs_density(const unsigned int t,
   arma::vec weights(alpha.n_slices, arma::fill::zeros);
   
   if (arma::is_finite(y(t))) {
-    switch(distribution) {
-    case 0  :
-      for (unsigned int i = 0; i < alpha.n_slices; i++) {
-        double simsignal = alpha(0, t, i);
-        weights(i) = -0.5 * (simsignal + std::pow(y(t) / phi, 2.0) * std::exp(-simsignal));
-      }
-      break;
-    case 1  :
-      for (unsigned int i = 0; i < alpha.n_slices; i++) {
-        double simsignal = arma::as_scalar(Z.col(t * Ztv).t() *
-          alpha.slice(i).col(t) + xbeta(t));
-        weights(i) = y(t) * simsignal  - u(t) * std::exp(simsignal);
-      }
-      break;
-    case 2  :
-      for (unsigned int i = 0; i < alpha.n_slices; i++) {
-        double simsignal = arma::as_scalar(Z.col(t * Ztv).t() *
-          alpha.slice(i).col(t) + xbeta(t));
-        weights(i) = y(t) * simsignal - u(t) * std::log1p(std::exp(simsignal));
-      }
-      break;
-    case 3  :
-      for (unsigned int i = 0; i < alpha.n_slices; i++) {
-        double simsignal = arma::as_scalar(Z.col(t * Ztv).t() *
-          alpha.slice(i).col(t) + xbeta(t));
-        weights(i) = y(t) * simsignal - (y(t) + phi) *
-          std::log(phi + u(t) * std::exp(simsignal));
+    weights = log_obs_density(t, particle_signals(t, alpha));
+  }
+  return weights;
+}
+
+// signals Z_t'alpha_t + xbeta_t (alpha_1t for SV model) of all particles 
+// at time t, computed directly from the columns of the particle slices
+arma::vec ung_ssm::particle_signals(const unsigned int t, 
+  const arma::cube& alpha) const {
+  
+  arma::vec signal(alpha.n_slices);
+  if (distribution == 0) {
+    for (unsigned int i = 0; i < alpha.n_slices; i++) {
+      signal(i) = alpha(0, t, i);
+    }
+  } else {
+    const double* z = Z.colptr(t * Ztv);
+    for (unsigned int i = 0; i < alpha.n_slices; i++) {
+      const double* a = alpha.slice_colptr(i, t);
+      double tmp = xbeta(t);
+      for (unsigned int j = 0; j < m; j++) {
+        tmp += z[j] * a[j];
       }
-      break;
+      signal(i) = tmp;
     }
   }
+  return signal;
+}
+
+// log[g(y_t | signal_i)] for all signals, the distribution is 
+// dispatched once outside the loop over the signals
+arma::vec ung_ssm::log_obs_density(const unsigned int t, 
+  const arma::vec& signal) const {
+  
+  arma::vec weights(signal.n_elem);
+  switch(distribution) {
+  case 0  :
+    log_obs_pdf<0>(y(t), signal, u(t), phi, weights);
+    break;
+  case 1  :
+    log_obs_pdf<1>(y(t), signal, u(t), phi, weights);
+    break;
+  case 2  :
+    log_obs_pdf<2>(y(t), signal, u(t), phi, weights);
+    break;
+  case 3  :
+    log_obs_pdf<3>(y(t), signal, u(t), phi, weights);
+    break;
+  }
   return weights;
 }
 
+// log[g(y_t | signal)] for a single signal value
+double ung_ssm::log_obs_density(const unsigned int t, const double signal) const {
+  
+  switch(distribution) {
+  case 0  :
+    return log_obs_pdf<0>(y(t), signal, u(t), phi);
+  case 1  :
+    return log_obs_pdf<1>(y(t), signal, u(t), phi);
+  case 2  :
+    return log_obs_pdf<2>(y(t), signal, u(t), phi);
+  case 3  :
+    return log_obs_pdf<3>(y(t), signal, u(t), phi);
+  }
+  return 0.0;
+}
+
 double ung_ssm::bsf_filter(const unsigned int nsim, arma::cube& alpha,
   arma::mat& weights, arma::umat& indices) {
   
@@ -561,69 +768,101 @@ double ung_ssm::bsf_filter(const unsigned int nsim, arma::cube& alpha,
     }
   }
   // constant part of the log-likelihood
-  switch(distribution) {
-  case 0 :
-    loglik += arma::uvec(arma::find_finite(y)).n_elem * norm_log_const(phi);
-    break;
-  case 1 : {
-      arma::uvec finite_y(find_finite(y));
-      loglik += poisson_log_const(y(finite_y), u(finite_y));
-    } break;
-  case 2 : {
-    arma::uvec finite_y(find_finite(y));
-    loglik += binomial_log_const(y(finite_y), u(finite_y));
-  } break;
-  case 3 : {
-    arma::uvec finite_y(find_finite(y));
-    loglik += negbin_log_const(y(finite_y), u(finite_y), phi);
-  } break;
-  }
+  loglik += log_obs_const();
   return loglik;
 }
 
-arma::cube ung_ssm::predict_sample(const arma::mat& theta_posterior,
-  const arma::mat& alpha, const arma::uvec& counts,
-  const unsigned int predict_type, const unsigned int nsim) {
+// bootstrap filter for new observations y given particles alpha (m x nsim)
+// from the predictive distribution of the first state, if alpha is empty the 
+// particles are sampled from N(a1, P1). On exit alpha contains the (equally 
+// weighted) particles of the predictive distribution of the next state, or 
+// is unchanged if the filter fails and -Inf is returned
+double ung_ssm::bsf_update(const unsigned int nsim, arma::mat& alpha) {
+  // the particles are written back to alpha only if the whole batch is 
+  // filtered successfully
+  arma::mat particles = alpha;
   
-  unsigned int d = 1;
-  if (predict_type == 3) d = m;
-  
-
-  arma::mat expanded_theta = rep_mat(theta_posterior, counts);
-
-  arma::mat expanded_alpha = rep_mat(alpha, counts);
+  std::normal_distribution<> normal(0.0, 1.0);
+  if (particles.n_cols == 0) {
+    particles.set_size(m, nsim);
+    arma::mat L_P1 = psd_chol(P1);
+    for (unsigned int i = 0; i < nsim; i++) {
+      arma::vec um(m);
+      for(unsigned int j = 0; j < m; j++) {
+        um(j) = normal(engine);
+      }
+      particles.col(i) = a1 + L_P1 * um;
+    }
+  } 
+  if (particles.n_rows != m || particles.n_cols != nsim) {
+    stop_error("Dimensions of the particle matrix do not match the model.");
+  }
   
-
-  unsigned int n_samples = expanded_theta.n_cols;
-  arma::cube sample(d, n, nsim * n_samples);
+  std::uniform_real_distribution<> unif(0.0, 1.0);
+  arma::vec normalized_weights(nsim);
+  arma::vec signal(nsim);
+  double loglik = 0.0;
   
- 
-  for (unsigned int i = 0; i < n_samples; i++) {
-    update_model(expanded_theta.col(i));
-    a1 = expanded_alpha.col(i);
-    sample.slices(i * nsim, (i + 1) * nsim - 1) =
-      sample_model(predict_type, nsim);
+  for (unsigned int t = 0; t < n; t++) {
     
+    if (arma::is_finite(y(t))) {
+      if (distribution == 0) {
+        signal = particles.row(0).t();
+      } else {
+        signal = particles.t() * Z.col(t * Ztv) + xbeta(t);
+      }
+      arma::vec weights = log_obs_density(t, signal);
+      double max_weight = weights.max();
+      weights = arma::exp(weights - max_weight);
+      double sum_weights = arma::accu(weights);
+      if(sum_weights > 0.0){
+        normalized_weights = weights / sum_weights;
+      } else {
+        return -std::numeric_limits<double>::infinity();
+      }
+      loglik += max_weight + std::log(sum_weights / nsim);
+    } else {
+      normalized_weights.fill(1.0 / nsim);
+    }
+    
+    arma::vec r(nsim);
+    for (unsigned int i = 0; i < nsim; i++) {
+      r(i) = unif(engine);
+    }
+    arma::uvec indices = stratified_sample(normalized_weights, r, nsim);
+    arma::mat alphatmp = particles.cols(indices);
+    
+    for (unsigned int i = 0; i < nsim; i++) {
+      arma::vec uk(k);
+      for(unsigned int j = 0; j < k; j++) {
+        uk(j) = normal(engine);
+      }
+      particles.col(i) = C.col(t * Ctv) +
+        T.slice(t * Ttv) * alphatmp.col(i) + R.slice(t * Rtv) * uk;
+    }
   }
-  
-  return sample;
+  // constant part of the log-likelihood
+  loglik += log_obs_const();
+  alpha = particles;
+  return loglik;
 }
 
-
-arma::mat ung_ssm::sample_model(const unsigned int predict_type,
-  const unsigned int nsim) {
+// simulate nsim future paths starting from a1_sim using the given RNG
+arma::cube ung_ssm::sample_model(const arma::vec& a1_sim, 
+  const unsigned int predict_type, const unsigned int nsim, 
+  sitmo::prng_engine& draw_engine) const {
   
   arma::cube alpha(m, n, nsim);
   std::normal_distribution<> normal(0.0, 1.0);
   
   for (unsigned int i = 0; i < nsim; i++) {
     
-    alpha.slice(i).col(0) = a1;
+    alpha.slice(i).col(0) = a1_sim;
     
     for (unsigned int t = 0; t < (n - 1); t++) {
       arma::vec uk(k);
       for(unsigned int j = 0; j < k; j++) {
-        uk(j) = normal(engine);
+        uk(j) = normal(draw_engine);
       }
       alpha.slice(i).col(t + 1) =
         C.col(t * Ctv) + T.slice(t * Ttv) * alpha.slice(i).col(t) +
@@ -675,7 +914,7 @@ arma::mat ung_ssm::sample_model(const unsigned int predict_type,
           for (unsigned int t = 0; t < n; t++) {
             std::poisson_distribution<> poisson(u(t) * y(0, t, i));
             if ((u(t) * y(0, t, i)) < poisson.max()) {
-              y(0, t, i) = poisson(engine);
+              y(0, t, i) = poisson(draw_engine);
             } else {
               y(0, t, i) = std::numeric_limits<double>::quiet_NaN();
             }
@@ -686,7 +925,7 @@ arma::mat ung_ssm::sample_model(const unsigned int predict_type,
         for (unsigned int i = 0; i < nsim; i++) {
           for (unsigned int t = 0; t < n; t++) {
             std::binomial_distribution<> binomial(u(t), y(0, t, i));
-            y(0, t, i) = binomial(engine);
+            y(0, t, i) = binomial(draw_engine);
           }
         }
         break;
@@ -695,7 +934,7 @@ arma::mat ung_ssm::sample_model(const unsigned int predict_type,
           for (unsigned int t = 0; t < n; t++) {
             std::negative_binomial_distribution<>
             negative_binomial(phi, phi / (phi + u(t) * y(0, t, i)));
-            y(0, t, i) = negative_binomial(engine);
+            y(0, t, i) = negative_binomial(draw_engine);
           }
         }
         break;
@@ -6,6 +6,7 @@
 
 #include <sitmo.h>
 #include "bssm.h"
+#include "structured_T.h"
 
 class ugg_ssm;
 
@@ -13,12 +14,28 @@ class ung_ssm {
   
 public:
   
+#ifndef BSSM_STANDALONE
   // constructor from Rcpp::List
   ung_ssm(const Rcpp::List& model, 
     const unsigned int seed = 1, 
     const arma::uvec& Z_ind = arma::uvec(),
     const arma::uvec& T_ind = arma::uvec(), 
     const arma::uvec& R_ind = arma::uvec());
+#endif
+  
+  // constructor from armadillo objects
+  ung_ssm(const arma::vec& y, const arma::mat& Z, const arma::cube& T, 
+    const arma::cube& R, const arma::vec& a1, const arma::mat& P1, 
+    const double phi, const arma::vec& u, const unsigned int distribution,
+    const arma::mat& xreg, const arma::vec& beta, const arma::vec& D, 
+    const arma::mat& C, const unsigned int seed = 1, 
+    const bool phi_est = false,
+    const arma::vec& theta = arma::vec(),
+    const arma::uvec& prior_distributions = arma::uvec(),
+    const arma::mat& prior_parameters = arma::mat(), 
+    const arma::uvec& Z_ind = arma::uvec(),
+    const arma::uvec& T_ind = arma::uvec(), 
+    const arma::uvec& R_ind = arma::uvec());
   
   // update model
   virtual void update_model(const arma::vec& new_theta);
@@ -29,19 +46,31 @@ public:
   // compute covariance matrices RR and regression part
   void compute_RR();
   void compute_xbeta() { xbeta = xreg * beta; }
+  // compute the constant of the observation densities, log_obs_const
+  void compute_obs_const();
+  // set phi or the observations y and u, recomputing the constant of the 
+  // observation densities when it depends on them
+  void set_phi(const double new_phi);
+  void set_observations(const arma::vec& new_y, const arma::vec& new_u);
   
   // compute y and H of the approximating Gaussian model
   void laplace_iter(const arma::vec& mode_estimate, arma::vec& approx_y, 
     arma::vec& approx_H) const;
+  // log[p(signal)] + log[g(y | signal)] (up to a constant), objective of approximate
+  double log_joint_pdf(const arma::vec& signal) const;
   // find the approximating Gaussian model
   // not const as advances RNG in order to generate random seed for 
   // approximating model
   ugg_ssm approximate(arma::vec& mode_estimate, const unsigned int max_iter, 
     const double conv_tol);
   
-  // update aproximating Gaussian model
-  void approximate(ugg_ssm& approx_model, arma::vec& mode_estimate, 
+  // update aproximating Gaussian model, returns its log-likelihood
+  double approximate(ugg_ssm& approx_model, arma::vec& mode_estimate, 
     const unsigned int max_iter, const double conv_tol) const;
+  // as above but returns also smoothed states and Ft, Kt, Lt for simulation smoothing
+  double approximate(ugg_ssm& approx_model, arma::vec& mode_estimate, 
+    const unsigned int max_iter, const double conv_tol, arma::mat& alphahat, 
+    arma::vec& Ft, arma::mat& Kt, arma::cube& Lt) const;
   // psi-particle filter
   double psi_filter(const ugg_ssm& approx_model,
     const double approx_loglik, const arma::vec& scales,
@@ -61,16 +90,24 @@ public:
   // log[g(y_t | ^alpha_t) / ~g(y_t | ^alpha_t)]
   arma::vec scaling_factors(const ugg_ssm& approx_model, const arma::vec& mode_estimate) const;
   
+  // constant part of log[g(y | signal)] summed over the observed time points
+  double log_obs_const() const { return obs_const; }
   // compute logarithms of _unnormalized_ densities g(y_t | alpha_t)
   arma::vec log_obs_density(const unsigned int t, const arma::cube& alphasim) const;
+  // g(y_t | signal) for vector of signals, and for a single signal
+  arma::vec log_obs_density(const unsigned int t, const arma::vec& signal) const;
+  double log_obs_density(const unsigned int t, const double signal) const;
+  // compute signals Z_t'alpha_t + xbeta_t of all particles at time t
+  arma::vec particle_signals(const unsigned int t, const arma::cube& alphasim) const;
   // bootstrap filter  
   double bsf_filter(const unsigned int nsim, arma::cube& alphasim, 
       arma::mat& weights, arma::umat& indices);
+  // bootstrap filter continuing from the particles alpha of a previous call
+  double bsf_update(const unsigned int nsim, arma::mat& alpha);
   
-  arma::cube predict_sample(const arma::mat& theta_posterior, const arma::mat& alpha, 
-    const arma::uvec& counts, const unsigned int predict_type, const unsigned int nsim);
-  
-  arma::mat sample_model(const unsigned int predict_type, const unsigned int nsim);
+  // simulate future paths of the states or observations from the model
+  arma::cube sample_model(const arma::vec& a1_sim, const unsigned int predict_type, 
+    const unsigned int nsim, sitmo::prng_engine& draw_engine) const;
   
   arma::vec y;
   arma::mat Z;
@@ -100,6 +137,7 @@ public:
   sitmo::prng_engine engine;
   const double zero_tol;
   
+  // use set_phi and set_observations to modify y, phi and u
   double phi;
   arma::vec u;
   unsigned int distribution;
@@ -107,6 +145,8 @@ public:
   unsigned int max_iter;
   double conv_tol;
   arma::vec theta;
+  // number of iterations used in the latest call of approximate
+  mutable unsigned int approx_iter;
   const arma::uvec prior_distributions;
   const arma::mat prior_parameters;
   
@@ -114,6 +154,17 @@ private:
   arma::uvec Z_ind;
   arma::uvec T_ind;
   arma::uvec R_ind;
+  // value of log_obs_const, which depends only on y, u, and phi
+  double obs_const;
+  
+  // quadratic form (signal - E(signal))' Var(signal)^-1 (signal - E(signal)) 
+  // of the prior of the signal and the log-normalising constant of its density, 
+  // if centered is false, the mean of the signal is taken as zero, 
+  // T_struct is the structure of T, RR, and P1 of the model
+  double signal_quadratic(const arma::vec& signal, double& log_const, 
+    const T_structure& T_struct, const bool centered = true) const;
+  // log[g(y | signal)] summed over the observed time points
+  double log_obs_sum(const arma::vec& signal) const;
 };
 
 
@@ -1,15 +1,17 @@
 #include "ung_svm.h"
 
+#ifndef BSSM_STANDALONE
 // construct SV model from Rcpp::List
 ung_svm::ung_svm(const Rcpp::List& model, const unsigned int seed) :
   ung_ssm(model, seed), svm_type(model["svm_type"]) {
 }
+#endif
 
 // update model given the parameters theta
 void ung_svm::update_model(const arma::vec& new_theta) {
 
   if(svm_type == 0) {
-    phi = new_theta(2);
+    set_phi(new_theta(2));
   } else {
     a1(0) = new_theta(2);
     C.fill(new_theta(2) * (1.0 - new_theta(0)));
@@ -0,0 +1,99 @@
+// Damped local linear trend model with an observation intercept, 
+// used in the tests of lgg_ssm
+// theta(0) = standard deviation sigma_y
+// theta(1) = standard deviation sigma_level
+// theta(2) = standard deviation sigma_slope
+// theta(3) = damping factor of the slope
+// theta(4) = observation intercept
+
+#include <RcppArmadillo.h>
+// [[Rcpp::depends(RcppArmadillo)]]
+// [[Rcpp::interfaces(r, cpp)]]
+
+// [[Rcpp::export]]
+arma::vec a1_fn(const arma::vec& theta, const arma::vec& known_params) {
+  return arma::vec(2, arma::fill::zeros);
+}
+// [[Rcpp::export]]
+arma::mat P1_fn(const arma::vec& theta, const arma::vec& known_params) {
+  arma::mat P1(2, 2, arma::fill::zeros);
+  P1(0, 0) = 100;
+  P1(1, 1) = 1;
+  return P1;
+}
+// [[Rcpp::export]]
+arma::mat H_fn(const unsigned int t, const arma::vec& theta, 
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  arma::mat H(1, 1);
+  H(0, 0) = theta(0);
+  return H;
+}
+// [[Rcpp::export]]
+arma::mat R_fn(const unsigned int t, const arma::vec& theta, 
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  arma::mat R(2, 2, arma::fill::zeros);
+  R(0, 0) = theta(1);
+  R(1, 1) = theta(2);
+  return R;
+}
+// [[Rcpp::export]]
+arma::mat Z_fn(const unsigned int t, const arma::vec& theta, 
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  arma::mat Z(1, 2, arma::fill::zeros);
+  Z(0, 0) = 1.0;
+  return Z;
+}
+// [[Rcpp::export]]
+arma::mat T_fn(const unsigned int t, const arma::vec& theta, 
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  arma::mat T(2, 2, arma::fill::ones);
+  T(1, 0) = 0.0;
+  T(1, 1) = theta(3);
+  return T;
+}
+// [[Rcpp::export]]
+arma::vec C_fn(const unsigned int t, const arma::vec& theta, 
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  return arma::vec(2, arma::fill::zeros);
+}
+// [[Rcpp::export]]
+arma::vec D_fn(const unsigned int t, const arma::vec& theta, 
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  return arma::vec(1).fill(theta(4));
+}
+// [[Rcpp::export]]
+double log_prior_pdf(const arma::vec& theta) {
+  
+  double log_pdf = -std::numeric_limits<double>::infinity();
+  if (arma::all(theta.head(3) >= 0) && std::abs(theta(3)) < 1) {
+    log_pdf = 0.0;
+    for (unsigned int i = 0; i < theta.n_elem; i++) {
+      log_pdf += R::dnorm(theta(i), 0, 10, 1);
+    }
+  }
+  return log_pdf;
+}
+
+// [[Rcpp::export]]
+Rcpp::List create_xptrs() {
+  
+  typedef arma::mat (*lmat_fnPtr)(const unsigned int t, const arma::vec& theta, 
+    const arma::vec& known_params, const arma::mat& known_tv_params);
+  typedef arma::vec (*lvec_fnPtr)(const unsigned int t, const arma::vec& theta, 
+    const arma::vec& known_params, const arma::mat& known_tv_params);
+  typedef arma::vec (*a1_fnPtr)(const arma::vec& theta, const arma::vec& known_params);
+  typedef arma::mat (*P1_fnPtr)(const arma::vec& theta, const arma::vec& known_params);
+  typedef double (*prior_fnPtr)(const arma::vec&);
+  
+  return Rcpp::List::create(
+    Rcpp::Named("a1_fn") = Rcpp::XPtr<a1_fnPtr>(new a1_fnPtr(&a1_fn)),
+    Rcpp::Named("P1_fn") = Rcpp::XPtr<P1_fnPtr>(new P1_fnPtr(&P1_fn)),
+    Rcpp::Named("Z_fn") = Rcpp::XPtr<lmat_fnPtr>(new lmat_fnPtr(&Z_fn)),
+    Rcpp::Named("H_fn") = Rcpp::XPtr<lmat_fnPtr>(new lmat_fnPtr(&H_fn)),
+    Rcpp::Named("T_fn") = Rcpp::XPtr<lmat_fnPtr>(new lmat_fnPtr(&T_fn)),
+    Rcpp::Named("R_fn") = Rcpp::XPtr<lmat_fnPtr>(new lmat_fnPtr(&R_fn)),
+    Rcpp::Named("D_fn") = Rcpp::XPtr<lvec_fnPtr>(new lvec_fnPtr(&D_fn)),
+    Rcpp::Named("C_fn") = Rcpp::XPtr<lvec_fnPtr>(new lvec_fnPtr(&C_fn)),
+    Rcpp::Named("log_prior_pdf") = 
+      Rcpp::XPtr<prior_fnPtr>(new prior_fnPtr(&log_prior_pdf)));
+}
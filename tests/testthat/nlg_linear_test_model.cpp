@@ -0,0 +1,102 @@
+// AR(1) signal observed with noise, used in the tests of nlg_ssm
+// theta(0) = standard deviation sigma_y
+// theta(1) = standard deviation sigma_x
+// theta(2) = autoregressive coefficient phi
+// known_params(0) = c, the observation noise is sigma_y * exp(c * alpha / 2),
+//   so that the model is linear-Gaussian when c = 0
+// known_params(1) = prior variance of alpha_1
+// known_params(2) = optional slope b of a linear trend b * t in the signal
+// known_params(3) = optional d, the state equation is phi * alpha + d * sin(alpha)
+
+#include <RcppArmadillo.h>
+// [[Rcpp::depends(RcppArmadillo)]]
+// [[Rcpp::interfaces(r, cpp)]]
+
+// [[Rcpp::export]]
+arma::vec a1_fn(const arma::vec& theta, const arma::vec& known_params) {
+  return arma::vec(1, arma::fill::zeros);
+}
+// [[Rcpp::export]]
+arma::mat P1_fn(const arma::vec& theta, const arma::vec& known_params) {
+  arma::mat P1(1, 1);
+  P1(0, 0) = known_params(1);
+  return P1;
+}
+// [[Rcpp::export]]
+arma::mat H_fn(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  arma::mat H(1, 1);
+  H(0, 0) = theta(0) * std::exp(0.5 * known_params(0) * alpha(0));
+  return H;
+}
+// [[Rcpp::export]]
+arma::mat R_fn(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  arma::mat R(1, 1);
+  R(0, 0) = theta(1);
+  return R;
+}
+// [[Rcpp::export]]
+arma::vec Z_fn(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  if (known_params.n_elem > 2) {
+    return alpha + known_params(2) * t;
+  }
+  return alpha;
+}
+// [[Rcpp::export]]
+arma::mat Z_gn(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  return arma::mat(1, 1, arma::fill::ones);
+}
+// [[Rcpp::export]]
+arma::vec T_fn(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  if (known_params.n_elem > 3) {
+    return theta(2) * alpha + known_params(3) * arma::sin(alpha);
+  }
+  return theta(2) * alpha;
+}
+// [[Rcpp::export]]
+arma::mat T_gn(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  arma::mat Tg(1, 1);
+  Tg(0, 0) = theta(2);
+  if (known_params.n_elem > 3) {
+    Tg(0, 0) += known_params(3) * std::cos(alpha(0));
+  }
+  return Tg;
+}
+// [[Rcpp::export]]
+double log_prior_pdf(const arma::vec& theta) {
+
+  double log_pdf = -std::numeric_limits<double>::infinity();
+  if (theta(0) >= 0 && theta(1) >= 0 && std::abs(theta(2)) < 1) {
+    log_pdf = R::dnorm(theta(0), 0, 10, 1) + R::dnorm(theta(1), 0, 10, 1);
+  }
+  return log_pdf;
+}
+
+// [[Rcpp::export]]
+Rcpp::List create_xptrs() {
+
+  typedef arma::vec (*nvec_fnPtr)(const unsigned int t, const arma::vec& alpha,
+    const arma::vec& theta, const arma::vec& known_params, const arma::mat& known_tv_params);
+  typedef arma::mat (*nmat_fnPtr)(const unsigned int t, const arma::vec& alpha,
+    const arma::vec& theta, const arma::vec& known_params, const arma::mat& known_tv_params);
+  typedef arma::vec (*a1_fnPtr)(const arma::vec& theta, const arma::vec& known_params);
+  typedef arma::mat (*P1_fnPtr)(const arma::vec& theta, const arma::vec& known_params);
+  typedef double (*prior_fnPtr)(const arma::vec&);
+
+  return Rcpp::List::create(
+    Rcpp::Named("a1_fn") = Rcpp::XPtr<a1_fnPtr>(new a1_fnPtr(&a1_fn)),
+    Rcpp::Named("P1_fn") = Rcpp::XPtr<P1_fnPtr>(new P1_fnPtr(&P1_fn)),
+    Rcpp::Named("Z_fn") = Rcpp::XPtr<nvec_fnPtr>(new nvec_fnPtr(&Z_fn)),
+    Rcpp::Named("H_fn") = Rcpp::XPtr<nmat_fnPtr>(new nmat_fnPtr(&H_fn)),
+    Rcpp::Named("T_fn") = Rcpp::XPtr<nvec_fnPtr>(new nvec_fnPtr(&T_fn)),
+    Rcpp::Named("R_fn") = Rcpp::XPtr<nmat_fnPtr>(new nmat_fnPtr(&R_fn)),
+    Rcpp::Named("Z_gn") = Rcpp::XPtr<nmat_fnPtr>(new nmat_fnPtr(&Z_gn)),
+    Rcpp::Named("T_gn") = Rcpp::XPtr<nmat_fnPtr>(new nmat_fnPtr(&T_gn)),
+    Rcpp::Named("log_prior_pdf") =
+      Rcpp::XPtr<prior_fnPtr>(new prior_fnPtr(&log_prior_pdf)));
+}
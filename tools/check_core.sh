@@ -0,0 +1,53 @@
+#!/bin/sh
+# Build check of the numerical core without R: compiles all sources except 
+# the R_*.cpp adapters and RcppExports.cpp with -DBSSM_STANDALONE against 
+# plain Armadillo, and archives them into $BUILD_DIR/libbssm_core.a.
+#
+# Header-only dependencies are searched from ARMA_INCLUDE, BH_INCLUDE, 
+# SITMO_INCLUDE and RAMCMC_INCLUDE, by default from the installed R packages 
+# when Rscript is available. ramcmc.h includes RcppArmadillo.h, which is 
+# mapped to <armadillo> here, so any remaining use of Rcpp in the core 
+# fails to compile.
+#
+# Usage: tools/check_core.sh (from the package root)
+
+set -e
+
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:-"-O2 -std=c++11 -fopenmp"}
+BUILD_DIR=${BUILD_DIR:-_core_build}
+
+r_include() {
+  if command -v Rscript > /dev/null 2>&1; then
+    Rscript -e "cat(system.file('include', package = '$1'))"
+  fi
+}
+
+SITMO_INCLUDE=${SITMO_INCLUDE:-$(r_include sitmo)}
+RAMCMC_INCLUDE=${RAMCMC_INCLUDE:-$(r_include ramcmc)}
+BH_INCLUDE=${BH_INCLUDE:-$(r_include BH)}
+
+mkdir -p "$BUILD_DIR/shim"
+printf '#include <armadillo>\n' > "$BUILD_DIR/shim/RcppArmadillo.h"
+
+INCLUDES="-I$BUILD_DIR/shim"
+for dir in "$ARMA_INCLUDE" "$BH_INCLUDE" "$SITMO_INCLUDE" "$RAMCMC_INCLUDE"; do
+  if [ -n "$dir" ]; then
+    INCLUDES="$INCLUDES -I$dir"
+  fi
+done
+
+objects=""
+for src in src/*.cpp; do
+  case "$(basename "$src")" in
+    R_*|RcppExports.cpp) continue ;;
+  esac
+  obj="$BUILD_DIR/$(basename "$src" .cpp).o"
+  echo "$CXX $src"
+  $CXX $CXXFLAGS -DBSSM_STANDALONE $INCLUDES -c "$src" -o "$obj"
+  objects="$objects $obj"
+done
+
+rm -f "$BUILD_DIR/libbssm_core.a"
+ar rcs "$BUILD_DIR/libbssm_core.a" $objects
+echo "built $BUILD_DIR/libbssm_core.a"